@@ -0,0 +1,82 @@
+//! Benchmarks of the stages of the core prover on a single shard, so that a regression can be
+//! traced to execution, the trace generation of a chip, the main commitment or the shard opening.
+
+use criterion::{black_box, criterion_group, criterion_main, BatchSize, BenchmarkId, Criterion};
+use p3_baby_bear::BabyBear;
+use sp1_core::air::MachineAir;
+use sp1_core::runtime::{ExecutionRecord, Program, Runtime};
+use sp1_core::stark::{LocalProver, MachineRecord, RiscvAir, StarkGenericConfig};
+use sp1_core::utils::{BabyBearPoseidon2, SP1CoreOpts};
+
+type CoreProver = LocalProver<BabyBearPoseidon2, RiscvAir<BabyBear>>;
+
+const PROGRAMS: [&str; 3] = ["fibonacci", "keccak-permute", "sha2"];
+
+pub fn stage_benchmarks(c: &mut Criterion) {
+    let opts = SP1CoreOpts::default();
+    for name in PROGRAMS {
+        let elf_path = format!("../tests/{}/elf/riscv32im-succinct-zkvm-elf", name);
+        let program = Program::from_elf(&elf_path);
+        let machine = RiscvAir::machine(BabyBearPoseidon2::new());
+        let (pk, _) = machine.setup(&program);
+
+        let mut runtime = Runtime::new(program.clone(), opts);
+        runtime.run().unwrap();
+        let shards = machine.shard(
+            runtime.record,
+            &<ExecutionRecord as MachineRecord>::Config::default(),
+        );
+        let shard = &shards[0];
+
+        let mut group = c.benchmark_group(format!("stages/{}", name));
+        group.sample_size(10);
+
+        group.bench_function("run_untraced", |b| {
+            b.iter(|| {
+                let mut runtime = Runtime::new(black_box(program.clone()), opts);
+                runtime.run_untraced().unwrap();
+            })
+        });
+        group.bench_function("run", |b| {
+            b.iter(|| {
+                let mut runtime = Runtime::new(black_box(program.clone()), opts);
+                runtime.run().unwrap();
+            })
+        });
+
+        for chip in machine.shard_chips(shard) {
+            group.bench_function(BenchmarkId::new("generate_trace", chip.name()), |b| {
+                b.iter(|| chip.generate_trace(black_box(shard), &mut ExecutionRecord::default()))
+            });
+        }
+
+        group.bench_function("commit_main", |b| {
+            b.iter(|| CoreProver::commit_main(machine.config(), &machine, black_box(shard), 0))
+        });
+
+        let mut challenger = machine.config().challenger();
+        pk.observe_into(&mut challenger);
+        group.bench_function("prove_shard", |b| {
+            b.iter_batched(
+                || CoreProver::commit_main(machine.config(), &machine, shard, 0),
+                |data| {
+                    let ordering = data.chip_ordering.clone();
+                    let chips = machine.shard_chips_ordered(&ordering).collect::<Vec<_>>();
+                    CoreProver::prove_shard(
+                        machine.config(),
+                        &pk,
+                        &chips,
+                        data,
+                        &mut challenger.clone(),
+                    )
+                },
+                BatchSize::PerIteration,
+            )
+        });
+
+        group.finish();
+    }
+}
+
+criterion_group!(benches, stage_benchmarks);
+criterion_main!(benches);
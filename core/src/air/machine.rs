@@ -28,6 +28,15 @@ pub trait MachineAir<F: Field>: BaseAir<F> {
         self.generate_trace(input, output);
     }
 
+    /// The stage in which the dependencies of this AIR are generated.
+    ///
+    /// The dependencies of all AIRs in a stage are generated in parallel, and each stage sees the
+    /// events emitted by the stages before it. An AIR whose events are emitted by the dependencies
+    /// of another AIR must be in a later stage than it.
+    fn dependency_stage(&self) -> usize {
+        0
+    }
+
     /// Whether this execution record contains events for this air.
     fn included(&self, shard: &Self::Record) -> bool;
 
@@ -143,6 +143,11 @@ impl<F: PrimeField> MachineAir<F> for AddSubChip {
         trace
     }
 
+    fn dependency_stage(&self) -> usize {
+        // The events of this chip are also emitted by the CPU and DivRem dependencies.
+        1
+    }
+
     fn included(&self, shard: &Self::Record) -> bool {
         !shard.add_events.is_empty() || !shard.sub_events.is_empty()
     }
@@ -125,6 +125,11 @@ impl<F: PrimeField> MachineAir<F> for BitwiseChip {
         trace
     }
 
+    fn dependency_stage(&self) -> usize {
+        // The events of this chip are also emitted by the CPU and DivRem dependencies.
+        1
+    }
+
     fn included(&self, shard: &Self::Record) -> bool {
         !shard.bitwise_events.is_empty()
     }
@@ -233,6 +233,11 @@ impl<F: PrimeField32> MachineAir<F> for LtChip {
         trace
     }
 
+    fn dependency_stage(&self) -> usize {
+        // The events of this chip are also emitted by the CPU and DivRem dependencies.
+        1
+    }
+
     fn included(&self, shard: &Self::Record) -> bool {
         !shard.lt_events.is_empty()
     }
@@ -283,6 +283,11 @@ impl<F: PrimeField> MachineAir<F> for MulChip {
         trace
     }
 
+    fn dependency_stage(&self) -> usize {
+        // The events of this chip are also emitted by the CPU and DivRem dependencies.
+        1
+    }
+
     fn included(&self, shard: &Self::Record) -> bool {
         !shard.mul_events.is_empty()
     }
@@ -211,6 +211,11 @@ impl<F: PrimeField> MachineAir<F> for ShiftLeft {
         trace
     }
 
+    fn dependency_stage(&self) -> usize {
+        // The events of this chip are also emitted by the CPU and DivRem dependencies.
+        1
+    }
+
     fn included(&self, shard: &Self::Record) -> bool {
         !shard.shift_left_events.is_empty()
     }
@@ -296,6 +296,11 @@ impl<F: PrimeField> MachineAir<F> for ShiftRightChip {
         trace
     }
 
+    fn dependency_stage(&self) -> usize {
+        // The events of this chip are also emitted by the CPU and DivRem dependencies.
+        1
+    }
+
     fn included(&self, shard: &Self::Record) -> bool {
         !shard.shift_right_events.is_empty()
     }
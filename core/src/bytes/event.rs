@@ -3,7 +3,9 @@ use std::collections::BTreeMap;
 use p3_field::PrimeField32;
 use serde::{Deserialize, Serialize};
 
-use super::ByteOpcode;
+use super::trace::NUM_ROWS;
+use super::utils::shr_carry;
+use super::{ByteOpcode, NUM_BYTE_OPS};
 
 /// A byte lookup event.
 #[derive(Debug, Clone, Copy, PartialEq, Eq, PartialOrd, Ord, Hash, Serialize, Deserialize)]
@@ -120,6 +122,30 @@ pub trait ByteRecord {
 }
 
 impl ByteLookupEvent {
+    /// Returns whether the lookup is a row of the byte table, with the outputs of the operation on
+    /// the inputs.
+    pub fn is_in_table(&self) -> bool {
+        if self.opcode == ByteOpcode::U16Range {
+            return self.a1 <= u16::MAX as u32 && self.a2 == 0 && self.b == 0 && self.c == 0;
+        }
+        if self.b > u8::MAX as u32 || self.c > u8::MAX as u32 {
+            return false;
+        }
+        let (b, c) = (self.b as u8, self.c as u8);
+        let (a1, a2) = match self.opcode {
+            ByteOpcode::AND => (b & c, 0),
+            ByteOpcode::OR => (b | c, 0),
+            ByteOpcode::XOR => (b ^ c, 0),
+            ByteOpcode::SLL => (b << (c & 7), 0),
+            ByteOpcode::U8Range => (0, 0),
+            ByteOpcode::ShrCarry => shr_carry(b, c),
+            ByteOpcode::LTU => ((b < c) as u8, 0),
+            ByteOpcode::MSB if c == 0 => (b >> 7, 0),
+            ByteOpcode::MSB | ByteOpcode::U16Range => return false,
+        };
+        (self.a1, self.a2) == (a1 as u32, a2 as u32)
+    }
+
     /// Creates a new `ByteLookupEvent`.
     pub fn new(
         shard: u32,
@@ -148,12 +174,145 @@ impl ByteRecord for Vec<ByteLookupEvent> {
     }
 }
 
-impl ByteRecord for BTreeMap<u32, BTreeMap<ByteLookupEvent, usize>> {
+impl ByteRecord for BTreeMap<u32, ByteLookupCounts> {
     fn add_byte_lookup_event(&mut self, blu_event: ByteLookupEvent) {
-        *self
-            .entry(blu_event.shard)
-            .or_default()
-            .entry(blu_event)
-            .or_insert(0) += 1
+        self.entry(blu_event.shard).or_default().add(&blu_event);
+    }
+}
+
+/// The number of rows of the byte table in a block of counts, which are the rows of one value of
+/// `b`.
+const ROWS_PER_BLOCK: usize = 1 << 8;
+
+/// The number of counters in a block: one per byte operation for every row of the block.
+const BLOCK_LEN: usize = ROWS_PER_BLOCK * NUM_BYTE_OPS;
+
+/// The multiplicities of the byte lookups of a shard.
+///
+/// The counts are kept in a table per channel, indexed by the row of the byte table and then the
+/// opcode, which is the layout of the multiplicity columns of the byte chip. A table is split in
+/// blocks of [ROWS_PER_BLOCK] rows, each allocated on the first lookup into it, so that a channel
+/// with few distinct lookups stays small.
+#[derive(Debug, Clone, Default, Serialize, Deserialize)]
+pub struct ByteLookupCounts {
+    channels: Vec<Vec<Vec<u32>>>,
+}
+
+impl ByteLookupCounts {
+    /// The row of the byte table that holds the result of the lookup.
+    pub const fn row(event: &ByteLookupEvent) -> usize {
+        match event.opcode {
+            ByteOpcode::U16Range => event.a1 as usize,
+            _ => ((event.b as usize) << 8) | event.c as usize,
+        }
+    }
+
+    /// Records one occurrence of the lookup.
+    pub fn add(&mut self, event: &ByteLookupEvent) {
+        debug_assert!(
+            event.is_in_table(),
+            "byte lookup is not in the table: {:?}",
+            event
+        );
+        let channel = event.channel as usize;
+        if self.channels.len() <= channel {
+            self.channels.resize_with(channel + 1, Vec::new);
+        }
+        let row = Self::row(event);
+        let blocks = &mut self.channels[channel];
+        if blocks.is_empty() {
+            blocks.resize_with(NUM_ROWS / ROWS_PER_BLOCK, Vec::new);
+        }
+        let block = &mut blocks[row / ROWS_PER_BLOCK];
+        if block.is_empty() {
+            block.resize(BLOCK_LEN, 0);
+        }
+        block[(row % ROWS_PER_BLOCK) * NUM_BYTE_OPS + event.opcode as usize] += 1;
+    }
+
+    /// The counts of the operations at a row of the byte table for a channel, or `None` if there
+    /// were no lookups near the row.
+    pub fn row_counts(&self, channel: usize, row: usize) -> Option<&[u32]> {
+        let block = self
+            .channels
+            .get(channel)?
+            .get(row / ROWS_PER_BLOCK)
+            .filter(|block| !block.is_empty())?;
+        let start = (row % ROWS_PER_BLOCK) * NUM_BYTE_OPS;
+        Some(&block[start..start + NUM_BYTE_OPS])
+    }
+
+    /// Adds the counts of `other` into `self`. Blocks that are only present in `other` are moved
+    /// instead of added.
+    pub fn merge(&mut self, mut other: Self) {
+        if self.channels.len() < other.channels.len() {
+            self.channels.resize_with(other.channels.len(), Vec::new);
+        }
+        for (blocks, other_blocks) in self.channels.iter_mut().zip(other.channels.iter_mut()) {
+            if blocks.is_empty() {
+                *blocks = std::mem::take(other_blocks);
+                continue;
+            }
+            for (block, other_block) in blocks.iter_mut().zip(other_blocks.iter_mut()) {
+                if other_block.is_empty() {
+                    continue;
+                }
+                if block.is_empty() {
+                    *block = std::mem::take(other_block);
+                    continue;
+                }
+                block
+                    .iter_mut()
+                    .zip(other_block.iter())
+                    .for_each(|(count, other_count)| *count += other_count);
+            }
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use p3_baby_bear::BabyBear;
+
+    use super::*;
+    use crate::bytes::ByteChip;
+
+    #[test]
+    fn test_byte_lookup_counts_match_table() {
+        let (_, event_map) = ByteChip::<BabyBear>::trace_and_map(0);
+        for (event, (row, _)) in event_map.iter() {
+            assert!(event.is_in_table(), "{:?}", event);
+            assert_eq!(ByteLookupCounts::row(event), *row, "{:?}", event);
+        }
+
+        let mut counts = ByteLookupCounts::default();
+        let mut other = ByteLookupCounts::default();
+        for (i, (event, (row, index))) in event_map.iter().enumerate().step_by(997) {
+            counts.add(event);
+            if i % 2 == 0 {
+                other.add(event);
+            }
+            assert_eq!(
+                counts.row_counts(event.channel as usize, *row).unwrap()[*index],
+                1
+            );
+        }
+        counts.merge(other);
+        for (i, (event, (row, index))) in event_map.iter().enumerate().step_by(997) {
+            let expected = if i % 2 == 0 { 2 } else { 1 };
+            let row_counts = counts.row_counts(event.channel as usize, *row).unwrap();
+            assert_eq!(row_counts[*index], expected);
+        }
+    }
+
+    #[test]
+    fn test_byte_lookup_not_in_table() {
+        let event = |opcode, a1, b, c| ByteLookupEvent::new(0, 0, opcode, a1, 0, b, c);
+        assert!(event(ByteOpcode::AND, 0b0100, 0b0110, 0b1100).is_in_table());
+        assert!(!event(ByteOpcode::AND, 0b1110, 0b0110, 0b1100).is_in_table());
+        assert!(!event(ByteOpcode::LTU, 0, 1, 2).is_in_table());
+        assert!(!event(ByteOpcode::MSB, 1, 0x80, 1).is_in_table());
+        assert!(!event(ByteOpcode::U8Range, 0, 256, 0).is_in_table());
+        assert!(!event(ByteOpcode::U16Range, 1 << 16, 0, 0).is_in_table());
     }
 }
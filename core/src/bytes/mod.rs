@@ -5,7 +5,7 @@ pub mod opcode;
 pub mod trace;
 pub mod utils;
 
-pub use event::ByteLookupEvent;
+pub use event::{ByteLookupCounts, ByteLookupEvent};
 pub use opcode::*;
 
 use alloc::collections::BTreeMap;
@@ -135,7 +135,9 @@ impl<F: Field> ByteChip<F> {
                             ByteLookupEvent::new(shard, channel, *opcode, v, 0, 0, 0)
                         }
                     };
-                    event_map.insert(event, (row_index, i));
+                    // The MSB of `b` is looked up with `c = 0`, so the row of the first `c` is
+                    // kept, which is the row that `ByteLookupCounts::row` counts it at.
+                    event_map.entry(event).or_insert((row_index, i));
                 }
             }
         }
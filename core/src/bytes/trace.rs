@@ -2,10 +2,11 @@ use std::borrow::BorrowMut;
 
 use p3_field::Field;
 use p3_matrix::dense::RowMajorMatrix;
+use p3_maybe_rayon::prelude::*;
 
 use super::{
     columns::{ByteMultCols, NUM_BYTE_MULT_COLS, NUM_BYTE_PREPROCESSED_COLS},
-    ByteChip,
+    ByteChip, NUM_BYTE_LOOKUP_CHANNELS,
 };
 use crate::{
     air::MachineAir,
@@ -45,24 +46,38 @@ impl<F: Field> MachineAir<F> for ByteChip<F> {
         _output: &mut ExecutionRecord,
     ) -> RowMajorMatrix<F> {
         let shard = input.index;
-        let (_, event_map) = Self::trace_and_map(shard);
 
         let mut trace = RowMajorMatrix::new(
             vec![F::zero(); NUM_BYTE_MULT_COLS * NUM_ROWS],
             NUM_BYTE_MULT_COLS,
         );
 
-        for (lookup, mult) in input.byte_lookups[&shard].iter() {
-            let (row, index) = event_map[lookup];
-            let channel = lookup.channel as usize;
-            let cols: &mut ByteMultCols<F> = trace.row_mut(row).borrow_mut();
-
-            // Update the trace multiplicity
-            cols.mult_channels[channel].multiplicities[index] += F::from_canonical_usize(*mult);
+        // The counts are laid out like the multiplicity columns, so each row is copied over.
+        let Some(counts) = input.byte_lookups.get(&shard) else {
+            return trace;
+        };
+        trace.par_rows_mut().enumerate().for_each(|(row, values)| {
+            let cols: &mut ByteMultCols<F> = values.borrow_mut();
+            let mut used = false;
+            for channel in 0..NUM_BYTE_LOOKUP_CHANNELS as usize {
+                let Some(row_counts) = counts.row_counts(channel, row) else {
+                    continue;
+                };
+                for (mult, count) in cols.mult_channels[channel]
+                    .multiplicities
+                    .iter_mut()
+                    .zip(row_counts)
+                {
+                    *mult = F::from_canonical_u32(*count);
+                    used |= *count != 0;
+                }
+            }
 
             // Set the shard column as the current shard.
-            cols.shard = F::from_canonical_u32(shard);
-        }
+            if used {
+                cols.shard = F::from_canonical_u32(shard);
+            }
+        });
 
         trace
     }
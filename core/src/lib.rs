@@ -39,4 +39,4 @@ use stark::StarkGenericConfig;
 /// This string should be updated whenever any step in verifying an SP1 proof changes, including
 /// core, recursion, and plonk-bn254. This string is used to download SP1 artifacts and the gnark
 /// docker image.
-pub const SP1_CIRCUIT_VERSION: &str = "v1.0.8-testnet";
+pub const SP1_CIRCUIT_VERSION: &str = "v1.0.9-testnet";
@@ -3,6 +3,7 @@ mod instruction;
 mod io;
 mod memory;
 mod opcode;
+mod paged;
 mod program;
 mod record;
 mod register;
@@ -12,11 +13,13 @@ mod syscall;
 #[macro_use]
 mod utils;
 mod subproof;
+mod untraced;
 
 pub use hooks::*;
 pub use instruction::*;
 pub use memory::*;
 pub use opcode::*;
+pub use paged::*;
 pub use program::*;
 pub use record::*;
 pub use register::*;
@@ -26,7 +29,8 @@ pub use subproof::*;
 pub use syscall::*;
 pub use utils::*;
 
-use std::collections::hash_map::Entry;
+use untraced::UntracedProgram;
+
 use std::collections::HashMap;
 use std::fs::File;
 use std::io::BufWriter;
@@ -101,6 +105,9 @@ pub struct Runtime<'a> {
 
     /// Registry of hooks, to be invoked by writing to certain file descriptors.
     pub hook_registry: HookRegistry<'a>,
+
+    /// The program decoded for the untraced interpreter, on the first untraced cycle.
+    untraced_program: UntracedProgram,
 }
 
 #[derive(Error, Debug)]
@@ -164,6 +171,7 @@ impl<'a> Runtime<'a> {
             print_report: false,
             subproof_verifier: Arc::new(DefaultSubproofVerifier::new()),
             hook_registry: HookRegistry::default(),
+            untraced_program: UntracedProgram::default(),
         }
     }
 
@@ -194,7 +202,7 @@ impl<'a> Runtime<'a> {
         let mut registers = [0; 32];
         for i in 0..32 {
             let addr = Register::from_u32(i as u32) as u32;
-            registers[i] = match self.state.memory.get(&addr) {
+            registers[i] = match self.state.memory.get(addr) {
                 Some(record) => record.value,
                 None => 0,
             };
@@ -205,7 +213,7 @@ impl<'a> Runtime<'a> {
     /// Get the current value of a register.
     pub fn register(&self, register: Register) -> u32 {
         let addr = register as u32;
-        match self.state.memory.get(&addr) {
+        match self.state.memory.get(addr) {
             Some(record) => record.value,
             None => 0,
         }
@@ -213,7 +221,7 @@ impl<'a> Runtime<'a> {
 
     /// Get the current value of a word.
     pub fn word(&self, addr: u32) -> u32 {
-        match self.state.memory.get(&addr) {
+        match self.state.memory.get(addr) {
             Some(record) => record.value,
             None => 0,
         }
@@ -243,35 +251,25 @@ impl<'a> Runtime<'a> {
 
     /// Read a word from memory and create an access record.
     pub fn mr(&mut self, addr: u32, shard: u32, timestamp: u32) -> MemoryReadRecord {
-        // Get the memory record entry.
-        let entry = self.state.memory.entry(addr);
-
         // If we're in unconstrained mode, we don't want to modify state, so we'll save the
-        // original state if it's the first time modifying it.
+        // original page if it's the first time modifying it.
         if self.unconstrained {
-            let record = match entry {
-                Entry::Occupied(ref entry) => Some(entry.get()),
-                Entry::Vacant(_) => None,
-            };
-            self.unconstrained_state
-                .memory_diff
-                .entry(addr)
-                .or_insert(record.copied());
+            self.state
+                .memory
+                .snapshot_page(addr, &mut self.unconstrained_state.memory_diff);
         }
 
         // If it's the first time accessing this address, initialize previous values.
-        let record: &mut MemoryRecord = match entry {
-            Entry::Occupied(entry) => entry.into_mut(),
-            Entry::Vacant(entry) => {
-                // If addr has a specific value to be initialized with, use that, otherwise 0.
-                let value = self.state.uninitialized_memory.get(&addr).unwrap_or(&0);
-                entry.insert(MemoryRecord {
-                    value: *value,
-                    shard: 0,
-                    timestamp: 0,
-                })
+        let uninitialized_memory = &self.state.uninitialized_memory;
+        let record = self.state.memory.get_or_insert_with(addr, || {
+            // If addr has a specific value to be initialized with, use that, otherwise 0.
+            let value = uninitialized_memory.get(addr).copied().unwrap_or(0);
+            MemoryRecord {
+                value,
+                shard: 0,
+                timestamp: 0,
             }
-        };
+        });
         let value = record.value;
         let prev_shard = record.shard;
         let prev_timestamp = record.timestamp;
@@ -284,36 +282,25 @@ impl<'a> Runtime<'a> {
 
     /// Write a word to memory and create an access record.
     pub fn mw(&mut self, addr: u32, value: u32, shard: u32, timestamp: u32) -> MemoryWriteRecord {
-        // Get the memory record entry.
-        let entry = self.state.memory.entry(addr);
-
         // If we're in unconstrained mode, we don't want to modify state, so we'll save the
-        // original state if it's the first time modifying it.
+        // original page if it's the first time modifying it.
         if self.unconstrained {
-            let record = match entry {
-                Entry::Occupied(ref entry) => Some(entry.get()),
-                Entry::Vacant(_) => None,
-            };
-            self.unconstrained_state
-                .memory_diff
-                .entry(addr)
-                .or_insert(record.copied());
+            self.state
+                .memory
+                .snapshot_page(addr, &mut self.unconstrained_state.memory_diff);
         }
 
         // If it's the first time accessing this address, initialize previous values.
-        let record: &mut MemoryRecord = match entry {
-            Entry::Occupied(entry) => entry.into_mut(),
-            Entry::Vacant(entry) => {
-                // If addr has a specific value to be initialized with, use that, otherwise 0.
-                let value = self.state.uninitialized_memory.get(&addr).unwrap_or(&0);
-
-                entry.insert(MemoryRecord {
-                    value: *value,
-                    shard: 0,
-                    timestamp: 0,
-                })
+        let uninitialized_memory = &self.state.uninitialized_memory;
+        let record = self.state.memory.get_or_insert_with(addr, || {
+            // If addr has a specific value to be initialized with, use that, otherwise 0.
+            let value = uninitialized_memory.get(addr).copied().unwrap_or(0);
+            MemoryRecord {
+                value,
+                shard: 0,
+                timestamp: 0,
             }
-        };
+        });
         let prev_value = record.value;
         let prev_shard = record.shard;
         let prev_timestamp = record.timestamp;
@@ -998,6 +985,13 @@ impl<'a> Runtime<'a> {
         Ok((state, done))
     }
 
+    /// Execute up to `self.shard_batch_size` cycles without emitting events, returning whether the program ended.
+    pub fn execute_untraced(&mut self) -> Result<bool, ExecutionError> {
+        self.emit_events = false;
+        self.print_report = false;
+        self.execute()
+    }
+
     fn initialize(&mut self) {
         self.state.clk = 0;
         self.state.channel = 0;
@@ -1041,12 +1035,34 @@ impl<'a> Runtime<'a> {
             self.initialize();
         }
 
+        // When no events are needed, use the untraced interpreter.
+        let untraced = self.can_execute_untraced();
+        let result = self.execute_batch(untraced);
+        if untraced {
+            self.flush_untraced_report();
+        }
+        let done = result?;
+
+        if done {
+            self.postprocess();
+        }
+
+        Ok(done)
+    }
+
+    /// Executes up to `self.shard_batch_size` shards, returning whether the program has finished.
+    fn execute_batch(&mut self, untraced: bool) -> Result<bool, ExecutionError> {
         // Loop until we've executed `self.shard_batch_size` shards if `self.shard_batch_size` is set.
         let mut done = false;
         let mut current_shard = self.state.current_shard;
         let mut num_shards_executed = 0;
         loop {
-            if self.execute_cycle()? {
+            let finished = if untraced {
+                self.execute_cycle_untraced()?
+            } else {
+                self.execute_cycle()?
+            };
+            if finished {
                 done = true;
                 break;
             }
@@ -1060,10 +1076,6 @@ impl<'a> Runtime<'a> {
             }
         }
 
-        if done {
-            self.postprocess();
-        }
-
         Ok(done)
     }
 
@@ -1101,7 +1113,7 @@ impl<'a> Runtime<'a> {
 
         // We handle the addr = 0 case separately, as we constrain it to be 0 in the first row
         // of the memory finalize table so it must be first in the array of events.
-        let addr_0_record = self.state.memory.get(&0u32);
+        let addr_0_record = self.state.memory.get(0u32);
 
         let addr_0_final_record = match addr_0_record {
             Some(record) => record,
@@ -1121,26 +1133,25 @@ impl<'a> Runtime<'a> {
             MemoryInitializeFinalizeEvent::initialize(0, 0, addr_0_record.is_some());
         memory_initialize_events.push(addr_0_initialize_event);
 
-        for addr in self.state.memory.keys() {
-            if addr == &0 {
+        for (addr, record) in self.state.memory.iter() {
+            if addr == 0 {
                 // Handled above.
                 continue;
             }
 
             // Program memory is initialized in the MemoryProgram chip and doesn't require any events,
             // so we only send init events for other memory addresses.
-            if !self.record.program.memory_image.contains_key(addr) {
+            if !self.record.program.memory_image.contains_key(&addr) {
                 let initial_value = self.state.uninitialized_memory.get(addr).unwrap_or(&0);
                 memory_initialize_events.push(MemoryInitializeFinalizeEvent::initialize(
-                    *addr,
+                    addr,
                     *initial_value,
                     true,
                 ));
             }
 
-            let record = *self.state.memory.get(addr).unwrap();
             memory_finalize_events.push(MemoryInitializeFinalizeEvent::finalize_from_record(
-                *addr, &record,
+                addr, record,
             ));
         }
     }
@@ -62,6 +62,10 @@ pub enum Opcode {
     UNIMP = 39,
 }
 
+/// The number of entries in a table indexed by opcode. `UNIMP` has the largest discriminant, so a
+/// new opcode must be numbered below it or this has to be updated.
+pub const NUM_OPCODES: usize = Opcode::UNIMP as usize + 1;
+
 impl Display for Opcode {
     fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
         f.write_str(self.mnemonic())
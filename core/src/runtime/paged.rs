@@ -0,0 +1,400 @@
+use std::fmt;
+use std::marker::PhantomData;
+
+use serde::{Deserialize, Deserializer, Serialize, Serializer};
+
+/// The marker in the page table for a page that has not been allocated.
+const NO_PAGE: u32 = u32::MAX;
+
+/// The addresses below this bound are registers, which are not word aligned.
+const NUM_REGISTER_ADDRS: u32 = 32;
+
+/// How the addresses of a [PagedMemory] are compressed into consecutive slots, and how many slots
+/// a page holds.
+pub trait PageLayout {
+    type Addr: Copy + fmt::Debug;
+
+    /// The log of the number of slots in a page.
+    const LOG_PAGE_LEN: usize;
+
+    /// The number of pages that the page table covers from the start.
+    const INITIAL_PAGES: usize = 0;
+
+    /// Maps an address to its index among all slots.
+    fn compress(addr: Self::Addr) -> usize;
+
+    /// Maps the index of a slot back to its address.
+    fn decompress(index: usize) -> Self::Addr;
+}
+
+/// The layout of the RISC-V memory, where a page covers 4 KiB of word-aligned memory.
+///
+/// Registers live at the addresses `0..32` and every other address is word aligned, so they are
+/// packed together before the address is split into a page and a slot.
+#[derive(Debug, Clone, Copy, Default)]
+pub struct RiscvPageLayout;
+
+impl PageLayout for RiscvPageLayout {
+    type Addr = u32;
+
+    const LOG_PAGE_LEN: usize = 10;
+
+    #[inline]
+    fn compress(addr: u32) -> usize {
+        if addr < NUM_REGISTER_ADDRS {
+            addr as usize
+        } else {
+            debug_assert!(addr % 4 == 0, "memory address is not word aligned");
+            (addr >> 2) as usize + (NUM_REGISTER_ADDRS - NUM_REGISTER_ADDRS / 4) as usize
+        }
+    }
+
+    #[inline]
+    fn decompress(index: usize) -> u32 {
+        if index < NUM_REGISTER_ADDRS as usize {
+            index as u32
+        } else {
+            ((index - (NUM_REGISTER_ADDRS - NUM_REGISTER_ADDRS / 4) as usize) << 2) as u32
+        }
+    }
+}
+
+/// A page of memory slots with a bitmap of the occupied slots.
+#[derive(Debug, Clone)]
+pub struct Page<V> {
+    values: Box<[V]>,
+    occupied: Box<[u64]>,
+    dirty: bool,
+}
+
+impl<V: Copy + Default> Page<V> {
+    fn new(len: usize) -> Self {
+        Self {
+            values: vec![V::default(); len].into_boxed_slice(),
+            occupied: vec![0; bitmap_len(len)].into_boxed_slice(),
+            dirty: false,
+        }
+    }
+
+    #[inline]
+    fn is_occupied(&self, slot: usize) -> bool {
+        self.occupied[slot / 64] & (1 << (slot % 64)) != 0
+    }
+}
+
+/// The number of words in the bitmap that tracks which slots of a page are occupied.
+const fn bitmap_len(page_len: usize) -> usize {
+    page_len.div_ceil(64)
+}
+
+/// Memory stored in lazily allocated pages, addressed through a flat page table.
+///
+/// The layout `L` compresses addresses into consecutive slots before they are split into a page
+/// and a slot. Each page has a dirty bit that is set whenever the page is changed and is reset by
+/// [Self::clear_dirty], which is used to snapshot the memory when forking the runtime.
+#[derive(Clone)]
+pub struct PagedMemory<V, L: PageLayout = RiscvPageLayout> {
+    page_table: Vec<u32>,
+    pages: Vec<Page<V>>,
+    _layout: PhantomData<L>,
+}
+
+/// Copies of the pages of a [PagedMemory] taken before their first change since the last call to
+/// [PagedMemory::clear_dirty].
+#[derive(Debug, Clone)]
+pub struct MemorySnapshot<V> {
+    pages: Vec<(usize, Page<V>)>,
+}
+
+impl<V> Default for MemorySnapshot<V> {
+    fn default() -> Self {
+        Self { pages: Vec::new() }
+    }
+}
+
+impl<V, L: PageLayout> Default for PagedMemory<V, L> {
+    fn default() -> Self {
+        Self {
+            page_table: vec![NO_PAGE; L::INITIAL_PAGES],
+            pages: Vec::new(),
+            _layout: PhantomData,
+        }
+    }
+}
+
+impl<V: Copy + Default, L: PageLayout> PagedMemory<V, L> {
+    /// The number of slots in a page.
+    const PAGE_LEN: usize = 1 << L::LOG_PAGE_LEN;
+
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    #[inline]
+    fn page(&self, page_number: usize) -> Option<&Page<V>> {
+        match self.page_table.get(page_number) {
+            Some(&page) if page != NO_PAGE => Some(&self.pages[page as usize]),
+            _ => None,
+        }
+    }
+
+    /// Returns the page with the given number, allocating it if needed.
+    #[inline]
+    fn page_mut(&mut self, page_number: usize) -> &mut Page<V> {
+        if page_number >= self.page_table.len() {
+            self.page_table.resize(page_number + 1, NO_PAGE);
+        }
+        if self.page_table[page_number] == NO_PAGE {
+            self.page_table[page_number] = self.pages.len() as u32;
+            self.pages.push(Page::new(Self::PAGE_LEN));
+        }
+        &mut self.pages[self.page_table[page_number] as usize]
+    }
+
+    /// Replaces the page with the given number.
+    fn set_page(&mut self, page_number: usize, page: Page<V>) {
+        if page_number >= self.page_table.len() {
+            self.page_table.resize(page_number + 1, NO_PAGE);
+        }
+        match self.page_table[page_number] {
+            NO_PAGE => {
+                self.page_table[page_number] = self.pages.len() as u32;
+                self.pages.push(page);
+            }
+            index => self.pages[index as usize] = page,
+        }
+    }
+
+    /// Returns the value at the address, if it is set.
+    #[inline]
+    pub fn get(&self, addr: L::Addr) -> Option<&V> {
+        let index = L::compress(addr);
+        let page = self.page(index >> L::LOG_PAGE_LEN)?;
+        let slot = index % Self::PAGE_LEN;
+        page.is_occupied(slot).then(|| &page.values[slot])
+    }
+
+    /// Returns whether the address is set.
+    #[inline]
+    pub fn contains(&self, addr: L::Addr) -> bool {
+        self.get(addr).is_some()
+    }
+
+    /// Returns the value at the address, setting it to the result of `init` if it is not set.
+    #[inline]
+    pub fn get_or_insert_with(&mut self, addr: L::Addr, init: impl FnOnce() -> V) -> &mut V {
+        let index = L::compress(addr);
+        let page = self.page_mut(index >> L::LOG_PAGE_LEN);
+        let slot = index % Self::PAGE_LEN;
+        page.dirty = true;
+        if !page.is_occupied(slot) {
+            page.occupied[slot / 64] |= 1 << (slot % 64);
+            page.values[slot] = init();
+        }
+        &mut page.values[slot]
+    }
+
+    /// Returns the value at the address, setting it to the default value if it is not set.
+    #[inline]
+    pub fn get_or_default(&mut self, addr: L::Addr) -> &mut V {
+        self.get_or_insert_with(addr, V::default)
+    }
+
+    /// Sets the value at the address.
+    #[inline]
+    pub fn insert(&mut self, addr: L::Addr, value: V) {
+        *self.get_or_default(addr) = value;
+    }
+
+    /// Unsets the address, returning its value if it was set.
+    pub fn remove(&mut self, addr: L::Addr) -> Option<V> {
+        let index = L::compress(addr);
+        let page_number = index >> L::LOG_PAGE_LEN;
+        let slot = index % Self::PAGE_LEN;
+        match self.page(page_number) {
+            Some(page) if page.is_occupied(slot) => {}
+            _ => return None,
+        }
+        let page = self.page_mut(page_number);
+        page.dirty = true;
+        page.occupied[slot / 64] &= !(1 << (slot % 64));
+        Some(std::mem::take(&mut page.values[slot]))
+    }
+
+    /// Returns an iterator over the set addresses and their values, in increasing address order.
+    pub fn iter(&self) -> impl Iterator<Item = (L::Addr, &V)> {
+        self.page_table
+            .iter()
+            .enumerate()
+            .filter(|(_, page)| **page != NO_PAGE)
+            .flat_map(move |(page_number, &page)| {
+                let page = &self.pages[page as usize];
+                (0..Self::PAGE_LEN)
+                    .filter(|&slot| page.is_occupied(slot))
+                    .map(move |slot| {
+                        let index = (page_number << L::LOG_PAGE_LEN) + slot;
+                        (L::decompress(index), &page.values[slot])
+                    })
+            })
+    }
+
+    /// Returns an iterator over the set addresses, in increasing order.
+    pub fn keys(&self) -> impl Iterator<Item = L::Addr> + '_ {
+        self.iter().map(|(addr, _)| addr)
+    }
+
+    /// Returns the number of set addresses.
+    pub fn len(&self) -> usize {
+        self.pages
+            .iter()
+            .flat_map(|page| page.occupied.iter())
+            .map(|word| word.count_ones() as usize)
+            .sum()
+    }
+
+    /// Returns whether no address is set.
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    /// Marks every page as clean.
+    pub fn clear_dirty(&mut self) {
+        for page in self.pages.iter_mut() {
+            page.dirty = false;
+        }
+    }
+
+    /// Saves a copy of the page holding the address into the snapshot, unless the page has been
+    /// changed since the last call to [Self::clear_dirty] and was therefore saved already.
+    #[inline]
+    pub fn snapshot_page(&mut self, addr: L::Addr, snapshot: &mut MemorySnapshot<V>) {
+        let page_number = L::compress(addr) >> L::LOG_PAGE_LEN;
+        let page = self.page_mut(page_number);
+        if !page.dirty {
+            snapshot.pages.push((page_number, page.clone()));
+            page.dirty = true;
+        }
+    }
+
+    /// Restores the pages saved in the snapshot.
+    pub fn restore(&mut self, snapshot: MemorySnapshot<V>) {
+        for (page_number, page) in snapshot.pages {
+            self.set_page(page_number, page);
+        }
+    }
+}
+
+impl<V: Copy + Default + fmt::Debug, L: PageLayout> fmt::Debug for PagedMemory<V, L> {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        f.debug_map().entries(self.iter()).finish()
+    }
+}
+
+/// A page as it is serialized: its number, the bitmap of its occupied slots and all of its slots.
+#[derive(Serialize)]
+struct SerializedPageRef<'a, V> {
+    number: u32,
+    occupied: &'a [u64],
+    values: &'a [V],
+}
+
+#[derive(Deserialize)]
+struct SerializedPage<V> {
+    number: u32,
+    occupied: Vec<u64>,
+    values: Vec<V>,
+}
+
+/// The memory is serialized page by page, skipping the pages without occupied slots, so that it
+/// is decoded into pages directly instead of being rebuilt address by address.
+impl<V: Copy + Default + Serialize, L: PageLayout> Serialize for PagedMemory<V, L> {
+    fn serialize<S: Serializer>(&self, serializer: S) -> Result<S::Ok, S::Error> {
+        let pages = self
+            .page_table
+            .iter()
+            .enumerate()
+            .filter(|(_, page)| **page != NO_PAGE)
+            .map(|(number, &page)| (number, &self.pages[page as usize]))
+            .filter(|(_, page)| page.occupied.iter().any(|word| *word != 0))
+            .map(|(number, page)| SerializedPageRef {
+                number: number as u32,
+                occupied: &page.occupied,
+                values: &page.values,
+            });
+        serializer.collect_seq(pages)
+    }
+}
+
+impl<'de, V: Copy + Default + Deserialize<'de>, L: PageLayout> Deserialize<'de>
+    for PagedMemory<V, L>
+{
+    fn deserialize<D: Deserializer<'de>>(deserializer: D) -> Result<Self, D::Error> {
+        let pages = Vec::<SerializedPage<V>>::deserialize(deserializer)?;
+        let mut memory = Self::new();
+        for page in pages {
+            if page.values.len() != Self::PAGE_LEN
+                || page.occupied.len() != bitmap_len(Self::PAGE_LEN)
+            {
+                return Err(serde::de::Error::invalid_length(
+                    page.values.len(),
+                    &"a full page of values",
+                ));
+            }
+            memory.set_page(
+                page.number as usize,
+                Page {
+                    values: page.values.into_boxed_slice(),
+                    occupied: page.occupied.into_boxed_slice(),
+                    dirty: false,
+                },
+            );
+        }
+        Ok(memory)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_paged_memory() {
+        let mut memory = PagedMemory::<u32>::new();
+        let addrs = [0, 5, 31, 32, 36, 0x1000, 0x2000_0000, 0xffff_fffc];
+        for (i, addr) in addrs.iter().enumerate() {
+            memory.insert(*addr, i as u32 + 1);
+        }
+        assert_eq!(memory.len(), addrs.len());
+        for (i, addr) in addrs.iter().enumerate() {
+            assert_eq!(memory.get(*addr), Some(&(i as u32 + 1)));
+        }
+        assert_eq!(memory.get(4), None);
+        assert_eq!(memory.get(40), None);
+        assert_eq!(memory.keys().collect::<Vec<_>>(), addrs);
+
+        let bytes = bincode::serialize(&memory).unwrap();
+        let decoded: PagedMemory<u32> = bincode::deserialize(&bytes).unwrap();
+        assert_eq!(
+            decoded.iter().collect::<Vec<_>>(),
+            memory.iter().collect::<Vec<_>>()
+        );
+
+        memory.clear_dirty();
+        let mut snapshot = MemorySnapshot::default();
+        for addr in [36, 0x3000] {
+            memory.snapshot_page(addr, &mut snapshot);
+            *memory.get_or_insert_with(addr, || 0) += 100;
+        }
+        memory.snapshot_page(32, &mut snapshot);
+        memory.remove(32);
+        assert_eq!(memory.get(36), Some(&105));
+        assert!(memory.contains(0x3000));
+        assert!(!memory.contains(32));
+
+        memory.restore(snapshot);
+        assert_eq!(
+            memory.iter().collect::<Vec<_>>(),
+            decoded.iter().collect::<Vec<_>>()
+        );
+    }
+}
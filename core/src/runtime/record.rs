@@ -12,7 +12,7 @@ use super::Opcode;
 use crate::air::PublicValues;
 use crate::alu::AluEvent;
 use crate::bytes::event::ByteRecord;
-use crate::bytes::ByteLookupEvent;
+use crate::bytes::{ByteLookupCounts, ByteLookupEvent};
 use crate::cpu::CpuEvent;
 use crate::runtime::MemoryInitializeFinalizeEvent;
 use crate::runtime::MemoryRecordEnum;
@@ -62,9 +62,9 @@ pub struct ExecutionRecord {
     /// A trace of the SLT, SLTI, SLTU, and SLTIU events.
     pub lt_events: Vec<AluEvent>,
 
-    /// All byte lookups that are needed. The layout is shard -> (event -> count). Byte lookups are
-    /// sharded to prevent the multiplicities from overflowing.
-    pub byte_lookups: BTreeMap<u32, BTreeMap<ByteLookupEvent, usize>>,
+    /// All byte lookups that are needed. The layout is shard -> counts. Byte lookups are sharded to
+    /// prevent the multiplicities from overflowing.
+    pub byte_lookups: BTreeMap<u32, ByteLookupCounts>,
 
     pub sha_extend_events: Vec<ShaExtendEvent>,
 
@@ -104,6 +104,7 @@ pub struct ExecutionRecord {
     pub nonce_lookup: HashMap<usize, u32>,
 }
 
+#[derive(Debug, Clone, Copy, Serialize, Deserialize)]
 pub struct ShardingConfig {
     pub shard_size: usize,
     pub add_len: usize,
@@ -126,14 +127,8 @@ pub struct ShardingConfig {
 }
 
 impl ShardingConfig {
-    pub const fn shard_size(&self) -> usize {
-        self.shard_size
-    }
-}
-
-impl Default for ShardingConfig {
-    fn default() -> Self {
-        let shard_size = SP1CoreOpts::default().shard_size;
+    /// Creates a config whose chip lengths are those of shards of the given size.
+    pub const fn new(shard_size: usize) -> Self {
         Self {
             shard_size,
             add_len: shard_size,
@@ -155,6 +150,28 @@ impl Default for ShardingConfig {
             uint256_mul_len: shard_size,
         }
     }
+
+    pub const fn shard_size(&self) -> usize {
+        self.shard_size
+    }
+}
+
+impl Default for ShardingConfig {
+    fn default() -> Self {
+        Self::new(SP1CoreOpts::default().shard_size)
+    }
+}
+
+/// Where [ExecutionRecord::shard] puts the events of a kind among the shards of a record.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum EventPlacement {
+    /// The events stay in the shard that emitted them.
+    PerShard,
+    /// The events fill the shards in order, up to the length of their chip in the
+    /// [ShardingConfig].
+    Packed,
+    /// The events all go to the first shard.
+    First,
 }
 
 impl MachineRecord for ExecutionRecord {
@@ -277,17 +294,15 @@ impl MachineRecord for ExecutionRecord {
             .append(&mut other.bls12381_decompress_events);
 
         // Merge the byte lookups.
-        for (shard, events_map) in std::mem::take(&mut other.byte_lookups).into_iter() {
+        for (shard, counts) in std::mem::take(&mut other.byte_lookups).into_iter() {
             match self.byte_lookups.get_mut(&shard) {
                 Some(existing) => {
-                    // If there's already a map for this shard, update counts for each event.
-                    for (event, count) in events_map.iter() {
-                        *existing.entry(*event).or_insert(0) += count;
-                    }
+                    // If there are already counts for this shard, add to them.
+                    existing.merge(counts);
                 }
                 None => {
-                    // If there isn't a map for this shard, insert the whole map.
-                    self.byte_lookups.insert(shard, events_map);
+                    // If there are no counts for this shard, insert them whole.
+                    self.byte_lookups.insert(shard, counts);
                 }
             }
         }
@@ -648,12 +663,10 @@ impl ExecutionRecord {
 
 impl ByteRecord for ExecutionRecord {
     fn add_byte_lookup_event(&mut self, blu_event: ByteLookupEvent) {
-        *self
-            .byte_lookups
+        self.byte_lookups
             .entry(blu_event.shard)
             .or_default()
-            .entry(blu_event)
-            .or_insert(0) += 1
+            .add(&blu_event);
     }
 }
 
@@ -1,6 +1,6 @@
-use std::collections::HashMap;
+use std::io::{BufReader, BufWriter, Read, Write};
 
-use nohash_hasher::BuildNoHashHasher;
+use lz4_flex::frame::{FrameDecoder, FrameEncoder};
 use serde::{Deserialize, Serialize};
 use serde_with::serde_as;
 
@@ -9,7 +9,7 @@ use crate::{
     utils::BabyBearPoseidon2,
 };
 
-use super::{ExecutionRecord, MemoryAccessRecord, MemoryRecord};
+use super::{ExecutionRecord, MemoryAccessRecord, MemoryRecord, MemorySnapshot, PagedMemory};
 
 /// Holds data describing the current state of a program's execution.
 #[serde_as]
@@ -34,11 +34,11 @@ pub struct ExecutionState {
 
     /// The memory which instructions operate over. Values contain the memory value and last shard
     /// + timestamp that each memory address was accessed.
-    pub memory: HashMap<u32, MemoryRecord, BuildNoHashHasher<u32>>,
+    pub memory: PagedMemory<MemoryRecord>,
 
     /// Uninitialized memory addresses that have a specific value they should be initialized with.
     /// SyscallHintRead uses this to write hint data into uninitialized memory.
-    pub uninitialized_memory: HashMap<u32, u32, BuildNoHashHasher<u32>>,
+    pub uninitialized_memory: PagedMemory<u32>,
 
     /// A stream of input values (global to the entire program).
     pub input_stream: Vec<Vec<u8>>,
@@ -71,8 +71,8 @@ impl ExecutionState {
             clk: 0,
             channel: 0,
             pc: pc_start,
-            memory: HashMap::default(),
-            uninitialized_memory: HashMap::default(),
+            memory: PagedMemory::new(),
+            uninitialized_memory: PagedMemory::new(),
             input_stream: Vec::new(),
             input_stream_ptr: 0,
             public_values_stream: Vec::new(),
@@ -81,6 +81,24 @@ impl ExecutionState {
             proof_stream_ptr: 0,
         }
     }
+
+    /// Writes the state as a checkpoint: the bincode encoding of the state, in which the memory
+    /// is laid out page by page, compressed in an lz4 frame.
+    pub fn write_checkpoint<W: Write>(&self, writer: W) -> bincode::Result<()> {
+        let mut encoder = FrameEncoder::new(BufWriter::new(writer));
+        bincode::serialize_into(&mut encoder, self)?;
+        encoder
+            .finish()
+            .map_err(std::io::Error::from)?
+            .flush()
+            .map_err(bincode::Error::from)
+    }
+
+    /// Reads a state written by [Self::write_checkpoint].
+    pub fn read_checkpoint<R: Read>(reader: R) -> bincode::Result<Self> {
+        let mut decoder = FrameDecoder::new(BufReader::new(reader));
+        bincode::deserialize_from(&mut decoder)
+    }
 }
 
 /// Holds data to track changes made to the runtime since a fork point.
@@ -95,8 +113,8 @@ pub(crate) struct ForkState {
     /// Original program counter
     pub(crate) pc: u32,
 
-    /// Only contains the original memory values for addresses that have been modified
-    pub(crate) memory_diff: HashMap<u32, Option<MemoryRecord>, BuildNoHashHasher<u32>>,
+    /// Only contains the original memory pages that have been modified
+    pub(crate) memory_diff: MemorySnapshot<MemoryRecord>,
 
     /// Full record from original state
     pub(crate) op_record: MemoryAccessRecord,
@@ -0,0 +1,468 @@
+use super::{
+    align, ExecutionError, Instruction, MemoryAccessPosition, Opcode, Register, Runtime,
+    NUM_OPCODES,
+};
+use crate::bytes::NUM_BYTE_LOOKUP_CHANNELS;
+
+/// An instruction decoded ahead of time for the untraced interpreter, with its operand form
+/// resolved and its registers stored as memory addresses.
+#[derive(Debug, Clone, Copy)]
+enum DecodedInstruction {
+    /// An ALU operation on two registers.
+    AluRegister {
+        opcode: Opcode,
+        rd: u8,
+        rs1: u8,
+        rs2: u8,
+    },
+    /// An ALU operation on a register and an immediate.
+    AluImmediate {
+        opcode: Opcode,
+        rd: u8,
+        rs1: u8,
+        imm: u32,
+    },
+    /// An ALU operation on two immediates, folded into the value written to `rd`.
+    LoadImmediate {
+        rd: u8,
+        value: u32,
+    },
+    Load {
+        opcode: Opcode,
+        rd: u8,
+        rs1: u8,
+        imm: u32,
+    },
+    Store {
+        opcode: Opcode,
+        rs1: u8,
+        rs2: u8,
+        imm: u32,
+    },
+    Branch {
+        opcode: Opcode,
+        rs1: u8,
+        rs2: u8,
+        imm: u32,
+    },
+    Jal {
+        rd: u8,
+        imm: u32,
+    },
+    Jalr {
+        rd: u8,
+        rs1: u8,
+        imm: u32,
+    },
+    /// An AUIPC, folded into the value written to `rd`.
+    Auipc {
+        rd: u8,
+        value: u32,
+    },
+    /// An instruction that is executed by the traced interpreter, such as a syscall.
+    Fallback,
+}
+
+/// A program decoded for the untraced interpreter.
+#[derive(Debug, Clone, Default)]
+pub struct UntracedProgram {
+    instructions: Vec<(DecodedInstruction, Opcode)>,
+
+    /// The opcodes which appear in the program, used to flush the opcode counts into the report.
+    opcodes: Vec<Opcode>,
+
+    /// The number of times each opcode was executed since the last flush, indexed by opcode.
+    opcode_counts: Vec<u64>,
+}
+
+impl UntracedProgram {
+    /// Decodes the instructions of a program starting at `pc_base`.
+    pub fn new(instructions: &[Instruction], pc_base: u32) -> Self {
+        let decoded = instructions
+            .iter()
+            .enumerate()
+            .map(|(i, instruction)| {
+                let pc = pc_base + 4 * i as u32;
+                (decode(instruction, pc), instruction.opcode)
+            })
+            .collect();
+        let mut opcodes = instructions.iter().map(|i| i.opcode).collect::<Vec<_>>();
+        opcodes.sort();
+        opcodes.dedup();
+        Self {
+            instructions: decoded,
+            opcodes,
+            opcode_counts: vec![0; NUM_OPCODES],
+        }
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.instructions.is_empty()
+    }
+}
+
+fn decode(instruction: &Instruction, pc: u32) -> DecodedInstruction {
+    let (op_a, op_b, op_c) = (
+        instruction.op_a as u8,
+        instruction.op_b as u8,
+        instruction.op_c as u8,
+    );
+    let opcode = instruction.opcode;
+    if instruction.is_alu_instruction() {
+        return if !instruction.imm_c {
+            DecodedInstruction::AluRegister {
+                opcode,
+                rd: op_a,
+                rs1: op_b,
+                rs2: op_c,
+            }
+        } else if !instruction.imm_b {
+            DecodedInstruction::AluImmediate {
+                opcode,
+                rd: op_a,
+                rs1: op_b,
+                imm: instruction.op_c,
+            }
+        } else {
+            DecodedInstruction::LoadImmediate {
+                rd: op_a,
+                value: alu(opcode, instruction.op_b, instruction.op_c),
+            }
+        };
+    }
+    match opcode {
+        Opcode::LB | Opcode::LH | Opcode::LW | Opcode::LBU | Opcode::LHU => {
+            DecodedInstruction::Load {
+                opcode,
+                rd: op_a,
+                rs1: op_b,
+                imm: instruction.op_c,
+            }
+        }
+        Opcode::SB | Opcode::SH | Opcode::SW => DecodedInstruction::Store {
+            opcode,
+            rs1: op_a,
+            rs2: op_b,
+            imm: instruction.op_c,
+        },
+        Opcode::BEQ | Opcode::BNE | Opcode::BLT | Opcode::BGE | Opcode::BLTU | Opcode::BGEU => {
+            DecodedInstruction::Branch {
+                opcode,
+                rs1: op_a,
+                rs2: op_b,
+                imm: instruction.op_c,
+            }
+        }
+        Opcode::JAL => DecodedInstruction::Jal {
+            rd: op_a,
+            imm: instruction.op_b,
+        },
+        Opcode::JALR => DecodedInstruction::Jalr {
+            rd: op_a,
+            rs1: op_b,
+            imm: instruction.op_c,
+        },
+        Opcode::AUIPC => DecodedInstruction::Auipc {
+            rd: op_a,
+            value: pc.wrapping_add(instruction.op_b),
+        },
+        _ => DecodedInstruction::Fallback,
+    }
+}
+
+/// Computes the result of an ALU operation.
+#[inline(always)]
+fn alu(opcode: Opcode, b: u32, c: u32) -> u32 {
+    match opcode {
+        Opcode::ADD => b.wrapping_add(c),
+        Opcode::SUB => b.wrapping_sub(c),
+        Opcode::XOR => b ^ c,
+        Opcode::OR => b | c,
+        Opcode::AND => b & c,
+        Opcode::SLL => b.wrapping_shl(c),
+        Opcode::SRL => b.wrapping_shr(c),
+        Opcode::SRA => (b as i32).wrapping_shr(c) as u32,
+        Opcode::SLT => ((b as i32) < (c as i32)) as u32,
+        Opcode::SLTU => (b < c) as u32,
+        Opcode::MUL => b.wrapping_mul(c),
+        Opcode::MULH => (((b as i32) as i64).wrapping_mul((c as i32) as i64) >> 32) as u32,
+        Opcode::MULHU => ((b as u64).wrapping_mul(c as u64) >> 32) as u32,
+        Opcode::MULHSU => (((b as i32) as i64).wrapping_mul(c as i64) >> 32) as u32,
+        Opcode::DIV if c == 0 => u32::MAX,
+        Opcode::DIV => (b as i32).wrapping_div(c as i32) as u32,
+        Opcode::DIVU if c == 0 => u32::MAX,
+        Opcode::DIVU => b.wrapping_div(c),
+        Opcode::REM if c == 0 => b,
+        Opcode::REM => (b as i32).wrapping_rem(c as i32) as u32,
+        Opcode::REMU if c == 0 => b,
+        Opcode::REMU => b.wrapping_rem(c),
+        _ => unreachable!(),
+    }
+}
+
+impl<'a> Runtime<'a> {
+    /// Returns whether the untraced interpreter can be used, which is the case when no events are
+    /// emitted and no per-cycle trace is written.
+    pub(crate) fn can_execute_untraced(&self) -> bool {
+        !self.emit_events && self.trace_buf.is_none() && !log::log_enabled!(log::Level::Trace)
+    }
+
+    /// Read a register without recording the access for the current cycle.
+    #[inline(always)]
+    fn rr_untraced(&mut self, register: u8, position: MemoryAccessPosition) -> u32 {
+        self.mr(register as u32, self.shard(), self.timestamp(&position))
+            .value
+    }
+
+    /// Write a register without recording the access for the current cycle.
+    #[inline(always)]
+    fn rw_untraced(&mut self, register: u8, value: u32) {
+        // Register %x0 should always be 0.
+        let value = if register == Register::X0 as u8 {
+            0
+        } else {
+            value
+        };
+        self.mw(
+            register as u32,
+            value,
+            self.shard(),
+            self.timestamp(&MemoryAccessPosition::A),
+        );
+    }
+
+    /// Read an aligned memory word without recording the access for the current cycle.
+    #[inline(always)]
+    fn mr_untraced(&mut self, addr: u32) -> u32 {
+        assert_valid_memory_access!(addr, MemoryAccessPosition::Memory);
+        self.mr(
+            addr,
+            self.shard(),
+            self.timestamp(&MemoryAccessPosition::Memory),
+        )
+        .value
+    }
+
+    /// Write an aligned memory word without recording the access for the current cycle.
+    #[inline(always)]
+    fn mw_untraced(&mut self, addr: u32, value: u32) {
+        assert_valid_memory_access!(addr, MemoryAccessPosition::Memory);
+        self.mw(
+            addr,
+            value,
+            self.shard(),
+            self.timestamp(&MemoryAccessPosition::Memory),
+        );
+    }
+
+    /// Executes one cycle of the program without emitting events, returning whether the program
+    /// has finished.
+    ///
+    /// The instructions are pre-decoded and their registers and memory are accessed directly, so
+    /// that no access records or lookup ids are created. The memory and clocks are updated exactly
+    /// as in [Runtime::execute_cycle], which executes the instructions this interpreter does not
+    /// handle, such as syscalls.
+    #[inline]
+    pub(crate) fn execute_cycle_untraced(&mut self) -> Result<bool, ExecutionError> {
+        if self.untraced_program.is_empty() {
+            self.untraced_program =
+                UntracedProgram::new(&self.program.instructions, self.program.pc_base);
+        }
+
+        let pc = self.state.pc;
+        let idx = ((pc - self.program.pc_base) / 4) as usize;
+        let (instruction, opcode) = self.untraced_program.instructions[idx];
+        let mut next_pc = pc.wrapping_add(4);
+
+        match instruction {
+            DecodedInstruction::AluRegister {
+                opcode,
+                rd,
+                rs1,
+                rs2,
+            } => {
+                let c = self.rr_untraced(rs2, MemoryAccessPosition::C);
+                let b = self.rr_untraced(rs1, MemoryAccessPosition::B);
+                self.rw_untraced(rd, alu(opcode, b, c));
+            }
+            DecodedInstruction::AluImmediate {
+                opcode,
+                rd,
+                rs1,
+                imm,
+            } => {
+                let b = self.rr_untraced(rs1, MemoryAccessPosition::B);
+                self.rw_untraced(rd, alu(opcode, b, imm));
+            }
+            DecodedInstruction::LoadImmediate { rd, value } => {
+                self.rw_untraced(rd, value);
+            }
+            DecodedInstruction::Load {
+                opcode,
+                rd,
+                rs1,
+                imm,
+            } => {
+                let addr = self
+                    .rr_untraced(rs1, MemoryAccessPosition::B)
+                    .wrapping_add(imm);
+                let word = self.mr_untraced(align(addr));
+                let a = match opcode {
+                    Opcode::LB => ((word.to_le_bytes()[(addr % 4) as usize] as i8) as i32) as u32,
+                    Opcode::LBU => word.to_le_bytes()[(addr % 4) as usize] as u32,
+                    Opcode::LH | Opcode::LHU => {
+                        if addr % 2 != 0 {
+                            return Err(ExecutionError::InvalidMemoryAccess(opcode, addr));
+                        }
+                        let half = (word >> (((addr >> 1) % 2) * 16)) as u16;
+                        if opcode == Opcode::LH {
+                            ((half as i16) as i32) as u32
+                        } else {
+                            half as u32
+                        }
+                    }
+                    Opcode::LW => {
+                        if addr % 4 != 0 {
+                            return Err(ExecutionError::InvalidMemoryAccess(opcode, addr));
+                        }
+                        word
+                    }
+                    _ => unreachable!(),
+                };
+                self.rw_untraced(rd, a);
+            }
+            DecodedInstruction::Store {
+                opcode,
+                rs1,
+                rs2,
+                imm,
+            } => {
+                let b = self.rr_untraced(rs2, MemoryAccessPosition::B);
+                let a = self.rr_untraced(rs1, MemoryAccessPosition::A);
+                let addr = b.wrapping_add(imm);
+                let value = match opcode {
+                    Opcode::SB => {
+                        let shift = (addr % 4) * 8;
+                        let word = self.word(align(addr));
+                        ((a & 0xFF) << shift) | (word & !(0xFF << shift))
+                    }
+                    Opcode::SH => {
+                        if addr % 2 != 0 {
+                            return Err(ExecutionError::InvalidMemoryAccess(opcode, addr));
+                        }
+                        let shift = ((addr >> 1) % 2) * 16;
+                        let word = self.word(align(addr));
+                        ((a & 0xFFFF) << shift) | (word & !(0xFFFF << shift))
+                    }
+                    Opcode::SW => {
+                        if addr % 4 != 0 {
+                            return Err(ExecutionError::InvalidMemoryAccess(opcode, addr));
+                        }
+                        a
+                    }
+                    _ => unreachable!(),
+                };
+                self.mw_untraced(align(addr), value);
+            }
+            DecodedInstruction::Branch {
+                opcode,
+                rs1,
+                rs2,
+                imm,
+            } => {
+                let b = self.rr_untraced(rs2, MemoryAccessPosition::B);
+                let a = self.rr_untraced(rs1, MemoryAccessPosition::A);
+                let taken = match opcode {
+                    Opcode::BEQ => a == b,
+                    Opcode::BNE => a != b,
+                    Opcode::BLT => (a as i32) < (b as i32),
+                    Opcode::BGE => (a as i32) >= (b as i32),
+                    Opcode::BLTU => a < b,
+                    Opcode::BGEU => a >= b,
+                    _ => unreachable!(),
+                };
+                if taken {
+                    next_pc = pc.wrapping_add(imm);
+                }
+            }
+            DecodedInstruction::Jal { rd, imm } => {
+                self.rw_untraced(rd, pc + 4);
+                next_pc = pc.wrapping_add(imm);
+            }
+            DecodedInstruction::Jalr { rd, rs1, imm } => {
+                let b = self.rr_untraced(rs1, MemoryAccessPosition::B);
+                self.rw_untraced(rd, pc + 4);
+                next_pc = b.wrapping_add(imm);
+            }
+            DecodedInstruction::Auipc { rd, value } => {
+                self.rw_untraced(rd, value);
+            }
+            DecodedInstruction::Fallback => return self.execute_cycle(),
+        }
+
+        if self.print_report && !self.unconstrained {
+            self.untraced_program.opcode_counts[opcode as usize] += 1;
+        }
+
+        // Update the program counter, the clk and the channel as in `execute_instruction`.
+        self.state.pc = next_pc;
+        self.state.clk += 4;
+        if !self.unconstrained {
+            self.state.channel = (self.state.channel + 1) % NUM_BYTE_LOOKUP_CHANNELS;
+        }
+
+        // Increment the clock, and move to the next shard as in `execute_cycle`.
+        self.state.global_clk += 1;
+        if !self.unconstrained && self.max_syscall_cycles + self.state.clk >= self.shard_size {
+            self.state.current_shard += 1;
+            self.state.clk = 0;
+            self.state.channel = 0;
+        }
+
+        Ok(self.state.pc.wrapping_sub(self.program.pc_base)
+            >= (self.program.instructions.len() * 4) as u32)
+    }
+
+    /// Adds the opcode counts of the untraced interpreter to the report.
+    pub(crate) fn flush_untraced_report(&mut self) {
+        let program = &mut self.untraced_program;
+        for opcode in program.opcodes.iter() {
+            let count = std::mem::take(&mut program.opcode_counts[*opcode as usize]);
+            if count > 0 {
+                *self.report.opcode_counts.entry(*opcode).or_insert(0) += count;
+            }
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use crate::runtime::tests::ssz_withdrawals_program;
+    use crate::runtime::Runtime;
+    use crate::utils::SP1CoreOpts;
+
+    #[test]
+    fn test_untraced_matches_traced() {
+        let program = ssz_withdrawals_program();
+
+        let mut traced = Runtime::new(program.clone(), SP1CoreOpts::default());
+        traced.run().unwrap();
+
+        let mut untraced = Runtime::new(program, SP1CoreOpts::default());
+        untraced.run_untraced().unwrap();
+
+        assert_eq!(traced.state.global_clk, untraced.state.global_clk);
+        assert_eq!(traced.state.current_shard, untraced.state.current_shard);
+        assert_eq!(traced.state.clk, untraced.state.clk);
+        assert_eq!(traced.report, untraced.report);
+        let records = |runtime: &Runtime| {
+            runtime
+                .state
+                .memory
+                .iter()
+                .map(|(addr, record)| (addr, record.value, record.shard, record.timestamp))
+                .collect::<Vec<_>>()
+        };
+        assert_eq!(records(&traced), records(&untraced));
+    }
+}
@@ -2,6 +2,7 @@ use super::StarkMachine;
 pub use crate::air::SP1AirBuilder;
 use crate::air::{MachineAir, SP1_PROOF_NUM_PV_ELTS};
 use crate::memory::{MemoryChipType, MemoryProgramChip};
+use crate::runtime::EventPlacement;
 use crate::stark::Chip;
 use crate::StarkGenericConfig;
 use p3_field::PrimeField32;
@@ -174,6 +175,44 @@ impl<F: PrimeField32> RiscvAir<F> {
 
         chips
     }
+
+    /// Returns the events that fill the rows of the chip, as their keys in the stats of the
+    /// execution record with the number of rows of each event, along with where the events are
+    /// put among the shards. Returns `None` for the chips whose height does not grow with the size
+    /// of the shards.
+    pub fn shard_events(&self) -> Option<(&'static [(&'static str, usize)], EventPlacement)> {
+        use EventPlacement::*;
+        let events: (&'static [(&'static str, usize)], EventPlacement) = match self {
+            RiscvAir::Cpu(_) => (&[("cpu_events", 1)], PerShard),
+            RiscvAir::Add(_) => (&[("add_events", 1), ("sub_events", 1)], Packed),
+            RiscvAir::Bitwise(_) => (&[("bitwise_events", 1)], Packed),
+            RiscvAir::Mul(_) => (&[("mul_events", 1)], Packed),
+            RiscvAir::DivRem(_) => (&[("divrem_events", 1)], Packed),
+            RiscvAir::Lt(_) => (&[("lt_events", 1)], Packed),
+            RiscvAir::ShiftLeft(_) => (&[("shift_left_events", 1)], Packed),
+            RiscvAir::ShiftRight(_) => (&[("shift_right_events", 1)], Packed),
+            RiscvAir::KeccakP(_) => (&[("keccak_permute_events", 24)], Packed),
+            RiscvAir::Secp256k1Add(_) => (&[("secp256k1_add_events", 1)], Packed),
+            RiscvAir::Secp256k1Double(_) => (&[("secp256k1_double_events", 1)], Packed),
+            RiscvAir::Bn254Add(_) => (&[("bn254_add_events", 1)], Packed),
+            RiscvAir::Bn254Double(_) => (&[("bn254_double_events", 1)], Packed),
+            RiscvAir::Bls12381Add(_) => (&[("bls12381_add_events", 1)], Packed),
+            RiscvAir::Bls12381Double(_) => (&[("bls12381_double_events", 1)], Packed),
+            RiscvAir::Sha256Extend(_) => (&[("sha_extend_events", 48)], First),
+            RiscvAir::Sha256Compress(_) => (&[("sha_compress_events", 80)], First),
+            RiscvAir::Ed25519Add(_) => (&[("ed_add_events", 1)], First),
+            RiscvAir::Ed25519Decompress(_) => (&[("ed_decompress_events", 1)], First),
+            RiscvAir::K256Decompress(_) => (&[("k256_decompress_events", 1)], First),
+            RiscvAir::Uint256Mul(_) => (&[("uint256_mul_events", 1)], First),
+            RiscvAir::Bls12381Decompress(_) => (&[("bls12381_decompress_events", 1)], First),
+            RiscvAir::Program(_)
+            | RiscvAir::ByteLookup(_)
+            | RiscvAir::MemoryInit(_)
+            | RiscvAir::MemoryFinal(_)
+            | RiscvAir::ProgramMemory(_) => return None,
+        };
+        Some(events)
+    }
 }
 
 impl<F: PrimeField32> PartialEq for RiscvAir<F> {
@@ -29,6 +29,11 @@ pub struct Chip<F: Field, A> {
 }
 
 impl<F: Field, A> Chip<F, A> {
+    /// The underlying AIR of the chip.
+    pub const fn air(&self) -> &A {
+        &self.air
+    }
+
     /// The send interactions of the chip.
     pub fn sends(&self) -> &[Interaction<F>] {
         &self.sends
@@ -192,6 +197,10 @@ where
         self.air.generate_dependencies(input, output)
     }
 
+    fn dependency_stage(&self) -> usize {
+        self.air.dependency_stage()
+    }
+
     fn included(&self, shard: &Self::Record) -> bool {
         self.air.included(shard)
     }
@@ -35,6 +35,7 @@ use crate::utils::SP1CoreOpts;
 use super::Chip;
 use super::Com;
 use super::MachineProof;
+use super::OpeningProof;
 use super::PcsProverData;
 use super::Prover;
 use super::StarkGenericConfig;
@@ -248,13 +249,29 @@ impl<SC: StarkGenericConfig, A: MachineAir<Val<SC>>> StarkMachine<SC, A> {
         let chips = self.chips();
 
         // Generate the trace for each chip to collect events emitted from chips with dependencies.
+        // The chips of a stage run in parallel, and their events are appended in chip order.
         tracing::debug_span!("collect record events from chips").in_scope(|| {
-            chips.iter().for_each(|chip| {
-                let mut output = A::Record::default();
-                output.set_index(record.index());
-                chip.generate_dependencies(&record, &mut output);
-                record.append(&mut output);
-            })
+            let stages = chips
+                .iter()
+                .map(|chip| chip.dependency_stage())
+                .sorted()
+                .dedup()
+                .collect::<Vec<_>>();
+            for stage in stages {
+                let mut outputs = chips
+                    .par_iter()
+                    .filter(|chip| chip.dependency_stage() == stage)
+                    .map(|chip| {
+                        let mut output = A::Record::default();
+                        output.set_index(record.index());
+                        chip.generate_dependencies(&record, &mut output);
+                        output
+                    })
+                    .collect::<Vec<_>>();
+                for output in outputs.iter_mut() {
+                    record.append(output);
+                }
+            }
         });
 
         // Display some statistics about the workload.
@@ -303,6 +320,8 @@ impl<SC: StarkGenericConfig, A: MachineAir<Val<SC>>> StarkMachine<SC, A> {
     ) -> Result<(), MachineVerificationError<SC>>
     where
         SC::Challenger: Clone,
+        Com<SC>: Sync,
+        OpeningProof<SC>: Sync,
         A: for<'a> Air<VerifierConstraintFolder<'a, SC>>,
     {
         // Observe the preprocessed commitment.
@@ -319,25 +338,20 @@ impl<SC: StarkGenericConfig, A: MachineAir<Val<SC>>> StarkMachine<SC, A> {
             return Err(MachineVerificationError::EmptyProof);
         }
 
-        tracing::debug_span!("verify shard proofs").in_scope(|| {
-            for (i, shard_proof) in proof.shard_proofs.iter().enumerate() {
-                tracing::debug_span!("verifying shard", segment = i).in_scope(|| {
-                    let chips = self
-                        .shard_chips_ordered(&shard_proof.chip_ordering)
-                        .collect::<Vec<_>>();
-                    Verifier::verify_shard(
-                        &self.config,
-                        vk,
-                        &chips,
-                        &mut challenger.clone(),
-                        shard_proof,
-                    )
-                    .map_err(MachineVerificationError::InvalidSegmentProof)
-                })?;
-            }
-
-            Ok(())
-        })?;
+        // The shards are verified in parallel, each from a clone of the challenger. The errors are
+        // not required to be sendable between threads, so the first invalid shard is verified
+        // again on this thread to return its error.
+        let challenger = &*challenger;
+        let invalid_shard = tracing::debug_span!("verify shard proofs").in_scope(|| {
+            proof.shard_proofs.par_iter().position_first(|shard_proof| {
+                self.verify_shard_proof(vk, challenger, shard_proof)
+                    .is_err()
+            })
+        });
+        if let Some(i) = invalid_shard {
+            tracing::debug_span!("verifying shard", segment = i)
+                .in_scope(|| self.verify_shard_proof(vk, challenger, &proof.shard_proofs[i]))?;
+        }
 
         // Verify the cumulative sum is 0.
         tracing::debug_span!("verify cumulative sum is 0").in_scope(|| {
@@ -352,6 +366,54 @@ impl<SC: StarkGenericConfig, A: MachineAir<Val<SC>>> StarkMachine<SC, A> {
         })
     }
 
+    /// Verifies many proofs with the same verifying key in parallel, each with a new challenger.
+    /// Returns the index and error of the first invalid proof.
+    pub fn verify_batch(
+        &self,
+        vk: &StarkVerifyingKey<SC>,
+        proofs: &[MachineProof<SC>],
+    ) -> Result<(), (usize, MachineVerificationError<SC>)>
+    where
+        SC::Challenger: Clone,
+        Com<SC>: Sync,
+        OpeningProof<SC>: Sync,
+        A: for<'a> Air<VerifierConstraintFolder<'a, SC>>,
+    {
+        let verify =
+            |proof: &MachineProof<SC>| self.verify(vk, proof, &mut self.config.challenger());
+        let invalid_proof = proofs
+            .par_iter()
+            .position_first(|proof| verify(proof).is_err());
+        match invalid_proof {
+            Some(i) => verify(&proofs[i]).map_err(|e| (i, e)),
+            None => Ok(()),
+        }
+    }
+
+    /// Verifies a shard proof from a clone of the challenger that observed every shard.
+    fn verify_shard_proof(
+        &self,
+        vk: &StarkVerifyingKey<SC>,
+        challenger: &SC::Challenger,
+        shard_proof: &ShardProof<SC>,
+    ) -> Result<(), MachineVerificationError<SC>>
+    where
+        SC::Challenger: Clone,
+        A: for<'a> Air<VerifierConstraintFolder<'a, SC>>,
+    {
+        let chips = self
+            .shard_chips_ordered(&shard_proof.chip_ordering)
+            .collect::<Vec<_>>();
+        Verifier::verify_shard(
+            &self.config,
+            vk,
+            &chips,
+            &mut challenger.clone(),
+            shard_proof,
+        )
+        .map_err(MachineVerificationError::InvalidSegmentProof)
+    }
+
     #[instrument("debug constraints", level = "debug", skip_all)]
     pub fn debug_constraints(
         &self,
@@ -523,6 +585,9 @@ impl<SC: StarkGenericConfig> std::error::Error for MachineVerificationError<SC>
 #[allow(non_snake_case)]
 pub mod tests {
 
+    use p3_baby_bear::BabyBear;
+    use p3_field::AbstractField;
+
     use crate::io::SP1Stdin;
     use crate::runtime::tests::fibonacci_program;
     use crate::runtime::tests::simple_memory_program;
@@ -708,6 +773,36 @@ pub mod tests {
         .unwrap();
     }
 
+    #[test]
+    fn test_verify_batch_reports_invalid_proof() {
+        setup_logger();
+        let program = fibonacci_program();
+        let stdin = SP1Stdin::new();
+        let machine = RiscvAir::machine(BabyBearPoseidon2::new());
+        let (_, vk) = machine.setup(&program);
+
+        let mut proofs = (0..3)
+            .map(|_| {
+                prove(
+                    program.clone(),
+                    &stdin,
+                    BabyBearPoseidon2::new(),
+                    SP1CoreOpts::default(),
+                )
+                .unwrap()
+                .0
+            })
+            .collect::<Vec<_>>();
+        machine.verify_batch(&vk, &proofs).unwrap();
+
+        // Corrupt a public value of the middle proof so that only it fails to verify.
+        proofs[1].shard_proofs[0].public_values[0] += BabyBear::one();
+        match machine.verify_batch(&vk, &proofs) {
+            Err((index, _)) => assert_eq!(index, 1),
+            Ok(()) => panic!("expected the corrupted proof to fail verification"),
+        }
+    }
+
     #[test]
     fn test_simple_memory_program_prove() {
         let program = simple_memory_program();
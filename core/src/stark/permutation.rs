@@ -2,13 +2,23 @@ use std::borrow::Borrow;
 
 use itertools::Itertools;
 use p3_air::{ExtensionBuilder, PairBuilder};
-use p3_field::{AbstractExtensionField, AbstractField, ExtensionField, Field, Powers, PrimeField};
+use p3_field::{
+    batch_multiplicative_inverse, AbstractExtensionField, AbstractField, ExtensionField, Field,
+    PackedValue, Powers, PrimeField,
+};
 use p3_matrix::{dense::RowMajorMatrix, Matrix};
 use p3_maybe_rayon::prelude::*;
 use rayon_scan::ScanParallelIterator;
 
 use crate::{air::MultiTableAirBuilder, lookup::Interaction};
 
+/// The number of rows of the permutation trace whose denominators are inverted together.
+const PERMUTATION_CHUNK_HEIGHT: usize = 1 << 8;
+
+/// Computes a permutation trace row by row, inverting every denominator on its own.
+///
+/// This is the reference for [generate_permutation_trace], which computes the same values a chunk
+/// of rows at a time.
 #[inline]
 #[allow(clippy::too_many_arguments)]
 pub fn populate_permutation_row<F: PrimeField, EF: ExtensionField<F>>(
@@ -52,6 +62,104 @@ pub fn populate_permutation_row<F: PrimeField, EF: ExtensionField<F>>(
     }
 }
 
+/// Computes the batch sums of a chunk of rows of the permutation trace, leaving the cumulative
+/// sum column untouched.
+///
+/// The denominators are evaluated for [PackedValue::WIDTH] rows at once on the packed field, with
+/// the columns of the rows transposed into lanes, and are then inverted together with a single
+/// inversion in the extension field.
+#[allow(clippy::too_many_arguments)]
+fn populate_permutation_chunk<F: PrimeField, EF: ExtensionField<F>>(
+    rows: &mut [EF],
+    preprocessed_rows: &[F],
+    preprocessed_width: usize,
+    main_rows: &[F],
+    main_width: usize,
+    interactions: &[(&Interaction<F>, bool)],
+    alpha: EF,
+    betas: &[EF],
+    batch_size: usize,
+) {
+    let num_interactions = interactions.len();
+    if num_interactions == 0 {
+        return;
+    }
+    let perm_width = permutation_trace_width(num_interactions, batch_size);
+    let height = rows.len() / perm_width;
+
+    let packed_betas = betas
+        .iter()
+        .map(|beta| EF::ExtensionPacking::from_f(*beta))
+        .collect::<Vec<_>>();
+    let offsets = interactions
+        .iter()
+        .map(|(interaction, _)| {
+            EF::ExtensionPacking::from_f(
+                alpha + betas[0] * EF::from_canonical_usize(interaction.argument_index()),
+            )
+        })
+        .collect::<Vec<_>>();
+
+    // The denominators and signed multiplicities of the chunk, indexed by row and interaction.
+    let mut denominators = vec![EF::zero(); height * num_interactions];
+    let mut multiplicities = vec![F::zero(); height * num_interactions];
+    for start in (0..height).step_by(F::Packing::WIDTH) {
+        let lanes = F::Packing::WIDTH.min(height - start);
+
+        // Transpose the rows into packed columns, repeating the last row in the lanes past the end
+        // of the chunk.
+        let pack = |values: &[F], width: usize| {
+            (0..width)
+                .map(|col| {
+                    F::Packing::from_fn(|lane| values[(start + lane.min(lanes - 1)) * width + col])
+                })
+                .collect::<Vec<_>>()
+        };
+        let preprocessed = pack(preprocessed_rows, preprocessed_width);
+        let main = pack(main_rows, main_width);
+
+        for (j, ((interaction, is_send), offset)) in interactions.iter().zip(&offsets).enumerate() {
+            let mut denominator = *offset;
+            for (columns, beta) in interaction.values.iter().zip(&packed_betas[1..]) {
+                denominator +=
+                    *beta * columns.apply::<F::Packing, F::Packing>(&preprocessed, &main);
+            }
+            let mut mult = interaction
+                .multiplicity
+                .apply::<F::Packing, F::Packing>(&preprocessed, &main);
+            if !is_send {
+                mult = -mult;
+            }
+
+            let coeffs = denominator.as_base_slice();
+            for lane in 0..lanes {
+                let index = (start + lane) * num_interactions + j;
+                denominators[index] = EF::from_base_fn(|i| coeffs[i].as_slice()[lane]);
+                multiplicities[index] = mult.as_slice()[lane];
+            }
+        }
+    }
+
+    let inverses = batch_multiplicative_inverse(&denominators);
+    for ((row, inverses), multiplicities) in rows
+        .chunks_exact_mut(perm_width)
+        .zip(inverses.chunks_exact(num_interactions))
+        .zip(multiplicities.chunks_exact(num_interactions))
+    {
+        for (value, (inverses, multiplicities)) in row.iter_mut().zip(
+            inverses
+                .chunks(batch_size)
+                .zip(multiplicities.chunks(batch_size)),
+        ) {
+            *value = inverses
+                .iter()
+                .zip(multiplicities)
+                .map(|(inverse, mult)| *inverse * *mult)
+                .sum();
+        }
+    }
+}
+
 #[inline]
 pub const fn permutation_trace_width(num_interactions: usize, batch_size: usize) -> usize {
     num_interactions.div_ceil(batch_size) + 1
@@ -72,8 +180,22 @@ pub fn generate_permutation_trace<F: PrimeField, EF: ExtensionField<F>>(
     // Generate the RLC elements to uniquely identify each interaction.
     let alpha = random_elements[0];
 
+    let interactions = sends
+        .iter()
+        .map(|int| (int, true))
+        .chain(receives.iter().map(|int| (int, false)))
+        .collect::<Vec<_>>();
+    let max_num_values = interactions
+        .iter()
+        .map(|(int, _)| int.values.len())
+        .max()
+        .unwrap_or(0);
+
     // Generate the RLC elements to uniquely identify each item in the looked up tuple.
-    let betas = random_elements[1].powers();
+    let betas = random_elements[1]
+        .powers()
+        .take(max_num_values + 1)
+        .collect::<Vec<_>>();
 
     // Iterate over the rows of the main trace to compute the permutation trace values. In
     // particular, for each row i, interaction j, and columns c_0, ..., c_{k-1} we compute the sum:
@@ -90,45 +212,31 @@ pub fn generate_permutation_trace<F: PrimeField, EF: ExtensionField<F>>(
         permutation_trace_width,
     );
 
-    // Compute the permutation trace values in parallel.
-
-    match preprocessed {
-        Some(prep) => {
-            permutation_trace
-                .par_rows_mut()
-                .zip_eq(prep.par_row_slices())
-                .zip_eq(main.par_row_slices())
-                .for_each(|((row, prep_row), main_row)| {
-                    populate_permutation_row(
-                        row,
-                        prep_row,
-                        main_row,
-                        sends,
-                        receives,
-                        alpha,
-                        betas.clone(),
-                        batch_size,
-                    )
-                });
-        }
-        None => {
-            permutation_trace
-                .par_rows_mut()
-                .zip_eq(main.par_row_slices())
-                .for_each(|(row, main_row)| {
-                    populate_permutation_row(
-                        row,
-                        &[],
-                        main_row,
-                        sends,
-                        receives,
-                        alpha,
-                        betas.clone(),
-                        batch_size,
-                    )
-                });
-        }
-    }
+    // Compute the permutation trace values in parallel, a chunk of rows at a time.
+    let (prep_values, prep_width) = match preprocessed {
+        Some(prep) => (prep.values.as_slice(), prep.width()),
+        None => (&[][..], 0),
+    };
+    let main_width = main.width();
+    permutation_trace
+        .values
+        .par_chunks_mut(PERMUTATION_CHUNK_HEIGHT * permutation_trace_width)
+        .enumerate()
+        .for_each(|(i, rows)| {
+            let start = i * PERMUTATION_CHUNK_HEIGHT;
+            let end = start + rows.len() / permutation_trace_width;
+            populate_permutation_chunk(
+                rows,
+                &prep_values[start * prep_width..end * prep_width],
+                prep_width,
+                &main.values[start * main_width..end * main_width],
+                main_width,
+                &interactions,
+                alpha,
+                &betas,
+                batch_size,
+            );
+        });
 
     let zero = EF::zero();
     let cumulative_sums = permutation_trace
@@ -290,3 +398,81 @@ pub fn eval_permutation_constraints<F, AB>(
         .when_last_row()
         .assert_eq_ext(*perm_local.last().unwrap(), cumulative_sum);
 }
+
+#[cfg(test)]
+mod tests {
+    use p3_air::VirtualPairCol;
+    use p3_baby_bear::BabyBear;
+    use p3_field::extension::BinomialExtensionField;
+    use rand::{thread_rng, Rng};
+
+    use super::*;
+    use crate::lookup::InteractionKind;
+
+    type F = BabyBear;
+    type EF = BinomialExtensionField<BabyBear, 4>;
+
+    #[test]
+    fn test_permutation_trace_matches_rows() {
+        let mut rng = thread_rng();
+        let sends = vec![
+            Interaction::new(
+                vec![
+                    VirtualPairCol::single_main(0),
+                    VirtualPairCol::single_main(1),
+                ],
+                VirtualPairCol::single_main(2),
+                InteractionKind::Alu,
+            ),
+            Interaction::new(
+                vec![VirtualPairCol::single_preprocessed(0)],
+                VirtualPairCol::constant(F::one()),
+                InteractionKind::Byte,
+            ),
+        ];
+        let receives = vec![Interaction::new(
+            vec![
+                VirtualPairCol::single_main(3),
+                VirtualPairCol::single_preprocessed(1),
+                VirtualPairCol::new_main(vec![(0, F::two()), (4, F::one())], F::one()),
+            ],
+            VirtualPairCol::single_main(4),
+            InteractionKind::Memory,
+        )];
+
+        // A height that is neither a multiple of the chunk height nor of the packing width.
+        let height = PERMUTATION_CHUNK_HEIGHT + 37;
+        let main = RowMajorMatrix::new((0..height * 5).map(|_| rng.gen::<F>()).collect(), 5);
+        let prep = RowMajorMatrix::new((0..height * 2).map(|_| rng.gen::<F>()).collect(), 2);
+        let random_elements = [rng.gen::<EF>(), rng.gen::<EF>()];
+
+        for batch_size in 1..4 {
+            let trace = generate_permutation_trace(
+                &sends,
+                &receives,
+                Some(&prep),
+                &main,
+                &random_elements,
+                batch_size,
+            );
+            let width = trace.width();
+            for i in 0..height {
+                let mut expected = vec![EF::zero(); width];
+                populate_permutation_row(
+                    &mut expected,
+                    &prep.values[i * 2..(i + 1) * 2],
+                    &main.values[i * 5..(i + 1) * 5],
+                    &sends,
+                    &receives,
+                    random_elements[0],
+                    random_elements[1].powers(),
+                    batch_size,
+                );
+                assert_eq!(
+                    trace.values[i * width..(i + 1) * width - 1],
+                    expected[..width - 1]
+                );
+            }
+        }
+    }
+}
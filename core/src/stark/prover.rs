@@ -3,6 +3,7 @@ use serde::Serialize;
 use std::cmp::Reverse;
 use std::marker::PhantomData;
 use std::sync::atomic::{AtomicU32, Ordering};
+use web_time::Instant;
 
 use itertools::Itertools;
 use p3_air::Air;
@@ -27,7 +28,7 @@ use crate::stark::record::MachineRecord;
 use crate::stark::MachineChip;
 use crate::stark::PackedChallenge;
 use crate::stark::ProverConstraintFolder;
-use crate::utils::SP1CoreOpts;
+use crate::utils::{metrics, SP1CoreOpts};
 
 fn chunk_vec<T>(mut vec: Vec<T>, chunk_size: usize) -> Vec<Vec<T>> {
     let mut result = Vec::new();
@@ -179,7 +180,18 @@ where
                     // to avoid the unnecessary span, remove the #[instrument] macro.
                     let trace =
                         tracing::debug_span!(parent: &parent_span, "generate trace for chip", %chip_name)
-                            .in_scope(|| chip.generate_trace(shard, &mut A::Record::default()));
+                            .in_scope(|| {
+                                metrics::time(
+                                    "sp1_chip_trace_generation_seconds",
+                                    &[("chip", &chip_name)],
+                                    || chip.generate_trace(shard, &mut A::Record::default()),
+                                )
+                            });
+                    metrics::increment_counter(
+                        "sp1_chip_trace_rows_total",
+                        &[("chip", &chip_name)],
+                        trace.height() as f64,
+                    );
                     (chip_name, trace)
                 })
                 .collect::<Vec<_>>()
@@ -199,7 +211,9 @@ where
             .collect::<Vec<_>>();
 
         // Commit to the batch of traces.
-        let (main_commit, main_data) = pcs.commit(domains_and_traces);
+        let (main_commit, main_data) = metrics::time("sp1_shard_main_commit_seconds", &[], || {
+            pcs.commit(domains_and_traces)
+        });
 
         // Get the chip ordering.
         let chip_ordering = named_traces
@@ -274,6 +288,7 @@ where
             .collect::<Vec<_>>();
 
         // Generate the permutation traces.
+        let permutation_start = Instant::now();
         let mut permutation_traces = Vec::with_capacity(chips.len());
         let mut cumulative_sums = Vec::with_capacity(chips.len());
         tracing::debug_span!("generate permutation traces").in_scope(|| {
@@ -334,6 +349,11 @@ where
             tracing::debug_span!("commit to permutation traces")
                 .in_scope(|| pcs.commit(domains_and_perm_traces));
         challenger.observe(permutation_commit.clone());
+        metrics::observe_histogram(
+            "sp1_shard_permutation_seconds",
+            &[],
+            permutation_start.elapsed().as_secs_f64(),
+        );
 
         // Compute the quotient polynomial for all chips.
 
@@ -347,6 +367,7 @@ where
             .collect::<Vec<_>>();
 
         // Compute the quotient values.
+        let quotient_start = Instant::now();
         let alpha: SC::Challenge = challenger.sample_ext_element::<SC::Challenge>();
         let parent_span = tracing::debug_span!("compute quotient values");
         let quotient_values = parent_span.in_scope(|| {
@@ -425,6 +446,11 @@ where
         let (quotient_commit, quotient_data) = tracing::debug_span!("commit to quotient traces")
             .in_scope(|| pcs.commit(quotient_domains_and_chunks));
         challenger.observe(quotient_commit.clone());
+        metrics::observe_histogram(
+            "sp1_shard_quotient_seconds",
+            &[],
+            quotient_start.elapsed().as_secs_f64(),
+        );
 
         // Compute the quotient argument.
         let zeta: SC::Challenge = challenger.sample_ext_element();
@@ -453,6 +479,7 @@ where
             .map(|_| vec![zeta])
             .collect::<Vec<_>>();
 
+        let opening_start = Instant::now();
         let (openings, opening_proof) = tracing::debug_span!("open multi batches").in_scope(|| {
             pcs.open(
                 vec![
@@ -465,6 +492,12 @@ where
             )
         });
 
+        metrics::observe_histogram(
+            "sp1_shard_opening_seconds",
+            &[],
+            opening_start.elapsed().as_secs_f64(),
+        );
+
         // Collect the opened values for each chip.
         let [preprocessed_values, main_values, permutation_values, mut quotient_values] =
             openings.try_into().unwrap();
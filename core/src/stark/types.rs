@@ -6,6 +6,7 @@ use std::{
 };
 
 use bincode::{deserialize_from, Error};
+use lz4_flex::frame::{FrameDecoder, FrameEncoder};
 use p3_matrix::dense::RowMajorMatrix;
 use p3_matrix::dense::RowMajorMatrixView;
 use p3_matrix::stack::VerticalPair;
@@ -17,6 +18,13 @@ use super::{Challenge, Com, OpeningProof, PcsProverData, StarkGenericConfig, Val
 
 pub type QuotientOpenedValues<T> = Vec<T>;
 
+/// The blowup of the low-degree extensions of the traces under the default FRI config. The
+/// committed data of a trace holds its extension alongside it.
+pub const LDE_BLOWUP: usize = 2;
+
+/// The number of bytes of a digest in the merkle trees of the default config.
+const DIGEST_SIZE_IN_BYTES: usize = 32;
+
 #[derive(Serialize, Deserialize)]
 #[serde(bound(serialize = "PcsProverData<SC>: Serialize"))]
 #[serde(bound(deserialize = "PcsProverData<SC>: Deserialize<'de>"))]
@@ -64,14 +72,62 @@ impl<SC: StarkGenericConfig> ShardMainData<SC> {
         Ok(ShardMainDataWrapper::TempFile(file, bytes_written))
     }
 
+    /// Saves the data to the file as an LZ4 compressed stream.
+    pub fn save_compressed(&self, file: File) -> Result<ShardMainDataWrapper<SC>, Error>
+    where
+        ShardMainData<SC>: Serialize,
+    {
+        let mut encoder = FrameEncoder::new(BufWriter::new(&file));
+        bincode::serialize_into(&mut encoder, self)?;
+        encoder
+            .finish()
+            .map_err(std::io::Error::from)?
+            .into_inner()
+            .map_err(|e| e.into_error())?;
+        let metadata = file.metadata()?;
+        let bytes_written = metadata.len();
+        trace!(
+            "wrote {} while saving compressed ShardMainData",
+            Size::from_bytes(bytes_written)
+        );
+        Ok(ShardMainDataWrapper::CompressedTempFile(
+            file,
+            bytes_written,
+        ))
+    }
+
     pub const fn to_in_memory(self) -> ShardMainDataWrapper<SC> {
         ShardMainDataWrapper::InMemory(self)
     }
+
+    /// The number of bytes taken by the main traces. The committed data kept alongside them is a
+    /// multiple of this, set by the blowup of the PCS.
+    pub fn trace_size_in_bytes(&self) -> usize {
+        self.traces
+            .iter()
+            .map(|trace| trace.values.len() * std::mem::size_of::<Val<SC>>())
+            .sum()
+    }
+
+    /// Estimates the number of bytes taken by the main data in memory: the main traces, their
+    /// low-degree extensions in the committed data and the merkle tree over the extensions, whose
+    /// leaves are the rows of the tallest extension.
+    pub fn size_in_bytes(&self) -> usize {
+        let max_height = self
+            .traces
+            .iter()
+            .map(|trace| trace.values.len() / trace.width.max(1))
+            .max()
+            .unwrap_or_default();
+        self.trace_size_in_bytes() * (1 + LDE_BLOWUP)
+            + 2 * max_height * LDE_BLOWUP * DIGEST_SIZE_IN_BYTES
+    }
 }
 
 pub enum ShardMainDataWrapper<SC: StarkGenericConfig> {
     InMemory(ShardMainData<SC>),
     TempFile(File, u64),
+    CompressedTempFile(File, u64),
     Empty(),
 }
 
@@ -88,6 +144,12 @@ impl<SC: StarkGenericConfig> ShardMainDataWrapper<SC> {
                 let data = deserialize_from(&mut buffer)?;
                 Ok(data)
             }
+            Self::CompressedTempFile(mut file, _) => {
+                file.seek(std::io::SeekFrom::Start(0))?;
+                let mut decoder = FrameDecoder::new(BufReader::new(&file));
+                let data = deserialize_from(&mut decoder)?;
+                Ok(data)
+            }
             Self::Empty() => unreachable!(),
         }
     }
@@ -57,12 +57,11 @@ impl Syscall for SyscallHintRead {
 
             // Save the data into runtime state so the runtime will use the desired data instead of
             // 0 when first reading/writing from this address.
-            ctx.rt
-                .state
-                .uninitialized_memory
-                .entry(ptr + i)
-                .and_modify(|_| panic!("hint read address is initialized already"))
-                .or_insert(word);
+            let uninitialized_memory = &mut ctx.rt.state.uninitialized_memory;
+            if uninitialized_memory.contains(ptr + i) {
+                panic!("hint read address is initialized already");
+            }
+            uninitialized_memory.insert(ptr + i, word);
         }
         None
     }
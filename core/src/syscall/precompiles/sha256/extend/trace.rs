@@ -1,15 +1,18 @@
 use p3_field::PrimeField32;
 use p3_matrix::dense::RowMajorMatrix;
-use p3_matrix::Matrix;
+use p3_maybe_rayon::prelude::*;
 use std::borrow::BorrowMut;
 
 use crate::{
     air::MachineAir,
-    bytes::event::ByteRecord,
     runtime::{ExecutionRecord, Program},
+    stark::MachineRecord,
 };
 
-use super::{ShaExtendChip, ShaExtendCols, NUM_SHA_EXTEND_COLS};
+use super::{ShaExtendChip, ShaExtendCols, ShaExtendEvent, NUM_SHA_EXTEND_COLS};
+
+/// The number of rows of a single extend event.
+const SHA_EXTEND_ROWS: usize = 48;
 
 impl<F: PrimeField32> MachineAir<F> for ShaExtendChip {
     type Record = ExecutionRecord;
@@ -25,153 +28,155 @@ impl<F: PrimeField32> MachineAir<F> for ShaExtendChip {
         input: &ExecutionRecord,
         output: &mut ExecutionRecord,
     ) -> RowMajorMatrix<F> {
-        let mut rows = Vec::new();
-
-        let mut new_byte_lookup_events = Vec::new();
-        for i in 0..input.sha_extend_events.len() {
-            let event = input.sha_extend_events[i].clone();
-            let shard = event.shard;
-            for j in 0..48usize {
-                let mut row = [F::zero(); NUM_SHA_EXTEND_COLS];
-                let cols: &mut ShaExtendCols<F> = row.as_mut_slice().borrow_mut();
-                cols.is_real = F::one();
-                cols.populate_flags(j);
-                cols.shard = F::from_canonical_u32(event.shard);
-                cols.channel = F::from_canonical_u32(event.channel);
-                cols.clk = F::from_canonical_u32(event.clk);
-                cols.w_ptr = F::from_canonical_u32(event.w_ptr);
-
-                cols.w_i_minus_15.populate(
-                    event.channel,
-                    event.w_i_minus_15_reads[j],
-                    &mut new_byte_lookup_events,
-                );
-                cols.w_i_minus_2.populate(
-                    event.channel,
-                    event.w_i_minus_2_reads[j],
-                    &mut new_byte_lookup_events,
-                );
-                cols.w_i_minus_16.populate(
-                    event.channel,
-                    event.w_i_minus_16_reads[j],
-                    &mut new_byte_lookup_events,
-                );
-                cols.w_i_minus_7.populate(
-                    event.channel,
-                    event.w_i_minus_7_reads[j],
-                    &mut new_byte_lookup_events,
-                );
-
-                // `s0 := (w[i-15] rightrotate 7) xor (w[i-15] rightrotate 18) xor (w[i-15] rightshift 3)`.
-                let w_i_minus_15 = event.w_i_minus_15_reads[j].value;
-                let w_i_minus_15_rr_7 =
-                    cols.w_i_minus_15_rr_7
-                        .populate(output, shard, event.channel, w_i_minus_15, 7);
-                let w_i_minus_15_rr_18 = cols.w_i_minus_15_rr_18.populate(
-                    output,
-                    shard,
-                    event.channel,
-                    w_i_minus_15,
-                    18,
-                );
-                let w_i_minus_15_rs_3 =
-                    cols.w_i_minus_15_rs_3
-                        .populate(output, shard, event.channel, w_i_minus_15, 3);
-                let s0_intermediate = cols.s0_intermediate.populate(
-                    output,
-                    shard,
-                    event.channel,
-                    w_i_minus_15_rr_7,
-                    w_i_minus_15_rr_18,
-                );
-                let s0 = cols.s0.populate(
-                    output,
-                    shard,
-                    event.channel,
-                    s0_intermediate,
-                    w_i_minus_15_rs_3,
-                );
-
-                // `s1 := (w[i-2] rightrotate 17) xor (w[i-2] rightrotate 19) xor (w[i-2] rightshift 10)`.
-                let w_i_minus_2 = event.w_i_minus_2_reads[j].value;
-                let w_i_minus_2_rr_17 =
-                    cols.w_i_minus_2_rr_17
-                        .populate(output, shard, event.channel, w_i_minus_2, 17);
-                let w_i_minus_2_rr_19 =
-                    cols.w_i_minus_2_rr_19
-                        .populate(output, shard, event.channel, w_i_minus_2, 19);
-                let w_i_minus_2_rs_10 =
-                    cols.w_i_minus_2_rs_10
-                        .populate(output, shard, event.channel, w_i_minus_2, 10);
-                let s1_intermediate = cols.s1_intermediate.populate(
-                    output,
-                    shard,
-                    event.channel,
-                    w_i_minus_2_rr_17,
-                    w_i_minus_2_rr_19,
-                );
-                let s1 = cols.s1.populate(
-                    output,
-                    shard,
-                    event.channel,
-                    s1_intermediate,
-                    w_i_minus_2_rs_10,
-                );
-
-                // Compute `s2`.
-                let w_i_minus_7 = event.w_i_minus_7_reads[j].value;
-                let w_i_minus_16 = event.w_i_minus_16_reads[j].value;
-                cols.s2.populate(
-                    output,
-                    shard,
-                    event.channel,
-                    w_i_minus_16,
-                    s0,
-                    w_i_minus_7,
-                    s1,
-                );
-
-                cols.w_i.populate(
-                    event.channel,
-                    event.w_i_writes[j],
-                    &mut new_byte_lookup_events,
-                );
-
-                rows.push(row);
-            }
-        }
-
-        output.add_byte_lookup_events(new_byte_lookup_events);
-
-        let nb_rows = rows.len();
+        let num_events = input.sha_extend_events.len();
+        let nb_rows = num_events * SHA_EXTEND_ROWS;
         let mut padded_nb_rows = nb_rows.next_power_of_two();
         if padded_nb_rows == 2 || padded_nb_rows == 1 {
             padded_nb_rows = 4;
         }
-        for i in nb_rows..padded_nb_rows {
-            let mut row = [F::zero(); NUM_SHA_EXTEND_COLS];
-            let cols: &mut ShaExtendCols<F> = row.as_mut_slice().borrow_mut();
-            cols.populate_flags(i);
-            rows.push(row);
+        let mut values = vec![F::zero(); padded_nb_rows * NUM_SHA_EXTEND_COLS];
+        let (real_values, padding_values) = values.split_at_mut(nb_rows * NUM_SHA_EXTEND_COLS);
+
+        // Fill the rows of a chunk of events on each thread, in place in the trace.
+        let chunk_size = std::cmp::max(num_events / num_cpus::get(), 1);
+        let records = real_values
+            .par_chunks_mut(chunk_size * SHA_EXTEND_ROWS * NUM_SHA_EXTEND_COLS)
+            .zip(input.sha_extend_events.par_chunks(chunk_size))
+            .map(|(rows, events)| {
+                let mut record = ExecutionRecord::default();
+                for (event, event_rows) in events
+                    .iter()
+                    .zip(rows.chunks_mut(SHA_EXTEND_ROWS * NUM_SHA_EXTEND_COLS))
+                {
+                    self.event_to_rows(event, event_rows, &mut record);
+                }
+                record
+            })
+            .collect::<Vec<_>>();
+        for mut record in records {
+            output.append(&mut record);
         }
 
-        // Convert the trace to a row major matrix.
-        let mut trace = RowMajorMatrix::new(
-            rows.into_iter().flatten().collect::<Vec<_>>(),
-            NUM_SHA_EXTEND_COLS,
-        );
+        // Populate the cycle flags of the padding rows.
+        padding_values
+            .par_chunks_mut(NUM_SHA_EXTEND_COLS)
+            .enumerate()
+            .for_each(|(i, row)| {
+                let cols: &mut ShaExtendCols<F> = row.borrow_mut();
+                cols.populate_flags(nb_rows + i);
+            });
 
         // Write the nonces to the trace.
-        for i in 0..trace.height() {
-            let cols: &mut ShaExtendCols<F> =
-                trace.values[i * NUM_SHA_EXTEND_COLS..(i + 1) * NUM_SHA_EXTEND_COLS].borrow_mut();
-            cols.nonce = F::from_canonical_usize(i);
-        }
-
-        trace
+        values
+            .par_chunks_mut(NUM_SHA_EXTEND_COLS)
+            .enumerate()
+            .for_each(|(i, row)| {
+                let cols: &mut ShaExtendCols<F> = row.borrow_mut();
+                cols.nonce = F::from_canonical_usize(i);
+            });
+
+        RowMajorMatrix::new(values, NUM_SHA_EXTEND_COLS)
     }
 
     fn included(&self, shard: &Self::Record) -> bool {
         !shard.sha_extend_events.is_empty()
     }
 }
+
+impl ShaExtendChip {
+    /// Fills the rows of an event, adding its byte lookups to the record.
+    fn event_to_rows<F: PrimeField32>(
+        &self,
+        event: &ShaExtendEvent,
+        rows: &mut [F],
+        record: &mut ExecutionRecord,
+    ) {
+        let shard = event.shard;
+        for (j, row) in rows.chunks_mut(NUM_SHA_EXTEND_COLS).enumerate() {
+            let cols: &mut ShaExtendCols<F> = row.borrow_mut();
+            cols.is_real = F::one();
+            cols.populate_flags(j);
+            cols.shard = F::from_canonical_u32(event.shard);
+            cols.channel = F::from_canonical_u32(event.channel);
+            cols.clk = F::from_canonical_u32(event.clk);
+            cols.w_ptr = F::from_canonical_u32(event.w_ptr);
+
+            cols.w_i_minus_15
+                .populate(event.channel, event.w_i_minus_15_reads[j], record);
+            cols.w_i_minus_2
+                .populate(event.channel, event.w_i_minus_2_reads[j], record);
+            cols.w_i_minus_16
+                .populate(event.channel, event.w_i_minus_16_reads[j], record);
+            cols.w_i_minus_7
+                .populate(event.channel, event.w_i_minus_7_reads[j], record);
+
+            // `s0 := (w[i-15] rightrotate 7) xor (w[i-15] rightrotate 18) xor (w[i-15] rightshift 3)`.
+            let w_i_minus_15 = event.w_i_minus_15_reads[j].value;
+            let w_i_minus_15_rr_7 =
+                cols.w_i_minus_15_rr_7
+                    .populate(record, shard, event.channel, w_i_minus_15, 7);
+            let w_i_minus_15_rr_18 =
+                cols.w_i_minus_15_rr_18
+                    .populate(record, shard, event.channel, w_i_minus_15, 18);
+            let w_i_minus_15_rs_3 =
+                cols.w_i_minus_15_rs_3
+                    .populate(record, shard, event.channel, w_i_minus_15, 3);
+            let s0_intermediate = cols.s0_intermediate.populate(
+                record,
+                shard,
+                event.channel,
+                w_i_minus_15_rr_7,
+                w_i_minus_15_rr_18,
+            );
+            let s0 = cols.s0.populate(
+                record,
+                shard,
+                event.channel,
+                s0_intermediate,
+                w_i_minus_15_rs_3,
+            );
+
+            // `s1 := (w[i-2] rightrotate 17) xor (w[i-2] rightrotate 19) xor (w[i-2] rightshift 10)`.
+            let w_i_minus_2 = event.w_i_minus_2_reads[j].value;
+            let w_i_minus_2_rr_17 =
+                cols.w_i_minus_2_rr_17
+                    .populate(record, shard, event.channel, w_i_minus_2, 17);
+            let w_i_minus_2_rr_19 =
+                cols.w_i_minus_2_rr_19
+                    .populate(record, shard, event.channel, w_i_minus_2, 19);
+            let w_i_minus_2_rs_10 =
+                cols.w_i_minus_2_rs_10
+                    .populate(record, shard, event.channel, w_i_minus_2, 10);
+            let s1_intermediate = cols.s1_intermediate.populate(
+                record,
+                shard,
+                event.channel,
+                w_i_minus_2_rr_17,
+                w_i_minus_2_rr_19,
+            );
+            let s1 = cols.s1.populate(
+                record,
+                shard,
+                event.channel,
+                s1_intermediate,
+                w_i_minus_2_rs_10,
+            );
+
+            // Compute `s2`.
+            let w_i_minus_7 = event.w_i_minus_7_reads[j].value;
+            let w_i_minus_16 = event.w_i_minus_16_reads[j].value;
+            cols.s2.populate(
+                record,
+                shard,
+                event.channel,
+                w_i_minus_16,
+                s0,
+                w_i_minus_7,
+                s1,
+            );
+
+            cols.w_i
+                .populate(event.channel, event.w_i_writes[j], record);
+        }
+    }
+}
@@ -1,6 +1,4 @@
-use std::collections::HashMap;
-
-use crate::runtime::{ForkState, Syscall, SyscallContext};
+use crate::runtime::{ForkState, MemorySnapshot, Syscall, SyscallContext};
 
 pub struct SyscallEnterUnconstrained;
 
@@ -16,11 +14,12 @@ impl Syscall for SyscallEnterUnconstrained {
             panic!("Unconstrained block is already active.");
         }
         ctx.rt.unconstrained = true;
+        ctx.rt.state.memory.clear_dirty();
         ctx.rt.unconstrained_state = ForkState {
             global_clk: ctx.rt.state.global_clk,
             clk: ctx.rt.state.clk,
             pc: ctx.rt.state.pc,
-            memory_diff: HashMap::default(),
+            memory_diff: MemorySnapshot::default(),
             record: std::mem::take(&mut ctx.rt.record),
             op_record: std::mem::take(&mut ctx.rt.memory_accesses),
             emit_events: ctx.rt.emit_events,
@@ -46,16 +45,8 @@ impl Syscall for SyscallExitUnconstrained {
             ctx.rt.state.clk = ctx.rt.unconstrained_state.clk;
             ctx.rt.state.pc = ctx.rt.unconstrained_state.pc;
             ctx.next_pc = ctx.rt.state.pc.wrapping_add(4);
-            for (addr, value) in ctx.rt.unconstrained_state.memory_diff.drain() {
-                match value {
-                    Some(value) => {
-                        ctx.rt.state.memory.insert(addr, value);
-                    }
-                    None => {
-                        ctx.rt.state.memory.remove(&addr);
-                    }
-                }
-            }
+            let memory_diff = std::mem::take(&mut ctx.rt.unconstrained_state.memory_diff);
+            ctx.rt.state.memory.restore(memory_diff);
             ctx.rt.record = std::mem::take(&mut ctx.rt.unconstrained_state.record);
             ctx.rt.memory_accesses = std::mem::take(&mut ctx.rt.unconstrained_state.op_record);
             ctx.rt.emit_events = ctx.rt.unconstrained_state.emit_events;
@@ -0,0 +1,305 @@
+//! Core proving split into tasks that can run on other nodes.
+//!
+//! A coordinator executes the program and commits to every shard with [plan_shard_tasks], which
+//! yields a [ShardProveTask] per checkpoint. Each task holds everything a worker needs to prove
+//! the shards of its checkpoint besides the program and its proving key, which the worker sets up
+//! once and which the task references by the [program_digest]. The shard proofs are assembled into
+//! a [MachineProof] with [merge_shard_results].
+
+use std::io::Read;
+use std::sync::Arc;
+
+use p3_challenger::CanObserve;
+use p3_field::PrimeField32;
+use serde::de::DeserializeOwned;
+use serde::{Deserialize, Serialize};
+
+use super::prove::{
+    choose_sharding, collect_checkpoints, prove_shard_data, replay_checkpoints, trace_checkpoint,
+    SP1CoreProverError,
+};
+use crate::air::PublicValues;
+use crate::io::SP1Stdin;
+use crate::runtime::{Program, Runtime, ShardingConfig, SubproofVerifier};
+use crate::stark::{
+    Com, LocalProver, MachineProof, MachineRecord, OpeningProof, PcsProverData, RiscvAir,
+    ShardMainData, ShardProof, StarkGenericConfig, StarkMachine, StarkProvingKey, Val,
+};
+use crate::utils::SP1CoreOpts;
+
+/// Returns the digest that identifies a program, and therefore its proving key, across nodes.
+pub fn program_digest(program: &Program) -> [u8; 32] {
+    let bytes = bincode::serialize(program).expect("failed to serialize program");
+    blake3::hash(&bytes).into()
+}
+
+/// The values observed by the challenger after the proving key: the main commitment and the
+/// public values of every shard, in shard order.
+#[derive(Serialize, Deserialize, Clone)]
+#[serde(bound = "")]
+pub struct ChallengerTranscript<SC: StarkGenericConfig> {
+    pub shards: Vec<(Com<SC>, Vec<Val<SC>>)>,
+}
+
+impl<SC: StarkGenericConfig> ChallengerTranscript<SC> {
+    /// Replays the transcript into a new challenger, which is then in the state that every shard
+    /// proof starts from.
+    pub fn challenger(&self, config: &SC, pk: &StarkProvingKey<SC>) -> SC::Challenger {
+        let mut challenger = config.challenger();
+        pk.observe_into(&mut challenger);
+        for (commitment, public_values) in self.shards.iter() {
+            challenger.observe(commitment.clone());
+            challenger.observe_slice(public_values);
+        }
+        challenger
+    }
+}
+
+/// The proving of the shards of a checkpoint.
+#[derive(Serialize, Deserialize, Clone)]
+#[serde(bound = "")]
+pub struct ShardProveTask<SC: StarkGenericConfig> {
+    /// The index of the checkpoint, which orders the results.
+    pub checkpoint_num: usize,
+    /// The checkpoint, as written by [crate::runtime::ExecutionState::write_checkpoint].
+    pub checkpoint: Vec<u8>,
+    /// The public values of the whole execution, which every shard record carries.
+    pub public_values: PublicValues<u32, u32>,
+    /// The [program_digest] of the program to re-execute and of its proving key.
+    pub program_digest: [u8; 32],
+    /// The options the checkpoint was executed with, which determine its shards.
+    pub opts: SP1CoreOpts,
+    /// The config the records of the checkpoint are sharded with, chosen with the options.
+    pub sharding_config: ShardingConfig,
+    pub transcript: Arc<ChallengerTranscript<SC>>,
+}
+
+/// The shard proofs of a checkpoint.
+#[derive(Serialize, Deserialize, Clone)]
+#[serde(bound = "")]
+pub struct ShardProveResult<SC: StarkGenericConfig> {
+    pub checkpoint_num: usize,
+    pub shard_proofs: Vec<ShardProof<SC>>,
+}
+
+/// Executes the program and commits to its shards, returning a task per checkpoint along with
+/// the public values stream.
+///
+/// The checkpoints are re-executed once here to observe the shard commitments, as in
+/// [super::prove_with_subproof_verifier], and once more by the worker that proves them.
+pub fn plan_shard_tasks<SC: StarkGenericConfig + Send + Sync, V: SubproofVerifier>(
+    program: Program,
+    stdin: &SP1Stdin,
+    config: SC,
+    opts: SP1CoreOpts,
+    subproof_verifier: Option<Arc<V>>,
+) -> Result<(Vec<ShardProveTask<SC>>, Vec<u8>), SP1CoreProverError>
+where
+    SC::Challenger: Clone,
+    OpeningProof<SC>: Send + Sync,
+    Com<SC>: Send + Sync,
+    PcsProverData<SC>: Send + Sync,
+    ShardMainData<SC>: Serialize + DeserializeOwned,
+    <SC as StarkGenericConfig>::Val: PrimeField32,
+{
+    assert!(
+        opts.shard_batch_size > 0,
+        "distributed proving needs checkpoints, so the shard batch size must not be zero"
+    );
+
+    // Choose the shard sizes as the local prover does, so that the tasks honor the memory budget.
+    let machine = RiscvAir::machine(config);
+    let (opts, sharding_config) = choose_sharding(&machine, &program, stdin, opts)?;
+
+    // Execute the program, saving the checkpoints.
+    let mut runtime = Runtime::new(program.clone(), opts);
+    runtime.write_vecs(&stdin.buffer);
+    for proof in stdin.proofs.iter() {
+        runtime.write_proof(proof.0.clone(), proof.1.clone());
+    }
+    if let Some(deferred_fn) = subproof_verifier {
+        runtime.subproof_verifier = deferred_fn;
+    }
+    let (mut checkpoints, public_values_stream, public_values) = collect_checkpoints(&mut runtime)?;
+
+    // Commit to the shards of each checkpoint and record what the challenger observes.
+    let mut commit_opts = opts;
+    commit_opts.reconstruct_commitments = true;
+    let mut transcript = ChallengerTranscript { shards: Vec::new() };
+    replay_checkpoints(
+        &machine,
+        &program,
+        &mut checkpoints,
+        public_values,
+        &sharding_config,
+        opts,
+        |num, checkpoint_shards, _| {
+            let (commitments, _) = tracing::info_span!("commit_checkpoint", num)
+                .in_scope(|| LocalProver::commit_shards(&machine, &checkpoint_shards, commit_opts));
+            for (commitment, shard) in commitments.into_iter().zip(checkpoint_shards.iter()) {
+                let shard_public_values =
+                    shard.public_values::<SC::Val>()[0..machine.num_pv_elts()].to_vec();
+                transcript.shards.push((commitment, shard_public_values));
+            }
+        },
+    );
+
+    let transcript = Arc::new(transcript);
+    let program_digest = program_digest(&program);
+    let tasks = checkpoints
+        .iter_mut()
+        .enumerate()
+        .map(|(checkpoint_num, file)| {
+            let mut checkpoint = Vec::new();
+            file.read_to_end(&mut checkpoint)
+                .map_err(SP1CoreProverError::IoError)?;
+            Ok(ShardProveTask {
+                checkpoint_num,
+                checkpoint,
+                public_values,
+                program_digest,
+                opts,
+                sharding_config,
+                transcript: transcript.clone(),
+            })
+        })
+        .collect::<Result<Vec<_>, _>>()?;
+    Ok((tasks, public_values_stream))
+}
+
+/// Proves the shards of the task's checkpoint with the proving key of its program.
+pub fn prove_shard_task<SC>(
+    machine: &StarkMachine<SC, RiscvAir<SC::Val>>,
+    program: &Program,
+    pk: &StarkProvingKey<SC>,
+    task: &ShardProveTask<SC>,
+) -> ShardProveResult<SC>
+where
+    SC: StarkGenericConfig + Send + Sync,
+    SC::Val: PrimeField32,
+    SC::Challenger: Clone,
+    Com<SC>: Send + Sync,
+    PcsProverData<SC>: Send + Sync,
+    ShardMainData<SC>: Serialize + DeserializeOwned,
+{
+    assert_eq!(
+        program_digest(program),
+        task.program_digest,
+        "the task is for a different program"
+    );
+    let challenger = task.transcript.challenger(machine.config(), pk);
+
+    let num = task.checkpoint_num;
+    let (mut record, _) = tracing::info_span!("trace_checkpoint", num)
+        .in_scope(|| trace_checkpoint(program.clone(), task.checkpoint.as_slice(), task.opts));
+    record.public_values = task.public_values;
+    let shards =
+        tracing::debug_span!("shard").in_scope(|| machine.shard(record, &task.sharding_config));
+
+    let shard_proofs = tracing::info_span!("prove_checkpoint", num).in_scope(|| {
+        shards
+            .iter()
+            .map(|shard| {
+                let data = LocalProver::commit_main(
+                    machine.config(),
+                    machine,
+                    shard,
+                    shard.index() as usize,
+                );
+                prove_shard_data(machine, pk, data, &challenger)
+            })
+            .collect()
+    });
+    ShardProveResult {
+        checkpoint_num: num,
+        shard_proofs,
+    }
+}
+
+/// Assembles the proof from the results of all `num_tasks` tasks, given in any order.
+pub fn merge_shard_results<SC: StarkGenericConfig>(
+    num_tasks: usize,
+    mut results: Vec<ShardProveResult<SC>>,
+) -> MachineProof<SC> {
+    results.sort_by_key(|result| result.checkpoint_num);
+    assert_eq!(
+        results.len(),
+        num_tasks,
+        "expected the results of {num_tasks} tasks"
+    );
+    for (num, result) in results.iter().enumerate() {
+        assert_eq!(
+            result.checkpoint_num, num,
+            "missing or duplicate result for checkpoint {num}"
+        );
+    }
+    MachineProof {
+        shard_proofs: results
+            .into_iter()
+            .flat_map(|result| result.shard_proofs)
+            .collect(),
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::runtime::DefaultSubproofVerifier;
+    use crate::utils::tests::FIBONACCI_ELF;
+    use crate::utils::{setup_logger, AdaptiveShardingOpts, BabyBearPoseidon2};
+
+    #[test]
+    fn test_distributed_prove_verifies() {
+        setup_logger();
+        let program = Program::from(FIBONACCI_ELF);
+        let mut opts = SP1CoreOpts::default();
+        opts.shard_size = 1024;
+        opts.shard_batch_size = 2;
+        let (tasks, _) = plan_shard_tasks::<_, DefaultSubproofVerifier>(
+            program.clone(),
+            &SP1Stdin::new(),
+            BabyBearPoseidon2::new(),
+            opts,
+            None,
+        )
+        .unwrap();
+
+        // Round-trip the tasks through bytes, as they would be sent to the workers.
+        let machine = RiscvAir::machine(BabyBearPoseidon2::new());
+        let (pk, vk) = machine.setup(&program);
+        let results = tasks
+            .iter()
+            .rev()
+            .map(|task| {
+                let bytes = bincode::serialize(task).unwrap();
+                let task: ShardProveTask<BabyBearPoseidon2> = bincode::deserialize(&bytes).unwrap();
+                prove_shard_task(&machine, &program, &pk, &task)
+            })
+            .collect();
+        let proof = merge_shard_results(tasks.len(), results);
+
+        let mut challenger = machine.config().challenger();
+        machine.verify(&vk, &proof, &mut challenger).unwrap();
+    }
+
+    #[test]
+    fn test_distributed_adaptive_sharding() {
+        let mut opts = SP1CoreOpts::default();
+        opts.shard_batch_size = 2;
+        opts.adaptive_sharding = Some(AdaptiveShardingOpts {
+            memory_budget: 1 << 30,
+            num_cores: 2,
+        });
+        let (tasks, _) = plan_shard_tasks::<_, DefaultSubproofVerifier>(
+            Program::from(FIBONACCI_ELF),
+            &SP1Stdin::new(),
+            BabyBearPoseidon2::new(),
+            opts,
+            None,
+        )
+        .unwrap();
+        for task in tasks.iter() {
+            assert_eq!(task.sharding_config.shard_size, task.opts.shard_size);
+        }
+    }
+}
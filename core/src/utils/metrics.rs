@@ -0,0 +1,386 @@
+//! Opt-in metrics of the prover, exposed in the Prometheus text format.
+//!
+//! Metrics are only recorded if [METRICS_ADDR_ENV] is set, in which case they are served at
+//! `/metrics` on that address for the lifetime of the process. Otherwise every recording function
+//! returns right away. Components that keep their own metrics, such as the gnark prover in Go, add
+//! them to the output with [register_collector].
+//!
+//! Histograms are of durations in seconds.
+
+use std::collections::BTreeMap;
+use std::fmt::Write as _;
+use std::io::{BufRead, BufReader, Write};
+use std::net::{TcpListener, TcpStream};
+use std::sync::{Mutex, OnceLock};
+use std::time::Duration;
+use web_time::Instant;
+
+/// The environment variable with the address to serve the metrics on, such as `0.0.0.0:9100`.
+pub const METRICS_ADDR_ENV: &str = "SP1_METRICS_ADDR";
+
+/// The upper bounds of the histogram buckets, in seconds.
+const BUCKETS: [f64; 16] = [
+    0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0, 30.0, 60.0, 300.0,
+];
+
+type Labels = Vec<(&'static str, String)>;
+
+#[derive(Default)]
+struct Histogram {
+    /// The number of observations in each bucket, not cumulative.
+    buckets: [u64; BUCKETS.len()],
+    sum: f64,
+    count: u64,
+}
+
+#[derive(Default)]
+struct Registry {
+    counters: BTreeMap<&'static str, BTreeMap<Labels, f64>>,
+    gauges: BTreeMap<&'static str, BTreeMap<Labels, f64>>,
+    histograms: BTreeMap<&'static str, BTreeMap<Labels, Histogram>>,
+    collectors: Vec<fn() -> String>,
+}
+
+static REGISTRY: OnceLock<Option<Mutex<Registry>>> = OnceLock::new();
+
+/// Returns the registry, starting the metrics server on first use if metrics are enabled.
+fn registry() -> Option<&'static Mutex<Registry>> {
+    REGISTRY
+        .get_or_init(|| {
+            let addr = std::env::var(METRICS_ADDR_ENV).ok()?;
+            match TcpListener::bind(&addr) {
+                Ok(listener) => {
+                    tracing::info!("serving metrics on {}", addr);
+                    std::thread::spawn(move || serve(listener));
+                    Some(Mutex::new(Registry::default()))
+                }
+                Err(e) => {
+                    tracing::warn!("failed to serve metrics on {}: {}", addr, e);
+                    None
+                }
+            }
+        })
+        .as_ref()
+}
+
+fn labels(labels: &[(&'static str, &str)]) -> Labels {
+    labels
+        .iter()
+        .map(|(name, value)| (*name, value.to_string()))
+        .collect()
+}
+
+/// Returns whether metrics are recorded, starting the metrics server if they are.
+pub fn enabled() -> bool {
+    registry().is_some()
+}
+
+/// Adds the value to a counter, whose name should end in `_total`.
+pub fn increment_counter(name: &'static str, label_values: &[(&'static str, &str)], value: f64) {
+    if let Some(registry) = registry() {
+        registry
+            .lock()
+            .unwrap()
+            .increment_counter(name, label_values, value);
+    }
+}
+
+/// Sets a gauge to the value.
+pub fn set_gauge(name: &'static str, label_values: &[(&'static str, &str)], value: f64) {
+    if let Some(registry) = registry() {
+        registry
+            .lock()
+            .unwrap()
+            .set_gauge(name, label_values, value);
+    }
+}
+
+/// Records an observation of a duration in seconds.
+pub fn observe_histogram(name: &'static str, label_values: &[(&'static str, &str)], value: f64) {
+    if let Some(registry) = registry() {
+        registry
+            .lock()
+            .unwrap()
+            .observe_histogram(name, label_values, value);
+    }
+}
+
+/// Runs `f`, recording its duration in the histogram if metrics are enabled.
+pub fn time<T>(
+    name: &'static str,
+    label_values: &[(&'static str, &str)],
+    f: impl FnOnce() -> T,
+) -> T {
+    if !enabled() {
+        return f();
+    }
+    let start = Instant::now();
+    let result = f();
+    observe_histogram(name, label_values, start.elapsed().as_secs_f64());
+    result
+}
+
+/// Sets `sp1_peak_rss_bytes` for the phase to the peak resident set size of the process so far.
+/// Only supported on Linux.
+pub fn record_peak_rss(phase: &str) {
+    if !enabled() {
+        return;
+    }
+    let peak_kb = std::fs::read_to_string("/proc/self/status")
+        .ok()
+        .and_then(|status| {
+            status
+                .lines()
+                .find_map(|line| line.strip_prefix("VmHWM:"))
+                .and_then(|value| {
+                    value
+                        .trim()
+                        .trim_end_matches("kB")
+                        .trim()
+                        .parse::<f64>()
+                        .ok()
+                })
+        });
+    if let Some(peak_kb) = peak_kb {
+        set_gauge("sp1_peak_rss_bytes", &[("phase", phase)], peak_kb * 1024.0);
+    }
+}
+
+/// Registers a function that returns more metrics in the text format, which is appended to the
+/// output on every scrape. Registering the same function again has no effect.
+pub fn register_collector(collector: fn() -> String) {
+    if let Some(registry) = registry() {
+        let mut registry = registry.lock().unwrap();
+        if !registry.collectors.contains(&collector) {
+            registry.collectors.push(collector);
+        }
+    }
+}
+
+fn write_labels(out: &mut String, labels: &Labels, extra: Option<(&str, &str)>) {
+    let labels = labels
+        .iter()
+        .map(|(name, value)| (*name, value.as_str()))
+        .chain(extra)
+        .collect::<Vec<_>>();
+    if labels.is_empty() {
+        return;
+    }
+    out.push('{');
+    for (i, (name, value)) in labels.iter().enumerate() {
+        if i > 0 {
+            out.push(',');
+        }
+        let value = value
+            .replace('\\', "\\\\")
+            .replace('"', "\\\"")
+            .replace('\n', "\\n");
+        write!(out, "{}=\"{}\"", name, value).unwrap();
+    }
+    out.push('}');
+}
+
+/// Renders all metrics in the Prometheus text format. Returns an empty string if metrics are not
+/// enabled.
+pub fn render() -> String {
+    let Some(registry) = registry() else {
+        return String::new();
+    };
+    let (mut out, collectors) = {
+        let registry = registry.lock().unwrap();
+        (registry.render(), registry.collectors.clone())
+    };
+
+    // Collect outside of the lock, as collectors may record metrics themselves.
+    for collector in collectors {
+        out.push_str(&collector());
+    }
+    out
+}
+
+impl Registry {
+    fn increment_counter(
+        &mut self,
+        name: &'static str,
+        label_values: &[(&'static str, &str)],
+        value: f64,
+    ) {
+        *self
+            .counters
+            .entry(name)
+            .or_default()
+            .entry(labels(label_values))
+            .or_default() += value;
+    }
+
+    fn set_gauge(&mut self, name: &'static str, label_values: &[(&'static str, &str)], value: f64) {
+        self.gauges
+            .entry(name)
+            .or_default()
+            .insert(labels(label_values), value);
+    }
+
+    fn observe_histogram(
+        &mut self,
+        name: &'static str,
+        label_values: &[(&'static str, &str)],
+        value: f64,
+    ) {
+        let histogram = self
+            .histograms
+            .entry(name)
+            .or_default()
+            .entry(labels(label_values))
+            .or_default();
+        if let Some(bucket) = BUCKETS.iter().position(|bound| value <= *bound) {
+            histogram.buckets[bucket] += 1;
+        }
+        histogram.sum += value;
+        histogram.count += 1;
+    }
+
+    /// Renders the metrics of the registry in the Prometheus text format, without the output of
+    /// the collectors.
+    fn render(&self) -> String {
+        let mut out = String::new();
+        for (kind, families) in [("counter", &self.counters), ("gauge", &self.gauges)] {
+            for (name, series) in families {
+                writeln!(out, "# TYPE {} {}", name, kind).unwrap();
+                for (labels, value) in series {
+                    out.push_str(name);
+                    write_labels(&mut out, labels, None);
+                    writeln!(out, " {}", value).unwrap();
+                }
+            }
+        }
+        for (name, series) in &self.histograms {
+            writeln!(out, "# TYPE {} histogram", name).unwrap();
+            for (labels, histogram) in series {
+                let mut cumulative = 0;
+                for (bound, count) in BUCKETS.iter().zip(histogram.buckets.iter()) {
+                    cumulative += count;
+                    write!(out, "{}_bucket", name).unwrap();
+                    write_labels(&mut out, labels, Some(("le", &bound.to_string())));
+                    writeln!(out, " {}", cumulative).unwrap();
+                }
+                write!(out, "{}_bucket", name).unwrap();
+                write_labels(&mut out, labels, Some(("le", "+Inf")));
+                writeln!(out, " {}", histogram.count).unwrap();
+                write!(out, "{}_sum", name).unwrap();
+                write_labels(&mut out, labels, None);
+                writeln!(out, " {}", histogram.sum).unwrap();
+                write!(out, "{}_count", name).unwrap();
+                write_labels(&mut out, labels, None);
+                writeln!(out, " {}", histogram.count).unwrap();
+            }
+        }
+        out
+    }
+}
+
+/// How long a connection may stall while its request is read or the response is written, so that
+/// a client that never finishes its request cannot hang the single-threaded server.
+const REQUEST_TIMEOUT: Duration = Duration::from_secs(5);
+
+/// Answers every request on the listener with the metrics.
+fn serve(listener: TcpListener) {
+    for stream in listener.incoming().flatten() {
+        if let Err(e) = respond(stream, render) {
+            tracing::debug!("failed to serve metrics: {}", e);
+        }
+    }
+}
+
+/// Answers a request for `/metrics` with the output of `render`, and any other request with a 404.
+fn respond(mut stream: TcpStream, render: impl FnOnce() -> String) -> std::io::Result<()> {
+    stream.set_read_timeout(Some(REQUEST_TIMEOUT))?;
+    stream.set_write_timeout(Some(REQUEST_TIMEOUT))?;
+
+    // Read the request up to the blank line that ends its headers.
+    let mut reader = BufReader::new(stream.try_clone()?);
+    let mut request_line = String::new();
+    reader.read_line(&mut request_line)?;
+    let mut line = String::new();
+    while reader.read_line(&mut line)? > 2 {
+        line.clear();
+    }
+
+    let (status, body) = match request_line.split_whitespace().nth(1) {
+        Some("/metrics") => ("200 OK", render()),
+        _ => ("404 Not Found", String::new()),
+    };
+    write!(
+        stream,
+        "HTTP/1.1 {}\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: {}\r\n\
+         Connection: close\r\n\r\n{}",
+        status,
+        body.len(),
+        body
+    )?;
+    stream.flush()
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::io::Read;
+
+    #[test]
+    fn test_render_registry() {
+        let mut registry = Registry::default();
+        registry.increment_counter("sp1_shards_total", &[("stage", "core")], 2.0);
+        registry.increment_counter("sp1_shards_total", &[("stage", "core")], 1.0);
+        registry.set_gauge("sp1_peak_rss_bytes", &[("phase", "a \"b\"\\\nc")], 1024.0);
+        registry.observe_histogram("sp1_prove_seconds", &[("stage", "core")], 0.0625);
+        registry.observe_histogram("sp1_prove_seconds", &[("stage", "core")], 0.25);
+        registry.observe_histogram("sp1_prove_seconds", &[("stage", "core")], 1000.0);
+
+        let out = registry.render();
+        let lines = out.lines().collect::<Vec<_>>();
+        assert!(lines.contains(&"# TYPE sp1_shards_total counter"));
+        assert!(lines.contains(&"sp1_shards_total{stage=\"core\"} 3"));
+        assert!(lines.contains(&"# TYPE sp1_peak_rss_bytes gauge"));
+        assert!(lines.contains(&r#"sp1_peak_rss_bytes{phase="a \"b\"\\\nc"} 1024"#));
+        assert!(lines.contains(&"# TYPE sp1_prove_seconds histogram"));
+        assert!(lines.contains(&r#"sp1_prove_seconds_bucket{stage="core",le="0.05"} 0"#));
+        assert!(lines.contains(&r#"sp1_prove_seconds_bucket{stage="core",le="0.1"} 1"#));
+        assert!(lines.contains(&r#"sp1_prove_seconds_bucket{stage="core",le="0.25"} 2"#));
+        assert!(lines.contains(&r#"sp1_prove_seconds_bucket{stage="core",le="300"} 2"#));
+        assert!(lines.contains(&r#"sp1_prove_seconds_bucket{stage="core",le="+Inf"} 3"#));
+        assert!(lines.contains(&r#"sp1_prove_seconds_sum{stage="core"} 1000.3125"#));
+        assert!(lines.contains(&r#"sp1_prove_seconds_count{stage="core"} 3"#));
+
+        // The buckets of a histogram are cumulative and in increasing order.
+        let buckets = lines
+            .iter()
+            .filter(|line| line.starts_with("sp1_prove_seconds_bucket"))
+            .map(|line| line.rsplit(' ').next().unwrap().parse::<u64>().unwrap())
+            .collect::<Vec<_>>();
+        assert_eq!(buckets.len(), BUCKETS.len() + 1);
+        assert!(buckets.windows(2).all(|pair| pair[0] <= pair[1]));
+    }
+
+    #[test]
+    fn test_respond() {
+        let listener = TcpListener::bind("127.0.0.1:0").unwrap();
+        let addr = listener.local_addr().unwrap();
+        let request = |path: &str| {
+            let mut client = TcpStream::connect(addr).unwrap();
+            write!(client, "GET {} HTTP/1.1\r\nHost: localhost\r\n\r\n", path).unwrap();
+            let (stream, _) = listener.accept().unwrap();
+            respond(stream, || "up 1\n".to_string()).unwrap();
+            let mut response = String::new();
+            client.read_to_string(&mut response).unwrap();
+            response
+        };
+
+        let response = request("/metrics");
+        assert!(response.starts_with("HTTP/1.1 200 OK\r\n"));
+        assert!(response.contains("Content-Length: 5\r\n"));
+        assert!(response.ends_with("\r\n\r\nup 1\n"));
+
+        let response = request("/");
+        assert!(response.starts_with("HTTP/1.1 404 Not Found\r\n"));
+        assert!(response.ends_with("Content-Length: 0\r\nConnection: close\r\n\r\n"));
+    }
+}
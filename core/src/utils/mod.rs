@@ -1,18 +1,23 @@
 mod buffer;
 mod config;
+mod distributed;
 pub mod ec;
 mod logger;
+pub mod metrics;
 mod options;
 #[cfg(any(test, feature = "programs"))]
 mod programs;
 mod prove;
+mod sharding;
 mod tracer;
 
 pub use buffer::*;
 pub use config::*;
+pub use distributed::*;
 pub use logger::*;
 pub use options::*;
 pub use prove::*;
+pub use sharding::*;
 pub use tracer::*;
 
 #[cfg(any(test, feature = "programs"))]
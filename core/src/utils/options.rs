@@ -1,14 +1,51 @@
 use std::env;
 
+use serde::{Deserialize, Serialize};
+
 const DEFAULT_SHARD_SIZE: usize = 1 << 22;
 const DEFAULT_SHARD_BATCH_SIZE: usize = 16;
+const DEFAULT_CHECKPOINTS_IN_FLIGHT: usize = 2;
+const DEFAULT_CHECKPOINT_REPLAY_WORKERS: usize = 1;
+const DEFAULT_REDUCE_BATCH_SIZE: usize = 2;
+const DEFAULT_SHARD_MAIN_DATA_MEMORY_BUDGET: usize = 1 << 34;
+
+/// A memory budget to choose the shard size and the shard batch size for, instead of fixing them.
+#[derive(Debug, Clone, Copy, Serialize, Deserialize)]
+pub struct AdaptiveShardingOpts {
+    /// The number of bytes that the traces of the shards being committed at once may take.
+    pub memory_budget: usize,
+    /// The number of cores to commit shards on, which bounds the shard batch size.
+    pub num_cores: usize,
+}
 
-#[derive(Debug, Clone, Copy)]
+#[derive(Debug, Clone, Copy, Serialize, Deserialize)]
 pub struct SP1CoreOpts {
     pub shard_size: usize,
     pub shard_batch_size: usize,
     pub shard_chunking_multiplier: usize,
     pub reconstruct_commitments: bool,
+    /// The number of checkpoints that may be re-executed and sharded ahead of the one being
+    /// committed or proven. Zero replays the checkpoints serially.
+    ///
+    /// This bounds the records held in memory by the replay, and therefore also the number of
+    /// replay workers that can be busy at once.
+    pub checkpoints_in_flight: usize,
+    /// The number of threads that re-execute checkpoints in parallel.
+    pub checkpoint_replay_workers: usize,
+    /// Whether to keep the main trace data committed in the first pass over the checkpoints and
+    /// prove from it, instead of re-executing the checkpoints a second time.
+    pub cache_shard_main_data: bool,
+    /// The number of bytes of cached main data kept in memory, counting the main traces along
+    /// with their low-degree extensions and merkle trees. Data beyond the budget is spilled to
+    /// compressed temporary files.
+    pub shard_main_data_memory_budget: usize,
+    /// The number of proofs verified together by each recursive proof of the compress step, which
+    /// is the arity of its reduction tree.
+    pub reduce_batch_size: usize,
+    /// If set, the prover samples the execution of the program first and chooses the shard size
+    /// and the shard batch size for the memory budget. The shard size is then at most
+    /// `shard_size`.
+    pub adaptive_sharding: Option<AdaptiveShardingOpts>,
 }
 
 impl Default for SP1CoreOpts {
@@ -24,6 +61,43 @@ impl Default for SP1CoreOpts {
             ),
             shard_chunking_multiplier: 1,
             reconstruct_commitments: true,
+            checkpoints_in_flight: env::var("CHECKPOINTS_IN_FLIGHT").map_or_else(
+                |_| DEFAULT_CHECKPOINTS_IN_FLIGHT,
+                |s| s.parse::<usize>().unwrap_or(DEFAULT_CHECKPOINTS_IN_FLIGHT),
+            ),
+            checkpoint_replay_workers: env::var("CHECKPOINT_REPLAY_WORKERS").map_or_else(
+                |_| DEFAULT_CHECKPOINT_REPLAY_WORKERS,
+                |s| {
+                    s.parse::<usize>()
+                        .unwrap_or(DEFAULT_CHECKPOINT_REPLAY_WORKERS)
+                },
+            ),
+            cache_shard_main_data: env::var("CACHE_SHARD_MAIN_DATA")
+                .map_or(false, |s| s.parse::<bool>().unwrap_or(false)),
+            shard_main_data_memory_budget: env::var("SHARD_MAIN_DATA_MEMORY_BUDGET").map_or_else(
+                |_| DEFAULT_SHARD_MAIN_DATA_MEMORY_BUDGET,
+                |s| {
+                    s.parse::<usize>()
+                        .unwrap_or(DEFAULT_SHARD_MAIN_DATA_MEMORY_BUDGET)
+                },
+            ),
+            // A reduction needs to combine at least two proofs, so smaller batch sizes are
+            // rejected like unparsable ones.
+            reduce_batch_size: env::var("REDUCE_BATCH_SIZE")
+                .ok()
+                .and_then(|s| s.parse::<usize>().ok())
+                .filter(|&batch_size| batch_size >= 2)
+                .unwrap_or(DEFAULT_REDUCE_BATCH_SIZE),
+            adaptive_sharding: env::var("ADAPTIVE_SHARDING_MEMORY_BUDGET")
+                .ok()
+                .and_then(|s| s.parse::<usize>().ok())
+                .map(|memory_budget| AdaptiveShardingOpts {
+                    memory_budget,
+                    num_cores: env::var("ADAPTIVE_SHARDING_CORES").map_or_else(
+                        |_| num_cpus::get(),
+                        |s| s.parse::<usize>().unwrap_or_else(|_| num_cpus::get()),
+                    ),
+                }),
         }
     }
 }
@@ -33,6 +107,7 @@ impl SP1CoreOpts {
         let mut opts = Self::default();
         opts.reconstruct_commitments = false;
         opts.shard_size = DEFAULT_SHARD_SIZE;
+        opts.adaptive_sharding = None;
         opts
     }
 }
@@ -1,24 +1,27 @@
+use std::collections::BTreeMap;
 use std::fs::File;
 use std::io;
-use std::io::{Seek, Write};
-use std::sync::Arc;
+use std::io::{Read, Seek};
+use std::sync::{Arc, Condvar, Mutex};
 use web_time::Instant;
 
 pub use baby_bear_blake3::BabyBearBlake3;
 use p3_challenger::CanObserve;
 use p3_field::PrimeField32;
+use p3_maybe_rayon::prelude::*;
 use serde::de::DeserializeOwned;
 use serde::Serialize;
 use size::Size;
 use thiserror::Error;
 
 use crate::air::MachineAir;
+use crate::air::PublicValues;
 use crate::io::{SP1PublicValues, SP1Stdin};
 use crate::lookup::InteractionBuilder;
 use crate::runtime::{
     DefaultSubproofVerifier, ExecutionError, NoOpSubproofVerifier, SubproofVerifier,
 };
-use crate::runtime::{ExecutionRecord, ExecutionReport, ShardingConfig};
+use crate::runtime::{ExecutionRecord, ExecutionReport, ExecutionState, ShardingConfig};
 use crate::stark::DebugConstraintBuilder;
 use crate::stark::MachineProof;
 use crate::stark::ProverConstraintFolder;
@@ -27,11 +30,11 @@ use crate::stark::Val;
 use crate::stark::VerifierConstraintFolder;
 use crate::stark::{Com, PcsProverData, RiscvAir, ShardProof, StarkProvingKey, UniConfig};
 use crate::stark::{MachineRecord, StarkMachine};
-use crate::utils::SP1CoreOpts;
+use crate::utils::{adapt_shard_sizes, metrics, SP1CoreOpts};
 use crate::{
     runtime::{Program, Runtime},
     stark::StarkGenericConfig,
-    stark::{LocalProver, OpeningProof, ShardMainData},
+    stark::{LocalProver, OpeningProof, ShardMainData, ShardMainDataWrapper},
 };
 
 const LOG_DEGREE_BOUND: usize = 31;
@@ -62,15 +65,29 @@ where
     let machine = RiscvAir::machine(config);
     let (pk, _) = machine.setup(runtime.program.as_ref());
 
+    prove_runtime(&machine, &pk, runtime, SP1CoreOpts::default())
+}
+
+/// Proves the record of an executed runtime in one go, with the machine and proving key of its
+/// program.
+fn prove_runtime<SC: StarkGenericConfig>(
+    machine: &StarkMachine<SC, RiscvAir<SC::Val>>,
+    pk: &StarkProvingKey<SC>,
+    runtime: Runtime,
+    opts: SP1CoreOpts,
+) -> Result<MachineProof<SC>, SP1CoreProverError>
+where
+    SC::Challenger: Clone,
+    OpeningProof<SC>: Send + Sync,
+    Com<SC>: Send + Sync,
+    PcsProverData<SC>: Send + Sync,
+    ShardMainData<SC>: Serialize + DeserializeOwned,
+    <SC as StarkGenericConfig>::Val: PrimeField32,
+{
     // Prove the program.
     let mut challenger = machine.config().challenger();
     let proving_start = Instant::now();
-    let proof = machine.prove::<LocalProver<_, _>>(
-        &pk,
-        runtime.record,
-        &mut challenger,
-        SP1CoreOpts::default(),
-    );
+    let proof = machine.prove::<LocalProver<_, _>>(pk, runtime.record, &mut challenger, opts);
     let proving_duration = proving_start.elapsed().as_millis();
     let nb_bytes = bincode::serialize(&proof).unwrap().len();
 
@@ -110,6 +127,49 @@ pub fn prove_with_subproof_verifier<SC: StarkGenericConfig + Send + Sync, V: Sub
     opts: SP1CoreOpts,
     subproof_verifier: Option<Arc<V>>,
 ) -> Result<(MachineProof<SC>, Vec<u8>), SP1CoreProverError>
+where
+    SC::Challenger: Clone,
+    OpeningProof<SC>: Send + Sync,
+    Com<SC>: Send + Sync,
+    PcsProverData<SC>: Send + Sync,
+    ShardMainData<SC>: Serialize + DeserializeOwned,
+    <SC as StarkGenericConfig>::Val: PrimeField32,
+{
+    let machine = RiscvAir::machine(config);
+    let (pk, _) = machine.setup(&program);
+    prove_with_proving_key(program, &pk, stdin, &machine, opts, subproof_verifier)
+}
+
+/// Chooses the shard sizes for the memory budget of `opts.adaptive_sharding`, if there is one,
+/// returning the options to execute with and the config to shard with.
+pub(super) fn choose_sharding<SC>(
+    machine: &StarkMachine<SC, RiscvAir<SC::Val>>,
+    program: &Program,
+    stdin: &SP1Stdin,
+    opts: SP1CoreOpts,
+) -> Result<(SP1CoreOpts, ShardingConfig), SP1CoreProverError>
+where
+    SC: StarkGenericConfig,
+    SC::Val: PrimeField32,
+{
+    match opts.adaptive_sharding {
+        Some(adaptive) => {
+            let opts = adapt_shard_sizes(machine, program, stdin, opts, adaptive)?;
+            Ok((opts, ShardingConfig::new(opts.shard_size)))
+        }
+        None => Ok((opts, ShardingConfig::default())),
+    }
+}
+
+/// Proves the program with a proving key set up earlier for it, such as one kept in a cache.
+pub fn prove_with_proving_key<SC: StarkGenericConfig + Send + Sync, V: SubproofVerifier>(
+    program: Program,
+    pk: &StarkProvingKey<SC>,
+    stdin: &SP1Stdin,
+    machine: &StarkMachine<SC, RiscvAir<SC::Val>>,
+    opts: SP1CoreOpts,
+    subproof_verifier: Option<Arc<V>>,
+) -> Result<(MachineProof<SC>, Vec<u8>), SP1CoreProverError>
 where
     SC::Challenger: Clone,
     OpeningProof<SC>: Send + Sync,
@@ -120,6 +180,8 @@ where
 {
     let proving_start = Instant::now();
 
+    let (opts, sharding_config) = choose_sharding(machine, &program, stdin, opts)?;
+
     // Execute the program.
     let mut runtime = Runtime::new(program.clone(), opts);
     runtime.write_vecs(&stdin.buffer);
@@ -130,10 +192,6 @@ where
         runtime.subproof_verifier = deferred_fn;
     }
 
-    // Setup the machine.
-    let machine = RiscvAir::machine(config);
-    let (pk, vk) = machine.setup(runtime.program.as_ref());
-
     // If we don't need to batch, we can just run the program normally and prove it.
     if opts.shard_batch_size == 0 {
         // Execute the runtime and collect all the events..
@@ -143,106 +201,109 @@ where
         #[cfg(feature = "debug")]
         {
             let mut challenger = machine.config().challenger();
-            machine.debug_constraints(&pk, runtime.record.clone(), &mut challenger);
+            machine.debug_constraints(pk, runtime.record.clone(), &mut challenger);
         }
 
         // Generate the proof and return the proof and public values.
         let public_values = std::mem::take(&mut runtime.state.public_values_stream);
-        let proof = prove_simple(machine.config().clone(), runtime)?;
+        let proof = prove_runtime(machine, pk, runtime, opts)?;
         return Ok((proof, public_values));
     }
 
     // Execute the program, saving checkpoints at the start of every `shard_batch_size` cycle range.
-    let mut checkpoints = Vec::new();
-    let (public_values_stream, public_values) = loop {
-        // Execute the runtime until we reach a checkpoint.
-        let (checkpoint, done) = tracing::info_span!("collect_checkpoints")
-            .in_scope(|| runtime.execute_state())
-            .map_err(SP1CoreProverError::ExecutionError)?;
-
-        // Save the checkpoint to a temp file.
-        let mut tempfile = tempfile::tempfile().map_err(SP1CoreProverError::IoError)?;
-        let mut writer = std::io::BufWriter::new(&mut tempfile);
-        bincode::serialize_into(&mut writer, &checkpoint)
-            .map_err(SP1CoreProverError::SerializationError)?;
-        writer.flush().map_err(SP1CoreProverError::IoError)?;
-        drop(writer);
-        tempfile
-            .seek(std::io::SeekFrom::Start(0))
-            .map_err(SP1CoreProverError::IoError)?;
-        checkpoints.push(tempfile);
-
-        // If we've reached the final checkpoint, break out of the loop.
-        if done {
-            break (
-                std::mem::take(&mut runtime.state.public_values_stream),
-                runtime.record.public_values,
-            );
-        }
-    };
+    let (mut checkpoints, public_values_stream, public_values) = collect_checkpoints(&mut runtime)?;
+    metrics::record_peak_rss("execute");
 
     // For each checkpoint, generate events, shard them, commit shards, and observe in challenger.
-    let sharding_config = ShardingConfig::default();
+    // If the main data is cached, the commit keeps it instead of dropping it.
+    let mut commit_opts = opts;
+    commit_opts.reconstruct_commitments = !opts.cache_shard_main_data;
+    let mut memory_budget = opts.shard_main_data_memory_budget;
     let mut shard_main_datas = Vec::new();
+    let mut report_aggregate = ExecutionReport::default();
     let mut challenger = machine.config().challenger();
-    vk.observe_into(&mut challenger);
-    for (num, checkpoint_file) in checkpoints.iter_mut().enumerate() {
-        let (mut record, _) = tracing::info_span!("commit_checkpoint", num)
-            .in_scope(|| trace_checkpoint(program.clone(), checkpoint_file, opts));
-        record.public_values = public_values;
-        reset_seek(&mut *checkpoint_file);
+    pk.observe_into(&mut challenger);
+    replay_checkpoints(
+        machine,
+        &program,
+        &mut checkpoints,
+        public_values,
+        &sharding_config,
+        opts,
+        |num, checkpoint_shards, report| {
+            report_aggregate += report;
 
-        // Shard the record into shards.
-        let checkpoint_shards =
-            tracing::info_span!("shard").in_scope(|| machine.shard(record, &sharding_config));
+            // Commit to each shard.
+            let (commitments, commit_data) = tracing::info_span!("commit_checkpoint", num)
+                .in_scope(|| LocalProver::commit_shards(machine, &checkpoint_shards, commit_opts));
+            if opts.cache_shard_main_data {
+                shard_main_datas.push(
+                    tracing::debug_span!("cache_checkpoint", num)
+                        .in_scope(|| cache_shard_main_datas(commit_data, &mut memory_budget)),
+                );
+            }
 
-        // Commit to each shard.
-        let (commitments, commit_data) = tracing::info_span!("commit")
-            .in_scope(|| LocalProver::commit_shards(&machine, &checkpoint_shards, opts));
-        shard_main_datas.push(commit_data);
+            // Observe the commitments.
+            for (commitment, shard) in commitments.into_iter().zip(checkpoint_shards.iter()) {
+                challenger.observe(commitment);
+                challenger
+                    .observe_slice(&shard.public_values::<SC::Val>()[0..machine.num_pv_elts()]);
+            }
+        },
+    );
 
-        // Observe the commitments.
-        for (commitment, shard) in commitments.into_iter().zip(checkpoint_shards.iter()) {
-            challenger.observe(commitment);
-            challenger.observe_slice(&shard.public_values::<SC::Val>()[0..machine.num_pv_elts()]);
-        }
-    }
+    metrics::record_peak_rss("commit");
 
-    // For each checkpoint, generate events and shard again, then prove the shards.
+    // Prove the shards of each checkpoint from the main data.
+    let prove_shard =
+        |shard_data: ShardMainData<SC>| prove_shard_data(machine, pk, shard_data, &challenger);
     let mut shard_proofs = Vec::<ShardProof<SC>>::new();
-    let mut report_aggregate = ExecutionReport::default();
-    for (num, mut checkpoint_file) in checkpoints.into_iter().enumerate() {
-        let checkpoint_shards = {
-            let (mut events, report) = tracing::info_span!("prove_checkpoint", num)
-                .in_scope(|| trace_checkpoint(program.clone(), &checkpoint_file, opts));
-            report_aggregate += report;
-            events.public_values = public_values;
-            reset_seek(&mut checkpoint_file);
-            tracing::debug_span!("shard").in_scope(|| machine.shard(events, &sharding_config))
-        };
-        let mut checkpoint_proofs = checkpoint_shards
-            .into_iter()
-            .map(|shard| {
-                let config = machine.config();
-                let shard_data =
-                    LocalProver::commit_main(config, &machine, &shard, shard.index() as usize);
-
-                let chip_ordering = shard_data.chip_ordering.clone();
-                let ordered_chips = machine
-                    .shard_chips_ordered(&chip_ordering)
-                    .collect::<Vec<_>>()
-                    .to_vec();
-                LocalProver::prove_shard(
-                    config,
-                    &pk,
-                    &ordered_chips,
-                    shard_data,
-                    &mut challenger.clone(),
-                )
-            })
-            .collect::<Vec<_>>();
-        shard_proofs.append(&mut checkpoint_proofs);
+    if opts.cache_shard_main_data {
+        // Prove from the cached main data.
+        for (num, checkpoint_datas) in shard_main_datas.into_iter().enumerate() {
+            let mut checkpoint_proofs =
+                tracing::info_span!("prove_checkpoint", num).in_scope(|| {
+                    checkpoint_datas
+                        .into_iter()
+                        .map(|data| {
+                            prove_shard(
+                                data.materialize()
+                                    .expect("failed to materialize shard main data"),
+                            )
+                        })
+                        .collect::<Vec<_>>()
+                });
+            shard_proofs.append(&mut checkpoint_proofs);
+        }
+    } else {
+        // Generate events and shard again, then commit to and prove the shards.
+        replay_checkpoints(
+            machine,
+            &program,
+            &mut checkpoints,
+            public_values,
+            &sharding_config,
+            opts,
+            |num, checkpoint_shards, _| {
+                let mut checkpoint_proofs =
+                    tracing::info_span!("prove_checkpoint", num).in_scope(|| {
+                        checkpoint_shards
+                            .into_iter()
+                            .map(|shard| {
+                                prove_shard(LocalProver::commit_main(
+                                    machine.config(),
+                                    machine,
+                                    &shard,
+                                    shard.index() as usize,
+                                ))
+                            })
+                            .collect::<Vec<_>>()
+                    });
+                shard_proofs.append(&mut checkpoint_proofs);
+            },
+        );
     }
+
     // Log some of the `ExecutionReport` information.
     tracing::info!(
         "execution report (totals): total_cycles={}, total_syscall_cycles={}",
@@ -264,6 +325,18 @@ where
 
     // Print the summary.
     let proving_time = proving_start.elapsed().as_secs_f64();
+    metrics::record_peak_rss("prove");
+    metrics::observe_histogram("sp1_core_prove_seconds", &[], proving_time);
+    metrics::increment_counter(
+        "sp1_core_cycles_total",
+        &[],
+        runtime.state.global_clk as f64,
+    );
+    metrics::set_gauge(
+        "sp1_core_cycles_per_second",
+        &[],
+        runtime.state.global_clk as f64 / proving_time,
+    );
     tracing::info!(
         "summary: cycles={}, e2e={}, khz={:.2}, proofSize={}",
         runtime.state.global_clk,
@@ -371,13 +444,81 @@ where
     Ok(proof)
 }
 
-fn trace_checkpoint(
+/// Executes the program, saving a checkpoint to a temporary file at the start of every
+/// `shard_batch_size` shards. Returns the checkpoints, rewound to their start, along with the
+/// public values stream and the public values of the execution.
+pub(crate) fn collect_checkpoints(
+    runtime: &mut Runtime,
+) -> Result<(Vec<File>, Vec<u8>, PublicValues<u32, u32>), SP1CoreProverError> {
+    let mut checkpoints = Vec::new();
+    loop {
+        // Execute the runtime until we reach a checkpoint.
+        let (checkpoint, done) = tracing::info_span!("collect_checkpoints")
+            .in_scope(|| runtime.execute_state())
+            .map_err(SP1CoreProverError::ExecutionError)?;
+
+        // Save the checkpoint to a temp file.
+        let mut tempfile = tempfile::tempfile().map_err(SP1CoreProverError::IoError)?;
+        tracing::debug_span!("write_checkpoint")
+            .in_scope(|| checkpoint.write_checkpoint(&mut tempfile))
+            .map_err(SP1CoreProverError::SerializationError)?;
+        let checkpoint_bytes = tempfile
+            .stream_position()
+            .map_err(SP1CoreProverError::IoError)?;
+        metrics::increment_counter("sp1_checkpoint_bytes_total", &[], checkpoint_bytes as f64);
+        tempfile
+            .seek(std::io::SeekFrom::Start(0))
+            .map_err(SP1CoreProverError::IoError)?;
+        checkpoints.push(tempfile);
+
+        // If we've reached the final checkpoint, we're done.
+        if done {
+            return Ok((
+                checkpoints,
+                std::mem::take(&mut runtime.state.public_values_stream),
+                runtime.record.public_values,
+            ));
+        }
+    }
+}
+
+/// Proves a shard from its committed main data, continuing from the challenger that observed the
+/// commitments of all shards.
+pub(crate) fn prove_shard_data<SC>(
+    machine: &StarkMachine<SC, RiscvAir<SC::Val>>,
+    pk: &StarkProvingKey<SC>,
+    shard_data: ShardMainData<SC>,
+    challenger: &SC::Challenger,
+) -> ShardProof<SC>
+where
+    SC: StarkGenericConfig + Send + Sync,
+    SC::Val: PrimeField32,
+    SC::Challenger: Clone,
+    Com<SC>: Send + Sync,
+    PcsProverData<SC>: Send + Sync,
+    ShardMainData<SC>: Serialize + DeserializeOwned,
+{
+    let chip_ordering = shard_data.chip_ordering.clone();
+    let ordered_chips = machine
+        .shard_chips_ordered(&chip_ordering)
+        .collect::<Vec<_>>()
+        .to_vec();
+    LocalProver::prove_shard(
+        machine.config(),
+        pk,
+        &ordered_chips,
+        shard_data,
+        &mut challenger.clone(),
+    )
+}
+
+/// Re-executes the checkpoint read from `reader`, returning the record of its events.
+pub(crate) fn trace_checkpoint(
     program: Program,
-    file: &File,
+    reader: impl Read,
     opts: SP1CoreOpts,
 ) -> (ExecutionRecord, ExecutionReport) {
-    let mut reader = std::io::BufReader::new(file);
-    let state = bincode::deserialize_from(&mut reader).expect("failed to deserialize state");
+    let state = ExecutionState::read_checkpoint(reader).expect("failed to deserialize state");
     let mut runtime = Runtime::recover(program.clone(), state, opts);
     // We already passed the deferred proof verifier when creating checkpoints, so the proofs were
     // already verified. So here we use a noop verifier to not print any warnings.
@@ -387,6 +528,191 @@ fn trace_checkpoint(
     (events, runtime.report)
 }
 
+/// Re-executes the checkpoints and shards their records, passing the shards of each checkpoint to
+/// `consume` in checkpoint order along with its execution report.
+///
+/// Re-execution runs on `opts.checkpoint_replay_workers` separate threads, so tracing the next
+/// checkpoints overlaps with `consume` working on the current one. At most
+/// `opts.checkpoints_in_flight` checkpoints are traced ahead of the consumer, which bounds the
+/// memory held by the pipeline: a worker waits for the consumer to take a checkpoint before it
+/// starts on the next one.
+pub(crate) fn replay_checkpoints<SC, F>(
+    machine: &StarkMachine<SC, RiscvAir<SC::Val>>,
+    program: &Program,
+    checkpoints: &mut [File],
+    public_values: PublicValues<u32, u32>,
+    sharding_config: &ShardingConfig,
+    opts: SP1CoreOpts,
+    mut consume: F,
+) where
+    SC: StarkGenericConfig + Send + Sync,
+    SC::Val: PrimeField32,
+    F: FnMut(usize, Vec<ExecutionRecord>, ExecutionReport),
+{
+    let trace = |num: usize, checkpoint_file: &mut File| {
+        let (mut record, report) = tracing::info_span!("trace_checkpoint", num)
+            .in_scope(|| trace_checkpoint(program.clone(), checkpoint_file, opts));
+        record.public_values = public_values;
+        reset_seek(checkpoint_file);
+        let shards =
+            tracing::debug_span!("shard").in_scope(|| machine.shard(record, sharding_config));
+        (shards, report)
+    };
+
+    if opts.checkpoints_in_flight == 0 {
+        for (num, checkpoint_file) in checkpoints.iter_mut().enumerate() {
+            let (shards, report) = trace(num, checkpoint_file);
+            consume(num, shards, report);
+        }
+        return;
+    }
+
+    let num_workers = opts
+        .checkpoint_replay_workers
+        .clamp(1, opts.checkpoints_in_flight);
+    let permits = ReplayPermits::new(opts.checkpoints_in_flight);
+    let next_checkpoint = Mutex::new(checkpoints.iter_mut().enumerate());
+    let (tx, rx) = std::sync::mpsc::channel();
+    let span = tracing::Span::current();
+    std::thread::scope(|s| {
+        for _ in 0..num_workers {
+            let tx = tx.clone();
+            let span = span.clone();
+            let (trace, permits, next_checkpoint) = (&trace, &permits, &next_checkpoint);
+            s.spawn(move || {
+                let _guard = span.enter();
+                let _close = ClosePermits {
+                    permits,
+                    on_panic_only: true,
+                };
+                while permits.acquire() {
+                    let Some((num, checkpoint_file)) = next_checkpoint.lock().unwrap().next()
+                    else {
+                        break;
+                    };
+                    let (shards, report) = trace(num, checkpoint_file);
+                    if tx.send((num, shards, report)).is_err() {
+                        // The consumer has stopped, so the remaining checkpoints are not needed.
+                        break;
+                    }
+                }
+            });
+        }
+        drop(tx);
+
+        // Workers may finish out of order, so checkpoints are buffered until their turn.
+        let _close = ClosePermits {
+            permits: &permits,
+            on_panic_only: false,
+        };
+        let mut pending = BTreeMap::new();
+        let mut next_num = 0;
+        for (num, shards, report) in rx {
+            pending.insert(num, (shards, report));
+            while let Some((shards, report)) = pending.remove(&next_num) {
+                permits.release();
+                consume(next_num, shards, report);
+                next_num += 1;
+            }
+        }
+    });
+}
+
+/// Bounds the number of checkpoints traced ahead of the consumer in [replay_checkpoints].
+struct ReplayPermits {
+    /// The number of available permits, and whether the consumer has stopped.
+    state: Mutex<(usize, bool)>,
+    condvar: Condvar,
+}
+
+impl ReplayPermits {
+    fn new(permits: usize) -> Self {
+        Self {
+            state: Mutex::new((permits, false)),
+            condvar: Condvar::new(),
+        }
+    }
+
+    /// Waits for a permit, returning false if the consumer has stopped.
+    fn acquire(&self) -> bool {
+        let mut state = self.state.lock().unwrap();
+        while state.0 == 0 && !state.1 {
+            state = self.condvar.wait(state).unwrap();
+        }
+        if state.1 {
+            return false;
+        }
+        state.0 -= 1;
+        true
+    }
+
+    fn release(&self) {
+        self.state.lock().unwrap().0 += 1;
+        self.condvar.notify_one();
+    }
+
+    /// Stops handing out permits and wakes up all waiting workers.
+    fn close(&self) {
+        // Ignore poisoning so that a panicking thread still releases the workers.
+        let mut state = self.state.lock().unwrap_or_else(|e| e.into_inner());
+        state.1 = true;
+        self.condvar.notify_all();
+    }
+}
+
+/// Closes the [ReplayPermits] when dropped, or only when dropped during a panic if `on_panic_only`
+/// is set, so that no worker waits forever on a consumer or worker that has died.
+struct ClosePermits<'a> {
+    permits: &'a ReplayPermits,
+    on_panic_only: bool,
+}
+
+impl Drop for ClosePermits<'_> {
+    fn drop(&mut self) {
+        if !self.on_panic_only || std::thread::panicking() {
+            self.permits.close();
+        }
+    }
+}
+
+/// Keeps the committed main data of a checkpoint for proving. Data is kept in memory while it fits
+/// in the remaining budget and is otherwise spilled to compressed temporary files.
+fn cache_shard_main_datas<SC>(
+    datas: Vec<ShardMainDataWrapper<SC>>,
+    memory_budget: &mut usize,
+) -> Vec<ShardMainDataWrapper<SC>>
+where
+    SC: StarkGenericConfig,
+    ShardMainData<SC>: Serialize + Send,
+    ShardMainDataWrapper<SC>: Send,
+{
+    datas
+        .into_iter()
+        .map(|data| match data {
+            ShardMainDataWrapper::InMemory(data) => {
+                let size = data.size_in_bytes();
+                if size <= *memory_budget {
+                    *memory_budget -= size;
+                    Ok(data.to_in_memory())
+                } else {
+                    Err(data)
+                }
+            }
+            _ => unreachable!("main data is committed in memory before caching"),
+        })
+        .collect::<Vec<_>>()
+        .into_par_iter()
+        .map(|data| match data {
+            Ok(data) => data,
+            Err(data) => {
+                let file = tempfile::tempfile().expect("failed to create tempfile");
+                data.save_compressed(file)
+                    .expect("failed to save shard main data")
+            }
+        })
+        .collect()
+}
+
 fn reset_seek(file: &mut File) {
     file.seek(std::io::SeekFrom::Start(0))
         .expect("failed to seek to start of tempfile");
@@ -0,0 +1,245 @@
+use std::collections::HashMap;
+use std::sync::Arc;
+
+use p3_air::BaseAir;
+use p3_field::PrimeField32;
+use size::Size;
+
+use crate::io::SP1Stdin;
+use crate::runtime::{EventPlacement, NoOpSubproofVerifier, Program, Runtime, ShardingConfig};
+use crate::stark::{MachineRecord, RiscvAir, StarkGenericConfig, StarkMachine, LDE_BLOWUP};
+use crate::utils::{AdaptiveShardingOpts, SP1CoreOpts, SP1CoreProverError};
+
+/// The shard size of the sampled execution, and the smallest shard size that is chosen.
+const MIN_SHARD_SIZE: usize = 1 << 15;
+
+/// The number of bytes of a field element.
+const BYTES_PER_ELEMENT: usize = 4;
+
+/// The degree of the extension field of the permutation traces.
+const EXTENSION_DEGREE: usize = 4;
+
+/// The number of events of each kind in the stats of the execution record per CPU cycle, at the
+/// densest sampled part of the execution.
+pub type EventDensities = HashMap<String, f64>;
+
+/// Chooses the shard size and the shard batch size for the memory budget of `adaptive`, from the
+/// event densities of a sampled execution of the program.
+///
+/// The sizes are chosen so that the estimated traces of the largest shard of a batch, committed
+/// on every core at once, fit the budget. The shard size is the largest one that fits, up to
+/// `opts.shard_size`, which leaves the binding chip just under a power-of-two height. The batch
+/// size is then the largest one that fits, up to the number of cores.
+pub fn adapt_shard_sizes<SC>(
+    machine: &StarkMachine<SC, RiscvAir<SC::Val>>,
+    program: &Program,
+    stdin: &SP1Stdin,
+    opts: SP1CoreOpts,
+    adaptive: AdaptiveShardingOpts,
+) -> Result<SP1CoreOpts, SP1CoreProverError>
+where
+    SC: StarkGenericConfig,
+    SC::Val: PrimeField32,
+{
+    let densities = tracing::info_span!("sample_event_densities")
+        .in_scope(|| sample_event_densities(machine, program, stdin, opts))?;
+
+    let num_cores = adaptive.num_cores.max(1);
+    let fits = |shard_size: usize, batch_size: usize| {
+        batch_size.min(num_cores) * shard_trace_bytes(machine, &densities, shard_size, batch_size)
+            <= adaptive.memory_budget
+    };
+
+    // The estimate only grows with the shard size, so search for the largest one that fits with
+    // every core busy, then for the largest batch at that size.
+    let max_shard_size = opts.shard_size.max(MIN_SHARD_SIZE);
+    let shard_size = if fits(MIN_SHARD_SIZE, num_cores) {
+        let (mut low, mut high) = (MIN_SHARD_SIZE, max_shard_size);
+        while low < high {
+            let mid = low + (high - low + 1) / 2;
+            if fits(mid, num_cores) {
+                low = mid;
+            } else {
+                high = mid - 1;
+            }
+        }
+        low
+    } else {
+        MIN_SHARD_SIZE
+    };
+    let batch_size = (1..=num_cores)
+        .rev()
+        .find(|batch_size| fits(shard_size, *batch_size))
+        .unwrap_or_else(|| {
+            tracing::warn!(
+                "the traces of a shard of {} cycles do not fit the memory budget of {}",
+                shard_size,
+                Size::from_bytes(adaptive.memory_budget)
+            );
+            1
+        });
+
+    tracing::info!(
+        "adaptive sharding: shard_size={}, shard_batch_size={}, estimated trace memory={}",
+        shard_size,
+        batch_size,
+        Size::from_bytes(
+            batch_size.min(num_cores)
+                * shard_trace_bytes(machine, &densities, shard_size, batch_size)
+        )
+    );
+
+    let mut opts = opts;
+    opts.shard_size = shard_size;
+    opts.shard_batch_size = batch_size;
+    Ok(opts)
+}
+
+/// Executes the program in shards of [MIN_SHARD_SIZE] cycles and records the event densities of
+/// the shards at exponentially spaced positions, skipping the others without emitting events.
+pub fn sample_event_densities<SC>(
+    machine: &StarkMachine<SC, RiscvAir<SC::Val>>,
+    program: &Program,
+    stdin: &SP1Stdin,
+    opts: SP1CoreOpts,
+) -> Result<EventDensities, SP1CoreProverError>
+where
+    SC: StarkGenericConfig,
+    SC::Val: PrimeField32,
+{
+    let mut sample_opts = opts;
+    sample_opts.shard_size = MIN_SHARD_SIZE;
+    sample_opts.shard_batch_size = 1;
+    let mut runtime = Runtime::new(program.clone(), sample_opts);
+    runtime.write_vecs(&stdin.buffer);
+    for proof in stdin.proofs.iter() {
+        runtime.write_proof(proof.0.clone(), proof.1.clone());
+    }
+    // The deferred proofs are verified when proving.
+    runtime.subproof_verifier = Arc::new(NoOpSubproofVerifier);
+
+    let sharding_config = ShardingConfig::default();
+    let mut densities = EventDensities::new();
+    let mut next_sample = 0;
+    for index in 0.. {
+        if index != next_sample {
+            if runtime
+                .execute_untraced()
+                .map_err(SP1CoreProverError::ExecutionError)?
+            {
+                break;
+            }
+            continue;
+        }
+        next_sample = (2 * index).max(1);
+
+        runtime.record.program = runtime.program.clone();
+        let (record, done) = runtime
+            .execute_record()
+            .map_err(SP1CoreProverError::ExecutionError)?;
+        // Ignore a short tail of the execution, unless nothing else was sampled.
+        let cycles = record.cpu_events.len();
+        if cycles > 0 && (densities.is_empty() || cycles >= MIN_SHARD_SIZE / 16) {
+            for shard in machine.shard(record, &sharding_config) {
+                let cycles = shard.cpu_events.len().max(1) as f64;
+                for (key, count) in shard.stats() {
+                    let density = densities.entry(key).or_default();
+                    *density = density.max(count as f64 / cycles);
+                }
+            }
+        }
+        if done {
+            break;
+        }
+    }
+    Ok(densities)
+}
+
+/// Estimates the bytes of the main and permutation traces, with their low-degree extensions, of
+/// the largest shard of a batch, which is the first one. Only the chips whose height grows with
+/// the shard size are counted.
+pub fn shard_trace_bytes<SC>(
+    machine: &StarkMachine<SC, RiscvAir<SC::Val>>,
+    densities: &EventDensities,
+    shard_size: usize,
+    batch_size: usize,
+) -> usize
+where
+    SC: StarkGenericConfig,
+    SC::Val: PrimeField32,
+{
+    machine
+        .chips()
+        .iter()
+        .filter_map(|chip| {
+            let (events, placement) = chip.air().shard_events()?;
+            let rows = events
+                .iter()
+                .map(|(key, rows_per_event)| {
+                    let density = densities.get(*key).copied().unwrap_or_default();
+                    let per_shard = density * shard_size as f64;
+                    let in_first_shard = match placement {
+                        EventPlacement::PerShard => per_shard,
+                        EventPlacement::Packed => {
+                            (per_shard * batch_size as f64).min(shard_size as f64)
+                        }
+                        EventPlacement::First => per_shard * batch_size as f64,
+                    };
+                    in_first_shard.ceil() as usize * rows_per_event
+                })
+                .sum::<usize>();
+            if rows == 0 {
+                return None;
+            }
+            let columns = chip.width() + EXTENSION_DEGREE * chip.permutation_width();
+            Some(rows.next_power_of_two() * columns * BYTES_PER_ELEMENT * (1 + LDE_BLOWUP))
+        })
+        .sum()
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::runtime::tests::fibonacci_program;
+    use crate::utils::BabyBearPoseidon2;
+
+    #[test]
+    fn test_adapt_shard_sizes_to_budget() {
+        let program = fibonacci_program();
+        let stdin = SP1Stdin::new();
+        let machine = RiscvAir::machine(BabyBearPoseidon2::new());
+        let opts = SP1CoreOpts::default();
+
+        let densities = sample_event_densities(&machine, &program, &stdin, opts).unwrap();
+        assert_eq!(densities["cpu_events"], 1.0);
+        let small = shard_trace_bytes(&machine, &densities, MIN_SHARD_SIZE, 1);
+        let large = shard_trace_bytes(&machine, &densities, 4 * MIN_SHARD_SIZE, 1);
+        assert!(small < large);
+
+        let adaptive = AdaptiveShardingOpts {
+            memory_budget: large,
+            num_cores: 1,
+        };
+        let opts = adapt_shard_sizes(&machine, &program, &stdin, opts, adaptive).unwrap();
+        assert!(opts.shard_size >= 4 * MIN_SHARD_SIZE);
+        assert!(opts.shard_size < SP1CoreOpts::default().shard_size);
+        assert_eq!(opts.shard_batch_size, 1);
+        assert!(shard_trace_bytes(&machine, &densities, opts.shard_size, 1) <= large);
+    }
+
+    #[test]
+    fn test_prove_adaptive_sharding() {
+        let mut opts = SP1CoreOpts::default();
+        opts.adaptive_sharding = Some(AdaptiveShardingOpts {
+            memory_budget: 1 << 30,
+            num_cores: 2,
+        });
+        crate::utils::prove(
+            fibonacci_program(),
+            &SP1Stdin::new(),
+            BabyBearPoseidon2::new(),
+            opts,
+        )
+        .unwrap();
+    }
+}
@@ -179,6 +179,13 @@ pub fn machine_air_derive(input: TokenStream) -> TokenStream {
                 }
             });
 
+            let dependency_stage_arms = variants.iter().map(|(variant_name, field)| {
+                let field_ty = &field.ty;
+                quote! {
+                    #name::#variant_name(x) => <#field_ty as #sp1_core_path::air::MachineAir<F>>::dependency_stage(x)
+                }
+            });
+
             let included_arms = variants.iter().map(|(variant_name, field)| {
                 let field_ty = &field.ty;
                 quote! {
@@ -233,6 +240,12 @@ pub fn machine_air_derive(input: TokenStream) -> TokenStream {
                         }
                     }
 
+                    fn dependency_stage(&self) -> usize {
+                        match self {
+                            #(#dependency_stage_arms,)*
+                        }
+                    }
+
                     fn included(&self, shard: &Self::Record) -> bool {
                         match self {
                             #(#included_arms,)*
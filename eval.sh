@@ -9,6 +9,7 @@ declare -i runs=5
 root_directory=$(pwd)
 
 benchmark_path="${root_directory}/benchmark.csv"
+stages_path="${root_directory}/stages.jsonl"
 
 for program in "${programs[@]}"; do
     echo "Processing program: $program"
@@ -42,5 +43,14 @@ for program in "${programs[@]}"; do
         done
     done
 
+    # Break the full pipeline down by stage, without the evaluation above. Set PLONK_BUILD_DIR to
+    # also time the gnark stages.
+    echo "Running the stage breakdown of $program, $runs times"
+    if ! CARGO_NET_GIT_FETCH_WITH_CLI=true RUSTFLAGS='-C target-cpu=native' cargo run -p sp1-eval --release -- \
+        --program $program --hashfn poseidon --elf-path "$elf_path" --runs $runs \
+        --stages-path "$stages_path" ${PLONK_BUILD_DIR:+--plonk-build-dir "$PLONK_BUILD_DIR"}; then
+        echo "Error running the stage breakdown for $program"
+    fi
+
     cd "$root_directory"
 done
\ No newline at end of file
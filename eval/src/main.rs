@@ -12,6 +12,8 @@ use std::fs::OpenOptions;
 use std::io;
 use std::{fs, time::Instant};
 
+mod stages;
+
 /// An identifier used to select the hash function to evaluate.
 #[derive(clap::ValueEnum, Clone)]
 enum HashFnId {
@@ -70,17 +72,26 @@ struct EvalArgs {
     #[arg(long)]
     pub hashfn: HashFnId,
 
-    #[arg(long)]
-    pub shard_size: u64,
+    #[arg(long, required_unless_present = "stages_path")]
+    pub shard_size: Option<u64>,
 
-    #[arg(long)]
-    pub benchmark_path: String,
+    #[arg(long, required_unless_present = "stages_path")]
+    pub benchmark_path: Option<String>,
 
     #[arg(long)]
     pub elf_path: String,
 
     #[arg(long, default_value_t = 1)]
     pub runs: usize,
+
+    /// Appends the duration of each stage of the full pipeline to this file as JSON lines,
+    /// instead of running the evaluation of the core prover.
+    #[arg(long)]
+    pub stages_path: Option<String>,
+
+    /// The PLONK circuit artifacts to time the gnark stages with.
+    #[arg(long)]
+    pub plonk_build_dir: Option<String>,
 }
 
 fn main() {
@@ -89,6 +100,26 @@ fn main() {
     // Load the program.
     let elf_path = &args.elf_path;
     let elf = fs::read(elf_path).expect("Failed to read ELF file");
+
+    // Break the full pipeline down by stage, which only supports Poseidon.
+    if let Some(stages_path) = &args.stages_path {
+        if !matches!(args.hashfn, HashFnId::Poseidon) {
+            eprintln!("Skipping the stage breakdown, which requires the poseidon hash function");
+            return;
+        }
+        let reports = stages::run_stages(
+            &args.program,
+            &elf,
+            &SP1Stdin::new(),
+            args.runs,
+            args.plonk_build_dir.as_deref().map(std::path::Path::new),
+        );
+        if let Err(e) = stages::write_stage_reports(&reports, stages_path) {
+            eprintln!("Failed to write stage reports: {}", e);
+        }
+        return;
+    }
+
     let cycles = get_cycles(&elf, &SP1Stdin::new());
 
     // Initialize total duration counters.
@@ -117,7 +148,7 @@ fn main() {
     let report = PerformanceReport {
         program: args.program,
         hashfn: args.hashfn.to_string(),
-        shard_size: args.shard_size,
+        shard_size: args.shard_size.expect("the shard size is required"),
         cycles,
         speed: cycles as f64 / avg_prove_duration,
         execution_duration: avg_execution_duration,
@@ -126,7 +157,8 @@ fn main() {
     };
 
     // Write the report.
-    if let Err(e) = write_report(report, &args.benchmark_path) {
+    let benchmark_path = args.benchmark_path.expect("the benchmark path is required");
+    if let Err(e) = write_report(report, &benchmark_path) {
         eprintln!("Failed to write report: {}", e);
     }
 }
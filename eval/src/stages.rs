@@ -0,0 +1,106 @@
+use serde::Serialize;
+use sp1_core::runtime::Program;
+use sp1_prover::{SP1Prover, SP1Stdin, SP1_CIRCUIT_VERSION};
+use sp1_recursion_gnark_ffi::GnarkWitness;
+use std::fs::OpenOptions;
+use std::io::{self, Write};
+use std::path::Path;
+use std::time::Instant;
+
+/// The duration of one stage of the prover pipeline in one run.
+#[derive(Debug, Serialize)]
+pub struct StageReport {
+    /// The program that is being evaluated.
+    pub program: String,
+
+    /// The version of the circuits that the prover was built with.
+    pub circuit_version: &'static str,
+
+    /// The stage that is being timed.
+    pub stage: &'static str,
+
+    /// The index of the run.
+    pub run: usize,
+
+    /// The duration of the stage in seconds.
+    pub duration: f64,
+}
+
+/// Runs the pipeline from setup to the PLONK proof, timing each stage separately. The gnark stages
+/// only run if the PLONK build directory is given.
+pub fn run_stages(
+    program: &str,
+    elf: &[u8],
+    stdin: &SP1Stdin,
+    runs: usize,
+    plonk_build_dir: Option<&Path>,
+) -> Vec<StageReport> {
+    let prover = SP1Prover::new();
+    let mut reports = Vec::new();
+    for run in 0..runs {
+        let mut time = |stage: &'static str, duration: f64| {
+            reports.push(StageReport {
+                program: program.to_string(),
+                circuit_version: SP1_CIRCUIT_VERSION,
+                stage,
+                run,
+                duration,
+            });
+        };
+
+        // Set up without the cache, so that every run measures the setup.
+        let ((pk, vk), duration) = timed(|| prover.setup_program(elf, &Program::from(elf)));
+        time("setup", duration);
+        let (_, duration) = timed(|| SP1Prover::execute(elf, stdin).unwrap());
+        time("execute", duration);
+        let (core_proof, duration) = timed(|| prover.prove_core(&pk, stdin).unwrap());
+        time("prove_core", duration);
+        let public_values = core_proof.public_values.clone();
+        let (compressed, duration) = timed(|| prover.compress(&vk, core_proof, vec![]).unwrap());
+        time("compress", duration);
+        let (shrunk, duration) = timed(|| prover.shrink(compressed).unwrap());
+        time("shrink", duration);
+        let (wrapped, duration) = timed(|| prover.wrap_bn254(shrunk).unwrap());
+        time("wrap_bn254", duration);
+
+        let Some(build_dir) = plonk_build_dir else {
+            continue;
+        };
+        let witness = SP1Prover::bn254_witness(&wrapped);
+        let (_, duration) = timed(|| {
+            serde_json::to_string(&GnarkWitness::new(witness.clone())).unwrap();
+        });
+        time("gnark_witness_json", duration);
+        let (_, duration) = timed(|| GnarkWitness::encode_binary(witness.clone()));
+        time("gnark_witness_binary", duration);
+        let (proof, duration) = timed(|| {
+            prover
+                .plonk_bn254_prover
+                .prove(witness, build_dir.to_path_buf())
+        });
+        time("plonk_prove", duration);
+        let (_, duration) = timed(|| {
+            prover
+                .verify_plonk_bn254(&proof, &vk, &public_values, build_dir)
+                .unwrap()
+        });
+        time("plonk_verify", duration);
+    }
+    reports
+}
+
+fn timed<T>(f: impl FnOnce() -> T) -> (T, f64) {
+    let start = Instant::now();
+    let result = f();
+    (result, start.elapsed().as_secs_f64())
+}
+
+/// Appends the reports to the file as JSON lines.
+pub fn write_stage_reports(reports: &[StageReport], path: &str) -> io::Result<()> {
+    let mut file = OpenOptions::new().create(true).append(true).open(path)?;
+    for report in reports {
+        serde_json::to_writer(&mut file, report)?;
+        file.write_all(b"\n")?;
+    }
+    file.flush()
+}
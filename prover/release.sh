@@ -27,7 +27,7 @@ echo "$COMMIT_HASH $VERSION" > ./build/SP1_COMMIT
 # Create archive named after the commit hash
 ARCHIVE_NAME="${VERSION}.tar.gz"
 cd $FILE_TO_UPLOAD
-tar --exclude='srs.bin' --exclude='srs_lagrange.bin' -czvf "../$ARCHIVE_NAME" .
+tar --exclude='srs.bin' --exclude='srs_lagrange*.bin' -czvf "../$ARCHIVE_NAME" .
 cd -
 if [ $? -ne 0 ]; then
     echo "Failed to create archive."
@@ -0,0 +1,291 @@
+//! Proving split into tasks that can run on other nodes.
+//!
+//! The node that coordinates a proof plans the core shard tasks with [SP1Prover::plan_core] and
+//! hands them to workers, which prove them with [SP1Prover::prove_core_task]. The shard proofs are
+//! merged back into a [SP1CoreProof] with [SP1Prover::merge_core]. The compress step works the same
+//! way: [SP1Prover::plan_compress] returns the tasks of the leaves of the reduction tree along with
+//! a [SP1ReduceMerger], which turns the proofs of a node's children into the task of the node as
+//! they come back from [SP1Prover::prove_reduce_task], until the root is proven.
+//!
+//! A task references its proving key instead of carrying it: core tasks by the digest of their
+//! program and recursion tasks by their [ReduceProgramType], since every worker holds the keys of
+//! the recursion programs.
+
+use std::sync::Arc;
+
+use p3_baby_bear::BabyBear;
+use serde::{Deserialize, Serialize};
+use sp1_core::io::SP1Stdin;
+use sp1_core::stark::ShardProof;
+use sp1_core::utils::{
+    merge_shard_results, plan_shard_tasks, prove_shard_task, SP1CoreProverError, ShardProveResult,
+    ShardProveTask,
+};
+use sp1_recursion_core::air::Block;
+use sp1_recursion_program::hints::Hintable;
+use sp1_recursion_program::machine::{ReduceProgramType, SP1ReduceMemoryLayout};
+
+use crate::reduce::ReduceTree;
+use crate::{
+    CoreSC, InnerSC, SP1CoreProof, SP1CoreProofData, SP1Prover, SP1ProvingKey, SP1PublicValues,
+    SP1ReduceProof, SP1VerifyingKey,
+};
+
+/// The generation of a recursive proof of a node of the reduction tree.
+#[derive(Serialize, Deserialize, Clone)]
+pub struct SP1ReduceTask {
+    /// The level of the node, counting the leaves as level zero.
+    pub level: usize,
+    /// The index of the node within its level.
+    pub index: usize,
+    /// The program to run, which also selects its proving key.
+    pub kind: ReduceProgramType,
+    /// The inputs of the program.
+    pub witness_stream: Vec<Vec<Block<BabyBear>>>,
+}
+
+/// The recursive proof of a node of the reduction tree.
+#[derive(Serialize, Deserialize, Clone)]
+pub struct SP1ReduceTaskResult {
+    pub level: usize,
+    pub index: usize,
+    pub kind: ReduceProgramType,
+    pub proof: ShardProof<InnerSC>,
+}
+
+/// Assembles the reduction tree of the compress step from the results of its tasks, which may
+/// arrive in any order.
+pub struct SP1ReduceMerger {
+    tree: ReduceTree,
+    total_core_shards: usize,
+    /// The results of the nodes whose parents are not ready yet, per level.
+    outputs: Vec<Vec<Option<(ShardProof<InnerSC>, ReduceProgramType)>>>,
+    /// The number of children each node is still waiting for, per level.
+    pending: Vec<Vec<usize>>,
+    root: Option<ShardProof<InnerSC>>,
+}
+
+impl SP1ReduceMerger {
+    fn new(tree: ReduceTree, total_core_shards: usize) -> Self {
+        let num_levels = tree.root_level() + 1;
+        Self {
+            outputs: (0..num_levels)
+                .map(|level| (0..tree.level_size(level)).map(|_| None).collect())
+                .collect(),
+            pending: (0..num_levels)
+                .map(|level| match level {
+                    0 => vec![0; tree.level_size(0)],
+                    _ => (0..tree.level_size(level))
+                        .map(|index| tree.num_children(level, index))
+                        .collect(),
+                })
+                .collect(),
+            tree,
+            total_core_shards,
+            root: None,
+        }
+    }
+
+    /// Records the result of a task, returning the task of its parent if the result was the last
+    /// one the parent waited for.
+    pub fn push(
+        &mut self,
+        prover: &SP1Prover,
+        result: SP1ReduceTaskResult,
+    ) -> Option<SP1ReduceTask> {
+        let SP1ReduceTaskResult {
+            level,
+            index,
+            kind,
+            proof,
+        } = result;
+        if level == self.tree.root_level() {
+            assert!(self.root.is_none(), "duplicate result for the root");
+            self.root = Some(proof);
+            return None;
+        }
+
+        let output = &mut self.outputs[level][index];
+        assert!(
+            output.is_none(),
+            "duplicate result for node {index} of level {level}"
+        );
+        *output = Some((proof, kind));
+        let parent = self.tree.parent(index);
+        self.pending[level + 1][parent] -= 1;
+        if self.pending[level + 1][parent] > 0 {
+            return None;
+        }
+
+        // The parent is ready, so reduce the proofs of its children.
+        let (shard_proofs, kinds) = self.outputs[level][self.tree.children(level + 1, parent)]
+            .iter_mut()
+            .map(|output| output.take().unwrap())
+            .unzip::<_, _, Vec<_>, Vec<_>>();
+        tracing::debug!("Reducing {} proofs", shard_proofs.len());
+        let input = SP1ReduceMemoryLayout {
+            compress_vk: &prover.compress_vk,
+            recursive_machine: &prover.compress_machine,
+            shard_proofs,
+            kinds,
+            is_complete: level + 1 == self.tree.root_level(),
+            total_core_shards: self.total_core_shards,
+        };
+        Some(SP1ReduceTask {
+            level: level + 1,
+            index: parent,
+            kind: ReduceProgramType::Reduce,
+            witness_stream: input.write(),
+        })
+    }
+
+    /// Returns the proof of the root, once its result has been pushed.
+    pub fn finish(self) -> Option<SP1ReduceProof<InnerSC>> {
+        self.root.map(|proof| SP1ReduceProof { proof })
+    }
+}
+
+impl SP1Prover {
+    /// Executes the program and commits to its shards, returning the tasks that prove the shards
+    /// along with the public values.
+    pub fn plan_core(
+        &self,
+        pk: &SP1ProvingKey,
+        stdin: &SP1Stdin,
+    ) -> Result<(Vec<ShardProveTask<CoreSC>>, SP1PublicValues), SP1CoreProverError> {
+        let program = self.program(&pk.elf);
+        let (tasks, public_values_stream) = plan_shard_tasks(
+            program,
+            stdin,
+            CoreSC::default(),
+            self.core_opts,
+            Some(Arc::new(self)),
+        )?;
+        Ok((tasks, SP1PublicValues::from(&public_values_stream)))
+    }
+
+    /// Proves the shards of a task planned by [Self::plan_core].
+    pub fn prove_core_task(
+        &self,
+        pk: &SP1ProvingKey,
+        task: &ShardProveTask<CoreSC>,
+    ) -> ShardProveResult<CoreSC> {
+        let program = self.program(&pk.elf);
+        prove_shard_task(&self.core_machine, &program, &pk.pk, task)
+    }
+
+    /// Assembles the core proof from the results of all `num_tasks` tasks.
+    pub fn merge_core(
+        &self,
+        stdin: &SP1Stdin,
+        public_values: SP1PublicValues,
+        num_tasks: usize,
+        results: Vec<ShardProveResult<CoreSC>>,
+    ) -> SP1CoreProof {
+        let proof = merge_shard_results(num_tasks, results);
+        SP1CoreProof {
+            proof: SP1CoreProofData(proof.shard_proofs),
+            stdin: stdin.clone(),
+            public_values,
+        }
+    }
+
+    /// Returns the tasks of the leaves of the reduction tree of [Self::compress], along with the
+    /// merger that derives the tasks of the other nodes from their results.
+    pub fn plan_compress(
+        &self,
+        vk: &SP1VerifyingKey,
+        proof: &SP1CoreProof,
+        deferred_proofs: &[ShardProof<InnerSC>],
+    ) -> (Vec<SP1ReduceTask>, SP1ReduceMerger) {
+        let batch_size = self.recursion_opts.reduce_batch_size;
+        let shard_proofs = &proof.proof.0;
+        let leaf_challenger = self.leaf_challenger(vk, shard_proofs);
+        let (core_inputs, deferred_inputs) = self.get_first_layer_inputs(
+            vk,
+            &leaf_challenger,
+            shard_proofs,
+            deferred_proofs,
+            batch_size,
+        );
+
+        let core_tasks = core_inputs
+            .iter()
+            .map(|input| (ReduceProgramType::Core, input.write()));
+        let deferred_tasks = deferred_inputs
+            .iter()
+            .map(|input| (ReduceProgramType::Deferred, input.write()));
+        let leaves = core_tasks
+            .chain(deferred_tasks)
+            .enumerate()
+            .map(|(index, (kind, witness_stream))| SP1ReduceTask {
+                level: 0,
+                index,
+                kind,
+                witness_stream,
+            })
+            .collect::<Vec<_>>();
+
+        let tree = ReduceTree::new(leaves.len(), batch_size);
+        (leaves, SP1ReduceMerger::new(tree, shard_proofs.len()))
+    }
+
+    /// Generates the recursive proof of a task planned by [Self::plan_compress] or returned by a
+    /// [SP1ReduceMerger].
+    pub fn prove_reduce_task(&self, task: SP1ReduceTask) -> SP1ReduceTaskResult {
+        let (program, pk) = match task.kind {
+            ReduceProgramType::Core => (&self.recursion_program, &self.rec_pk),
+            ReduceProgramType::Deferred => (&self.deferred_program, &self.deferred_pk),
+            ReduceProgramType::Reduce => (&self.compress_program, &self.compress_pk),
+        };
+        let proof = self.prove_recursion_witness(task.witness_stream, program, pk);
+        SP1ReduceTaskResult {
+            level: task.level,
+            index: task.index,
+            kind: task.kind,
+            proof,
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use serial_test::serial;
+    use sp1_core::utils::setup_logger;
+
+    use super::*;
+
+    /// Tests that proofs built from tasks sent through bytes, proven in reverse order, verify.
+    #[test]
+    #[serial]
+    fn test_distributed_compress() {
+        setup_logger();
+        let elf = include_bytes!("../../tests/fibonacci/elf/riscv32im-succinct-zkvm-elf");
+        let mut prover = SP1Prover::new();
+        prover.core_opts.shard_size = 1 << 12;
+        prover.core_opts.shard_batch_size = 2;
+        let (pk, vk) = prover.setup(elf);
+        let stdin = SP1Stdin::new();
+
+        let (tasks, public_values) = prover.plan_core(&pk, &stdin).unwrap();
+        let results = tasks
+            .iter()
+            .rev()
+            .map(|task| {
+                let task = bincode::deserialize(&bincode::serialize(task).unwrap()).unwrap();
+                prover.prove_core_task(&pk, &task)
+            })
+            .collect();
+        let core_proof = prover.merge_core(&stdin, public_values, tasks.len(), results);
+        prover.verify(&core_proof.proof, &vk).unwrap();
+
+        let (mut queue, mut merger) = prover.plan_compress(&vk, &core_proof, &[]);
+        while let Some(task) = queue.pop() {
+            let task = bincode::deserialize(&bincode::serialize(&task).unwrap()).unwrap();
+            let result = prover.prove_reduce_task(task);
+            queue.extend(merger.push(&prover, result));
+        }
+        let compressed_proof = merger.finish().unwrap();
+        prover.verify_compressed(&compressed_proof, &vk).unwrap();
+    }
+}
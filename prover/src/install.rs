@@ -3,6 +3,7 @@ use std::{cmp::min, io::Write, path::PathBuf, process::Command};
 use futures::StreamExt;
 use indicatif::{ProgressBar, ProgressStyle};
 use reqwest::Client;
+use sp1_recursion_gnark_ffi::BuildManifest;
 
 use crate::{utils::block_on, SP1_CIRCUIT_VERSION};
 
@@ -46,6 +47,13 @@ pub fn install_plonk_bn254_artifacts(build_dir: PathBuf) {
         .expect("failed to extract tarball");
     res.wait().unwrap();
 
+    // Check the extracted artifacts against the checksums of the build manifest.
+    if let Some(manifest) = BuildManifest::read(&build_dir) {
+        manifest
+            .verify(&build_dir)
+            .expect("downloaded artifacts do not match the build manifest");
+    }
+
     println!(
         "[sp1] downloaded {} to {:?}",
         download_url,
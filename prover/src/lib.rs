@@ -11,7 +11,10 @@
 #![allow(clippy::new_without_default)]
 
 pub mod build;
+pub mod distributed;
 pub mod install;
+mod reduce;
+pub mod setup_cache;
 pub mod types;
 pub mod utils;
 pub mod verify;
@@ -19,18 +22,19 @@ pub mod verify;
 use std::borrow::Borrow;
 use std::path::Path;
 use std::sync::Arc;
+use std::time::Instant;
 
 use p3_baby_bear::BabyBear;
 use p3_challenger::CanObserve;
 use p3_field::{AbstractField, PrimeField};
-use rayon::iter::{IntoParallelIterator, ParallelIterator};
-use rayon::prelude::*;
+use reduce::{reduce_tree, ReduceTree};
+use setup_cache::{SetupCache, SetupCacheEntry};
 use sp1_core::air::{PublicValues, Word};
 pub use sp1_core::io::{SP1PublicValues, SP1Stdin};
 use sp1_core::runtime::{ExecutionError, ExecutionReport, Runtime};
 use sp1_core::stark::{Challenge, StarkProvingKey};
 use sp1_core::stark::{Challenger, MachineVerificationError};
-use sp1_core::utils::{SP1CoreOpts, DIGEST_SIZE};
+use sp1_core::utils::{metrics, SP1CoreOpts, DIGEST_SIZE};
 use sp1_core::{
     runtime::Program,
     stark::{
@@ -40,13 +44,15 @@ use sp1_core::{
 };
 use sp1_primitives::hash_deferred_proof;
 use sp1_recursion_circuit::witness::Witnessable;
-use sp1_recursion_compiler::config::InnerConfig;
+use sp1_recursion_compiler::config::{InnerConfig, OuterConfig};
 use sp1_recursion_compiler::ir::Witness;
 use sp1_recursion_core::{
-    air::RecursionPublicValues,
+    air::{Block, RecursionPublicValues},
     runtime::{RecursionProgram, Runtime as RecursionRuntime},
     stark::{config::BabyBearPoseidon2Outer, RecursionAir},
 };
+pub use sp1_recursion_gnark_ffi::groth16_bn254::Groth16Bn254Proof;
+use sp1_recursion_gnark_ffi::groth16_bn254::Groth16Bn254Prover;
 pub use sp1_recursion_gnark_ffi::plonk_bn254::PlonkBn254Proof;
 use sp1_recursion_gnark_ffi::plonk_bn254::PlonkBn254Prover;
 use sp1_recursion_program::hints::Hintable;
@@ -144,12 +150,21 @@ pub struct SP1Prover {
 
     /// The options for the recursion prover.
     pub recursion_opts: SP1CoreOpts,
+
+    /// The PLONK prover, which keeps the wrap circuit artifacts resident across proofs.
+    pub plonk_bn254_prover: PlonkBn254Prover,
+
+    /// The programs and keys of the ELFs set up so far.
+    pub setup_cache: SetupCache,
 }
 
 impl SP1Prover {
     /// Initializes a new [SP1Prover].
     #[instrument(name = "initialize prover", level = "debug", skip_all)]
     pub fn new() -> Self {
+        // Start serving metrics now if they are enabled, rather than at the first proof.
+        metrics::enabled();
+
         let core_machine = RiscvAir::machine(CoreSC::default());
 
         // Get the recursive verifier and setup the proving and verifying keys.
@@ -203,14 +218,33 @@ impl SP1Prover {
             wrap_machine,
             core_opts: SP1CoreOpts::default(),
             recursion_opts: SP1CoreOpts::recursion(),
+            plonk_bn254_prover: PlonkBn254Prover::new(),
+            setup_cache: SetupCache::from_env(),
         }
     }
 
     /// Creates a proving key and a verifying key for a given RISC-V ELF.
     #[instrument(name = "setup", level = "debug", skip_all)]
     pub fn setup(&self, elf: &[u8]) -> (SP1ProvingKey, SP1VerifyingKey) {
-        let program = Program::from(elf);
-        let (pk, vk) = self.core_machine.setup(&program);
+        let entry = self.setup_entry(elf);
+        (entry.pk.clone(), entry.vk.clone())
+    }
+
+    /// Returns the program and keys of the ELF from the setup cache, setting them up on a miss.
+    pub fn setup_entry(&self, elf: &[u8]) -> Arc<SetupCacheEntry> {
+        self.setup_cache
+            .get_or_setup(elf, |program| self.setup_program(elf, program))
+    }
+
+    /// Returns the disassembled program of the ELF, from the setup cache if it is there. Unlike
+    /// [Self::setup_entry], this never sets the program up.
+    pub fn program(&self, elf: &[u8]) -> Program {
+        self.setup_cache.get_program(elf)
+    }
+
+    /// Creates the keys of the ELF from its disassembled program, bypassing the setup cache.
+    pub fn setup_program(&self, elf: &[u8], program: &Program) -> (SP1ProvingKey, SP1VerifyingKey) {
+        let (pk, vk) = self.core_machine.setup(program);
         let vk = SP1VerifyingKey { vk };
         let pk = SP1ProvingKey {
             pk,
@@ -248,12 +282,12 @@ impl SP1Prover {
         pk: &SP1ProvingKey,
         stdin: &SP1Stdin,
     ) -> Result<SP1CoreProof, SP1CoreProverError> {
-        let config = CoreSC::default();
-        let program = Program::from(&pk.elf);
-        let (proof, public_values_stream) = sp1_core::utils::prove_with_subproof_verifier(
+        let program = self.program(&pk.elf);
+        let (proof, public_values_stream) = sp1_core::utils::prove_with_proving_key(
             program,
+            &pk.pk,
             stdin,
-            config,
+            &self.core_machine,
             self.core_opts,
             Some(Arc::new(self)),
         )?;
@@ -385,6 +419,22 @@ impl SP1Prover {
         (core_inputs, deferred_inputs)
     }
 
+    /// Returns the challenger that observed the verifying key and the commitments and public values
+    /// of all shard proofs, which every recursive proof of a core shard starts from.
+    pub fn leaf_challenger(
+        &self,
+        vk: &SP1VerifyingKey,
+        shard_proofs: &[ShardProof<CoreSC>],
+    ) -> Challenger<CoreSC> {
+        let mut leaf_challenger = self.core_machine.config().challenger();
+        vk.vk.observe_into(&mut leaf_challenger);
+        shard_proofs.iter().for_each(|proof| {
+            leaf_challenger.observe(proof.commitment.main_commit);
+            leaf_challenger.observe_slice(&proof.public_values[0..self.core_machine.num_pv_elts()]);
+        });
+        leaf_challenger
+    }
+
     /// Reduce shards proofs to a single shard proof using the recursion prover.
     #[instrument(name = "compress", level = "info", skip_all)]
     pub fn compress(
@@ -393,18 +443,15 @@ impl SP1Prover {
         proof: SP1CoreProof,
         deferred_proofs: Vec<ShardProof<InnerSC>>,
     ) -> Result<SP1ReduceProof<InnerSC>, SP1RecursionProverError> {
+        let start = Instant::now();
+
         // Set the batch size for the reduction tree.
-        let batch_size = 2;
+        let opts = self.recursion_opts;
+        let batch_size = opts.reduce_batch_size;
 
         let shard_proofs = &proof.proof.0;
         let total_core_shards = shard_proofs.len();
-        // Get the leaf challenger.
-        let mut leaf_challenger = self.core_machine.config().challenger();
-        vk.vk.observe_into(&mut leaf_challenger);
-        shard_proofs.iter().for_each(|proof| {
-            leaf_challenger.observe(proof.commitment.main_commit);
-            leaf_challenger.observe_slice(&proof.public_values[0..self.core_machine.num_pv_elts()]);
-        });
+        let leaf_challenger = self.leaf_challenger(vk, shard_proofs);
 
         // Run the recursion and reduce programs.
         let (core_inputs, deferred_inputs) = self.get_first_layer_inputs(
@@ -415,82 +462,53 @@ impl SP1Prover {
             batch_size,
         );
 
-        let mut reduce_proofs = Vec::new();
-        let opts = self.recursion_opts;
-        let shard_batch_size = opts.shard_batch_size;
-        for inputs in core_inputs.chunks(shard_batch_size) {
-            let proofs = inputs
-                .into_par_iter()
-                .map(|input| {
+        // The leaves of the reduction tree are the recursive proofs of the core shards followed
+        // by those of the deferred proofs. Each reduction starts as soon as its children are done,
+        // with at most `shard_batch_size` recursive proofs generated at once.
+        let tree = ReduceTree::new(core_inputs.len() + deferred_inputs.len(), batch_size);
+        let reduce_proof = reduce_tree(
+            &tree,
+            opts.shard_batch_size,
+            |i| match core_inputs.get(i) {
+                Some(input) => {
                     let proof =
                         self.compress_machine_proof(input, &self.recursion_program, &self.rec_pk);
                     (proof, ReduceProgramType::Core)
-                })
-                .collect::<Vec<_>>();
-            reduce_proofs.extend(proofs);
-        }
-
-        // Run the deferred proofs programs.
-        for inputs in deferred_inputs.chunks(shard_batch_size) {
-            let proofs = inputs
-                .into_par_iter()
-                .map(|input| {
+                }
+                None => {
+                    let input = &deferred_inputs[i - core_inputs.len()];
                     let proof = self.compress_machine_proof(
                         input,
                         &self.deferred_program,
                         &self.deferred_pk,
                     );
                     (proof, ReduceProgramType::Deferred)
-                })
-                .collect::<Vec<_>>();
-            reduce_proofs.extend(proofs);
-        }
-
-        // Iterate over the recursive proof batches until there is one proof remaining.
-        let mut is_complete;
-        loop {
-            tracing::debug!("Recursive proof layer size: {}", reduce_proofs.len());
-            is_complete = reduce_proofs.len() <= batch_size;
-
-            let compress_inputs = reduce_proofs.chunks(batch_size).collect::<Vec<_>>();
-            let batched_compress_inputs =
-                compress_inputs.chunks(shard_batch_size).collect::<Vec<_>>();
-            reduce_proofs = batched_compress_inputs
-                .into_iter()
-                .flat_map(|batches| {
-                    batches
-                        .par_iter()
-                        .map(|batch| {
-                            let (shard_proofs, kinds) =
-                                batch.iter().cloned().unzip::<_, _, Vec<_>, Vec<_>>();
-
-                            let input = SP1ReduceMemoryLayout {
-                                compress_vk: &self.compress_vk,
-                                recursive_machine: &self.compress_machine,
-                                shard_proofs,
-                                kinds,
-                                is_complete,
-                                total_core_shards,
-                            };
-
-                            let proof = self.compress_machine_proof(
-                                input,
-                                &self.compress_program,
-                                &self.compress_pk,
-                            );
-                            (proof, ReduceProgramType::Reduce)
-                        })
-                        .collect::<Vec<_>>()
-                })
-                .collect::<Vec<_>>();
-
-            if reduce_proofs.len() == 1 {
-                break;
-            }
-        }
-        debug_assert_eq!(reduce_proofs.len(), 1);
-        let reduce_proof = reduce_proofs.pop().unwrap();
+                }
+            },
+            |batch, is_complete| {
+                tracing::debug!("Reducing {} proofs", batch.len());
+                let (shard_proofs, kinds) = batch.into_iter().unzip::<_, _, Vec<_>, Vec<_>>();
+
+                let input = SP1ReduceMemoryLayout {
+                    compress_vk: &self.compress_vk,
+                    recursive_machine: &self.compress_machine,
+                    shard_proofs,
+                    kinds,
+                    is_complete,
+                    total_core_shards,
+                };
+
+                let proof =
+                    self.compress_machine_proof(input, &self.compress_program, &self.compress_pk);
+                (proof, ReduceProgramType::Reduce)
+            },
+        );
 
+        metrics::observe_histogram(
+            "sp1_prover_stage_seconds",
+            &[("stage", "compress")],
+            start.elapsed().as_secs_f64(),
+        );
         Ok(SP1ReduceProof {
             proof: reduce_proof.0,
         })
@@ -501,15 +519,22 @@ impl SP1Prover {
         input: impl Hintable<InnerConfig>,
         program: &RecursionProgram<BabyBear>,
         pk: &StarkProvingKey<InnerSC>,
+    ) -> ShardProof<InnerSC> {
+        self.prove_recursion_witness(input.write(), program, pk)
+    }
+
+    /// Runs a recursion program on a serialized witness stream and proves its execution.
+    pub fn prove_recursion_witness(
+        &self,
+        witness_stream: Vec<Vec<Block<BabyBear>>>,
+        program: &RecursionProgram<BabyBear>,
+        pk: &StarkProvingKey<InnerSC>,
     ) -> ShardProof<InnerSC> {
         let mut runtime = RecursionRuntime::<Val<InnerSC>, Challenge<InnerSC>, _>::new(
             program,
             self.compress_machine.config().perm.clone(),
         );
 
-        let mut witness_stream = Vec::new();
-        witness_stream.extend(input.write());
-
         runtime.witness_stream = witness_stream.into();
         runtime.run();
         runtime.print_stats();
@@ -529,6 +554,8 @@ impl SP1Prover {
         &self,
         reduced_proof: SP1ReduceProof<InnerSC>,
     ) -> Result<SP1ReduceProof<InnerSC>, SP1RecursionProverError> {
+        let start = Instant::now();
+
         // Make the compress proof.
         let input = SP1RootMemoryLayout {
             machine: &self.compress_machine,
@@ -560,6 +587,11 @@ impl SP1Prover {
             opts,
         );
 
+        metrics::observe_histogram(
+            "sp1_prover_stage_seconds",
+            &[("stage", "shrink")],
+            start.elapsed().as_secs_f64(),
+        );
         Ok(SP1ReduceProof {
             proof: compress_proof.shard_proofs.pop().unwrap(),
         })
@@ -571,6 +603,7 @@ impl SP1Prover {
         &self,
         compressed_proof: SP1ReduceProof<InnerSC>,
     ) -> Result<SP1ReduceProof<OuterSC>, SP1RecursionProverError> {
+        let start = Instant::now();
         let input = SP1RootMemoryLayout {
             machine: &self.shrink_machine,
             proof: compressed_proof.proof,
@@ -594,7 +627,7 @@ impl SP1Prover {
         // Prove the wrap program.
         let opts = self.recursion_opts;
         let mut wrap_challenger = self.wrap_machine.config().challenger();
-        let time = std::time::Instant::now();
+        let time = Instant::now();
         let mut wrap_proof = self.wrap_machine.prove::<LocalProver<_, _>>(
             &self.wrap_pk,
             runtime.record,
@@ -616,11 +649,25 @@ impl SP1Prover {
         }
         tracing::info!("Wrapping successful");
 
+        metrics::observe_histogram(
+            "sp1_prover_stage_seconds",
+            &[("stage", "wrap_bn254")],
+            start.elapsed().as_secs_f64(),
+        );
         Ok(SP1ReduceProof {
             proof: wrap_proof.shard_proofs.pop().unwrap(),
         })
     }
 
+    /// The witness of the PLONK and Groth16 circuits for a proof over the SNARK-friendly field.
+    pub fn bn254_witness(proof: &SP1ReduceProof<OuterSC>) -> Witness<OuterConfig> {
+        let mut witness = Witness::default();
+        proof.proof.write(&mut witness);
+        witness.write_commited_values_digest(proof.sp1_commited_values_digest_bn254());
+        witness.write_vkey_hash(proof.sp1_vkey_digest_bn254());
+        witness
+    }
+
     /// Wrap the STARK proven over a SNARK-friendly field into a PLONK proof.
     #[instrument(name = "wrap_plonk_bn254", level = "info", skip_all)]
     pub fn wrap_plonk_bn254(
@@ -628,15 +675,42 @@ impl SP1Prover {
         proof: SP1ReduceProof<OuterSC>,
         build_dir: &Path,
     ) -> PlonkBn254Proof {
+        let start = Instant::now();
         let vkey_digest = proof.sp1_vkey_digest_bn254();
         let commited_values_digest = proof.sp1_commited_values_digest_bn254();
+        let witness = Self::bn254_witness(&proof);
 
-        let mut witness = Witness::default();
-        proof.proof.write(&mut witness);
-        witness.write_commited_values_digest(commited_values_digest);
-        witness.write_vkey_hash(vkey_digest);
+        let prover = &self.plonk_bn254_prover;
+        let proof = prover.prove(witness, build_dir.to_path_buf());
+
+        // Verify the proof.
+        prover.verify(
+            &proof,
+            &vkey_digest.as_canonical_biguint(),
+            &commited_values_digest.as_canonical_biguint(),
+            build_dir,
+        );
+
+        metrics::observe_histogram(
+            "sp1_prover_stage_seconds",
+            &[("stage", "wrap_plonk_bn254")],
+            start.elapsed().as_secs_f64(),
+        );
+        proof
+    }
+
+    /// Wrap the STARK proven over a SNARK-friendly field into a Groth16 proof.
+    #[instrument(name = "wrap_groth16_bn254", level = "info", skip_all)]
+    pub fn wrap_groth16_bn254(
+        &self,
+        proof: SP1ReduceProof<OuterSC>,
+        build_dir: &Path,
+    ) -> Groth16Bn254Proof {
+        let vkey_digest = proof.sp1_vkey_digest_bn254();
+        let commited_values_digest = proof.sp1_commited_values_digest_bn254();
+        let witness = Self::bn254_witness(&proof);
 
-        let prover = PlonkBn254Prover::new();
+        let prover = Groth16Bn254Prover::new();
         let proof = prover.prove(witness, build_dir.to_path_buf());
 
         // Verify the proof.
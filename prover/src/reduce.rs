@@ -0,0 +1,252 @@
+//! A dependency-driven scheduler for the reduction tree of the compress step.
+
+use std::collections::BinaryHeap;
+use std::sync::{Condvar, Mutex};
+
+use sp1_core::utils::metrics;
+
+/// The shape of a reduction tree over `num_leaves` leaves.
+///
+/// Each level groups consecutive nodes of the level below into chunks of `arity`, the last chunk
+/// possibly being smaller, until a level of a single node remains. There is always at least one
+/// level above the leaves, so a single leaf is still reduced once.
+#[derive(Debug, Clone)]
+pub struct ReduceTree {
+    arity: usize,
+    /// The number of nodes at each level, starting with the leaves.
+    level_sizes: Vec<usize>,
+}
+
+impl ReduceTree {
+    pub fn new(num_leaves: usize, arity: usize) -> Self {
+        assert!(num_leaves > 0, "the reduction tree needs at least one leaf");
+        assert!(
+            arity > 1,
+            "the reduction tree needs an arity of at least two"
+        );
+        let mut level_sizes = vec![num_leaves];
+        loop {
+            let size = *level_sizes.last().unwrap();
+            level_sizes.push(size.div_ceil(arity));
+            if size <= arity {
+                break;
+            }
+        }
+        Self { arity, level_sizes }
+    }
+
+    /// The index of the root level.
+    pub fn root_level(&self) -> usize {
+        self.level_sizes.len() - 1
+    }
+
+    /// The number of nodes at the level.
+    pub fn level_size(&self, level: usize) -> usize {
+        self.level_sizes[level]
+    }
+
+    /// The index of the parent of a node below the root.
+    pub fn parent(&self, index: usize) -> usize {
+        index / self.arity
+    }
+
+    /// The number of children of a node above the leaves.
+    pub fn num_children(&self, level: usize, index: usize) -> usize {
+        let below = self.level_sizes[level - 1];
+        self.arity.min(below - index * self.arity)
+    }
+
+    /// The indices of the children of a node above the leaves, in the level below.
+    pub fn children(&self, level: usize, index: usize) -> std::ops::Range<usize> {
+        let start = index * self.arity;
+        start..start + self.num_children(level, index)
+    }
+}
+
+/// A node of the tree that is ready to be computed. Higher levels compare greater, and within a
+/// level the leftmost node does, so the nodes closest to the root are reduced first.
+#[derive(Debug, PartialEq, Eq, PartialOrd, Ord)]
+struct ReadyNode {
+    level: usize,
+    rev_index: std::cmp::Reverse<usize>,
+}
+
+struct SchedulerState<T> {
+    /// The outputs of the nodes whose parents are not ready yet, per level.
+    outputs: Vec<Vec<Option<T>>>,
+    /// The number of children each node is still waiting for, per level.
+    pending: Vec<Vec<usize>>,
+    ready: BinaryHeap<ReadyNode>,
+    next_leaf: usize,
+    root: Option<T>,
+    /// Set when the root is done or a worker panicked.
+    stopped: bool,
+}
+
+/// Computes the reduction tree on `num_workers` threads, returning the output of the root.
+///
+/// `leaf` computes the leaf with the given index and `reduce` combines the outputs of the children
+/// of a node, in order, with a flag telling whether the node is the root. A node is reduced as soon
+/// as all of its children are done. Workers take ready reductions before new leaves, so the tree
+/// is finished from the left and the outputs held in memory stay few.
+pub fn reduce_tree<T, L, R>(tree: &ReduceTree, num_workers: usize, leaf: L, reduce: R) -> T
+where
+    T: Send,
+    L: Fn(usize) -> T + Sync,
+    R: Fn(Vec<T>, bool) -> T + Sync,
+{
+    let root_level = tree.root_level();
+    let state = Mutex::new(SchedulerState {
+        outputs: tree
+            .level_sizes
+            .iter()
+            .map(|&size| (0..size).map(|_| None).collect())
+            .collect(),
+        pending: (0..tree.level_sizes.len())
+            .map(|level| match level {
+                0 => vec![0; tree.level_sizes[0]],
+                _ => (0..tree.level_sizes[level])
+                    .map(|index| tree.num_children(level, index))
+                    .collect(),
+            })
+            .collect(),
+        ready: BinaryHeap::new(),
+        next_leaf: 0,
+        root: None,
+        stopped: false,
+    });
+    let condvar = Condvar::new();
+    let span = tracing::Span::current();
+
+    std::thread::scope(|s| {
+        for _ in 0..num_workers.max(1) {
+            let (state, condvar, leaf, reduce) = (&state, &condvar, &leaf, &reduce);
+            let span = span.clone();
+            s.spawn(move || {
+                let _guard = span.enter();
+                let _stop = StopOnPanic { state, condvar };
+                loop {
+                    // Take the next job, reductions first.
+                    let job = {
+                        let mut guard = state.lock().unwrap();
+                        loop {
+                            if guard.stopped {
+                                return;
+                            }
+                            if let Some(node) = guard.ready.pop() {
+                                metrics::set_gauge(
+                                    "sp1_reduce_ready_nodes",
+                                    &[],
+                                    guard.ready.len() as f64,
+                                );
+                                let index = node.rev_index.0;
+                                let range = tree.children(node.level, index);
+                                let children = guard.outputs[node.level - 1][range]
+                                    .iter_mut()
+                                    .map(|output| output.take().unwrap())
+                                    .collect::<Vec<_>>();
+                                break (node.level, index, Some(children));
+                            }
+                            if guard.next_leaf < tree.level_sizes[0] {
+                                guard.next_leaf += 1;
+                                break (0, guard.next_leaf - 1, None);
+                            }
+                            guard = condvar.wait(guard).unwrap();
+                        }
+                    };
+
+                    let (level, index, children) = job;
+                    let output = match children {
+                        Some(children) => {
+                            metrics::time("sp1_reduce_node_seconds", &[("kind", "reduce")], || {
+                                reduce(children, level == root_level)
+                            })
+                        }
+                        None => {
+                            metrics::time("sp1_reduce_node_seconds", &[("kind", "leaf")], || {
+                                leaf(index)
+                            })
+                        }
+                    };
+
+                    // Hand the output to the parent, which becomes ready with its last child.
+                    let mut guard = state.lock().unwrap();
+                    if level == root_level {
+                        guard.root = Some(output);
+                        guard.stopped = true;
+                        condvar.notify_all();
+                        return;
+                    }
+                    guard.outputs[level][index] = Some(output);
+                    let parent = tree.parent(index);
+                    guard.pending[level + 1][parent] -= 1;
+                    if guard.pending[level + 1][parent] == 0 {
+                        guard.ready.push(ReadyNode {
+                            level: level + 1,
+                            rev_index: std::cmp::Reverse(parent),
+                        });
+                        metrics::set_gauge("sp1_reduce_ready_nodes", &[], guard.ready.len() as f64);
+                        condvar.notify_one();
+                    }
+                }
+            });
+        }
+    });
+
+    state
+        .into_inner()
+        .unwrap()
+        .root
+        .expect("the reduction tree was not completed")
+}
+
+/// Stops the scheduler when a worker panics, so that the other workers do not wait forever.
+struct StopOnPanic<'a, T> {
+    state: &'a Mutex<SchedulerState<T>>,
+    condvar: &'a Condvar,
+}
+
+impl<T> Drop for StopOnPanic<'_, T> {
+    fn drop(&mut self) {
+        if std::thread::panicking() {
+            let mut guard = self.state.lock().unwrap_or_else(|e| e.into_inner());
+            guard.stopped = true;
+            self.condvar.notify_all();
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_reduce_tree_matches_levels() {
+        for num_leaves in 1..20 {
+            for arity in 2..5 {
+                let tree = ReduceTree::new(num_leaves, arity);
+
+                // Reduce the leaves level by level, as the compress step did before.
+                let mut level = (0..num_leaves).map(|i| i.to_string()).collect::<Vec<_>>();
+                loop {
+                    let is_complete = level.len() <= arity;
+                    level = level
+                        .chunks(arity)
+                        .map(|chunk| format!("({}{})", chunk.join(" "), is_complete))
+                        .collect();
+                    if level.len() == 1 {
+                        break;
+                    }
+                }
+
+                let root = reduce_tree(
+                    &tree,
+                    3,
+                    |i| i.to_string(),
+                    |children, is_complete| format!("({}{})", children.join(" "), is_complete),
+                );
+                assert_eq!(root, level[0]);
+            }
+        }
+    }
+}
@@ -0,0 +1,192 @@
+//! A cache of the programs and keys set up by the prover.
+//!
+//! Setting up a program disassembles its ELF and commits to its preprocessed traces, which takes
+//! seconds for large programs. The cache keeps the result in memory for the lifetime of the
+//! prover and, if a directory is configured, on disk across processes. Entries are addressed by
+//! the digest of the ELF and [SP1_CIRCUIT_VERSION], so a new version of the circuits never reads
+//! keys set up by an older one.
+
+use std::collections::HashMap;
+use std::fs::{self, File};
+use std::io::{Read, Write};
+use std::path::{Path, PathBuf};
+use std::sync::{Arc, Mutex};
+
+use serde::{Deserialize, Serialize};
+use sha2::{Digest, Sha256};
+use sp1_core::runtime::Program;
+
+use crate::{SP1ProvingKey, SP1VerifyingKey, SP1_CIRCUIT_VERSION};
+
+/// The environment variable that enables the on-disk cache in the given directory.
+pub const SETUP_CACHE_DIR_ENV: &str = "SP1_SETUP_CACHE_DIR";
+
+/// The program and keys of an ELF.
+#[derive(Clone, Serialize, Deserialize)]
+pub struct SetupCacheEntry {
+    pub program: Program,
+    pub pk: SP1ProvingKey,
+    pub vk: SP1VerifyingKey,
+}
+
+/// The cache of [SetupCacheEntry]s, keyed by [SetupCache::digest].
+///
+/// The in-memory cache is not bounded, as a prover serves a few programs that it proves many
+/// times.
+pub struct SetupCache {
+    dir: Option<PathBuf>,
+    entries: Mutex<HashMap<[u8; 32], Arc<SetupCacheEntry>>>,
+}
+
+impl SetupCache {
+    /// Creates a cache that also stores its entries in `dir`, if given.
+    pub fn new(dir: Option<PathBuf>) -> Self {
+        Self {
+            dir,
+            entries: Mutex::new(HashMap::new()),
+        }
+    }
+
+    /// Creates a cache that stores its entries on disk if [SETUP_CACHE_DIR_ENV] is set.
+    pub fn from_env() -> Self {
+        Self::new(std::env::var_os(SETUP_CACHE_DIR_ENV).map(PathBuf::from))
+    }
+
+    /// The key of the entry of an ELF.
+    pub fn digest(elf: &[u8]) -> [u8; 32] {
+        let mut hasher = Sha256::new();
+        hasher.update(SP1_CIRCUIT_VERSION.as_bytes());
+        hasher.update((elf.len() as u64).to_le_bytes());
+        hasher.update(elf);
+        hasher.finalize().into()
+    }
+
+    /// Returns the program of the ELF if it is cached in memory, and otherwise disassembles it
+    /// without setting it up.
+    pub fn get_program(&self, elf: &[u8]) -> Program {
+        match self.entries.lock().unwrap().get(&Self::digest(elf)) {
+            Some(entry) => entry.program.clone(),
+            None => Program::from(elf),
+        }
+    }
+
+    /// Returns the entry of the ELF, loading it from disk or calling `setup` with the
+    /// disassembled program if it is not cached yet.
+    pub fn get_or_setup(
+        &self,
+        elf: &[u8],
+        setup: impl FnOnce(&Program) -> (SP1ProvingKey, SP1VerifyingKey),
+    ) -> Arc<SetupCacheEntry> {
+        let digest = Self::digest(elf);
+        if let Some(entry) = self.entries.lock().unwrap().get(&digest) {
+            return entry.clone();
+        }
+
+        // Set up outside of the lock, so that other programs can be set up meanwhile.
+        let path = self
+            .dir
+            .as_ref()
+            .map(|dir| dir.join(entry_file_name(&digest)));
+        let entry = match path.as_deref().and_then(read_entry) {
+            Some(entry) => {
+                tracing::debug!("loaded setup of program {}", hex::encode(digest));
+                entry
+            }
+            None => {
+                let program = Program::from(elf);
+                let (pk, vk) = tracing::debug_span!("setup program").in_scope(|| setup(&program));
+                let entry = SetupCacheEntry { program, pk, vk };
+                if let Some(path) = path.as_deref() {
+                    if let Err(e) = write_entry(path, &entry) {
+                        tracing::warn!("failed to write setup cache entry {:?}: {}", path, e);
+                    }
+                }
+                entry
+            }
+        };
+
+        self.entries
+            .lock()
+            .unwrap()
+            .entry(digest)
+            .or_insert_with(|| Arc::new(entry))
+            .clone()
+    }
+}
+
+fn entry_file_name(digest: &[u8; 32]) -> String {
+    format!("{}.bin", hex::encode(digest))
+}
+
+/// Reads an entry, treating a missing or unreadable file as a miss.
+fn read_entry(path: &Path) -> Option<SetupCacheEntry> {
+    let mut file = File::open(path).ok()?;
+    let mut bytes = Vec::new();
+    if let Err(e) = file.read_to_end(&mut bytes) {
+        tracing::warn!("failed to read setup cache entry {:?}: {}", path, e);
+        return None;
+    }
+    match bincode::deserialize(&bytes) {
+        Ok(entry) => Some(entry),
+        Err(e) => {
+            tracing::warn!("ignoring corrupt setup cache entry {:?}: {}", path, e);
+            None
+        }
+    }
+}
+
+/// Writes an entry through a temporary file in the same directory, so that a concurrent reader
+/// never sees a partial entry.
+fn write_entry(path: &Path, entry: &SetupCacheEntry) -> anyhow::Result<()> {
+    let dir = path.parent().unwrap();
+    fs::create_dir_all(dir)?;
+    let mut file = tempfile::NamedTempFile::new_in(dir)?;
+    file.write_all(&bincode::serialize(entry)?)?;
+    file.persist(path)?;
+    Ok(())
+}
+
+#[cfg(test)]
+mod tests {
+    use std::sync::atomic::{AtomicUsize, Ordering};
+
+    use serial_test::serial;
+
+    use super::*;
+    use crate::SP1Prover;
+
+    #[test]
+    #[serial]
+    fn test_setup_cache() {
+        let elf = include_bytes!("../../tests/fibonacci/elf/riscv32im-succinct-zkvm-elf");
+        let prover = SP1Prover::new();
+        let dir = tempfile::tempdir().unwrap();
+        let setups = AtomicUsize::new(0);
+        let setup = |program: &Program| {
+            setups.fetch_add(1, Ordering::Relaxed);
+            prover.setup_program(elf, program)
+        };
+
+        let cache = SetupCache::new(Some(dir.path().to_path_buf()));
+        let entry = cache.get_or_setup(elf, setup);
+        assert!(Arc::ptr_eq(&entry, &cache.get_or_setup(elf, setup)));
+        assert_eq!(setups.load(Ordering::Relaxed), 1);
+
+        // A new cache over the same directory loads the entry instead of setting it up.
+        let cache = SetupCache::new(Some(dir.path().to_path_buf()));
+        let loaded = cache.get_or_setup(elf, setup);
+        assert_eq!(setups.load(Ordering::Relaxed), 1);
+        assert_eq!(
+            bincode::serialize(&loaded.vk).unwrap(),
+            bincode::serialize(&entry.vk).unwrap()
+        );
+
+        // Looking up only the program never sets it up.
+        let program = SetupCache::new(None).get_program(elf);
+        assert_eq!(setups.load(Ordering::Relaxed), 1);
+        assert_eq!(
+            bincode::serialize(&program).unwrap(),
+            bincode::serialize(&entry.program).unwrap()
+        );
+    }
+}
@@ -13,7 +13,9 @@ use sp1_core::{
     utils::BabyBearPoseidon2,
 };
 use sp1_recursion_core::{air::RecursionPublicValues, stark::config::BabyBearPoseidon2Outer};
-use sp1_recursion_gnark_ffi::{PlonkBn254Proof, PlonkBn254Prover};
+use sp1_recursion_gnark_ffi::{
+    Groth16Bn254Proof, Groth16Bn254Prover, PlonkBn254Proof, PlonkBn254Prover,
+};
 use thiserror::Error;
 
 use crate::{
@@ -275,6 +277,69 @@ impl SP1Prover {
 
         Ok(())
     }
+
+    /// Verifies PLONK proofs of the same program in parallel using the circuit artifacts in the
+    /// build directory, returning the result of each proof in order.
+    pub fn verify_plonk_bn254_batch(
+        &self,
+        proofs: &[(&PlonkBn254Proof, &SP1PublicValues)],
+        vk: &SP1VerifyingKey,
+        build_dir: &Path,
+    ) -> Vec<Result<()>> {
+        let prover = PlonkBn254Prover::new();
+
+        let public_inputs = proofs
+            .iter()
+            .map(|(proof, _)| {
+                let vkey_hash = BigUint::from_str(&proof.public_inputs[0])?;
+                let committed_values_digest = BigUint::from_str(&proof.public_inputs[1])?;
+                Ok((vkey_hash, committed_values_digest))
+            })
+            .collect::<Vec<Result<_>>>();
+
+        // Verify the proofs whose public inputs parse with the corresponding public inputs.
+        let requests = proofs
+            .iter()
+            .zip(public_inputs.iter())
+            .filter_map(|((proof, _), inputs)| {
+                let (vkey_hash, committed_values_digest) = inputs.as_ref().ok()?;
+                Some((*proof, vkey_hash, committed_values_digest))
+            })
+            .collect::<Vec<_>>();
+        let mut verified = prover.verify_batch(&requests, build_dir).into_iter();
+
+        proofs
+            .iter()
+            .zip(public_inputs)
+            .map(|((proof, public_values), inputs)| {
+                inputs?;
+                verified.next().unwrap().map_err(anyhow::Error::msg)?;
+                verify_plonk_bn254_public_inputs(vk, public_values, &proof.public_inputs)
+            })
+            .collect()
+    }
+
+    /// Verifies a Groth16 proof using the circuit artifacts in the build directory.
+    pub fn verify_groth16_bn254(
+        &self,
+        proof: &Groth16Bn254Proof,
+        vk: &SP1VerifyingKey,
+        public_values: &SP1PublicValues,
+        build_dir: &Path,
+    ) -> Result<()> {
+        let prover = Groth16Bn254Prover::new();
+
+        let vkey_hash = BigUint::from_str(&proof.public_inputs[0])?;
+        let committed_values_digest = BigUint::from_str(&proof.public_inputs[1])?;
+
+        // Verify the proof with the corresponding public inputs.
+        prover.verify(proof, &vkey_hash, &committed_values_digest, build_dir);
+
+        // The public inputs are the same as for the plonk circuit.
+        verify_plonk_bn254_public_inputs(vk, public_values, &proof.public_inputs)?;
+
+        Ok(())
+    }
 }
 
 /// Verify the vk_hash and public_values_hash in the public inputs of the PlonkBn254Proof match the expected values.
@@ -183,6 +183,9 @@ mod tests {
         let mut backend = ConstraintCompiler::<OuterConfig>::default();
         let constraints = backend.emit(builder.operations);
         PlonkBn254Prover::test::<OuterConfig>(constraints.clone(), Witness::default());
+
+        // Also run the circuit from JSON constraints, which are still accepted by the Go side.
+        PlonkBn254Prover::test_json::<OuterConfig>(constraints, Witness::default());
     }
 
     #[test]
@@ -412,6 +412,7 @@ pub(crate) mod tests {
         RecursionProgram::<F> {
             instructions,
             traces: vec![None],
+            ..Default::default()
         }
     }
 }
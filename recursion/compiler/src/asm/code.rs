@@ -77,6 +77,7 @@ impl<F: PrimeField32, EF: ExtensionField<F>> AssemblyCode<F, EF> {
         RecursionProgram {
             instructions: machine_code,
             traces,
+            ..Default::default()
         }
     }
 }
@@ -0,0 +1,208 @@
+//! A dense binary encoding of a constraint system.
+//!
+//! The JSON form of [Constraint] refers to values by string ids such as `var123`, which forces the
+//! Go interpreter to keep every intermediate value in string-keyed maps. The binary form replaces
+//! opcodes by their [ConstraintOpcode] discriminant and ids by dense slot indices, one index space
+//! per value kind, so that the interpreter can preallocate slices and index them directly.
+//!
+//! All integers are little-endian:
+//!
+//! `magic | u32 num_vars | u32 num_felts | u32 num_exts | u32 num_constraints | constraints`
+//!
+//! where each constraint is `u8 opcode | u8 num_args | args` and each argument is
+//! `u32 num_words | words`. Slot indices, felt immediates and plain integers take one word each,
+//! while BN254 immediates take eight words.
+
+use std::collections::HashMap;
+
+use super::{opcodes::ConstraintOpcode, Constraint};
+
+/// The magic bytes at the start of a binary constraint program.
+pub const CONSTRAINT_PROGRAM_MAGIC: &[u8; 4] = b"SP1C";
+
+/// The number of 32-bit words used to encode a BN254 immediate.
+const BN254_WORDS: usize = 8;
+
+/// The interpretation of a constraint argument.
+#[derive(Debug, Clone, Copy)]
+enum ArgKind {
+    Var,
+    Felt,
+    Ext,
+    VarImm,
+    FeltImm,
+    Int,
+}
+
+/// Returns the kind of each argument of a constraint with the given opcode.
+fn arg_kinds(opcode: ConstraintOpcode) -> &'static [ArgKind] {
+    use ArgKind::*;
+    use ConstraintOpcode::*;
+    match opcode {
+        ImmV => &[Var, VarImm],
+        ImmF => &[Felt, FeltImm],
+        ImmE => &[Ext, FeltImm],
+        AddV | SubV | MulV => &[Var, Var, Var],
+        AddF | SubF | MulF => &[Felt, Felt, Felt],
+        AddE | SubE | MulE | DivE => &[Ext, Ext, Ext],
+        AddEF | SubEF | MulEF => &[Ext, Ext, Felt],
+        NegE | InvE => &[Ext, Ext],
+        Num2BitsV => &[Var, Var, Int],
+        Num2BitsF => &[Var, Felt],
+        Permute => &[Var, Var, Var],
+        PermuteBabyBear => &[Felt; 16],
+        SelectV => &[Var, Var, Var, Var],
+        SelectF => &[Felt, Var, Felt, Felt],
+        SelectE => &[Ext, Var, Ext, Ext],
+        Ext2Felt => &[Felt, Felt, Felt, Felt, Ext],
+        AssertEqV => &[Var, Var],
+        AssertEqF => &[Felt, Felt],
+        AssertEqE => &[Ext, Ext],
+        PrintV | CommitVkeyHash | CommitCommitedValuesDigest => &[Var],
+        PrintF => &[Felt],
+        PrintE => &[Ext],
+        WitnessV => &[Var, Int],
+        WitnessF => &[Felt, Int],
+        WitnessE => &[Ext, Int],
+        CircuitFelts2Ext => &[Ext, Felt, Felt, Felt, Felt],
+        DivF | DivEF | NegV | NegF | InvV | InvF => {
+            panic!("opcode {:?} is not supported by the circuit", opcode)
+        }
+    }
+}
+
+/// Assigns dense slot indices to string ids in order of first appearance.
+#[derive(Debug, Default)]
+struct SlotAllocator {
+    slots: HashMap<String, u32>,
+}
+
+impl SlotAllocator {
+    fn slot(&mut self, id: &str) -> u32 {
+        let next = self.slots.len() as u32;
+        *self.slots.entry(id.to_string()).or_insert(next)
+    }
+
+    fn len(&self) -> u32 {
+        self.slots.len() as u32
+    }
+}
+
+/// Parses a decimal string into little-endian 32-bit words.
+fn decimal_to_words(value: &str) -> [u32; BN254_WORDS] {
+    let mut words = [0u32; BN254_WORDS];
+    for digit in value.bytes() {
+        assert!(digit.is_ascii_digit(), "invalid immediate {}", value);
+        let mut carry = (digit - b'0') as u64;
+        for word in words.iter_mut() {
+            let acc = (*word as u64) * 10 + carry;
+            *word = acc as u32;
+            carry = acc >> 32;
+        }
+        assert_eq!(carry, 0, "immediate {} does not fit in 256 bits", value);
+    }
+    words
+}
+
+fn parse_u32(value: &str) -> u32 {
+    value
+        .parse()
+        .unwrap_or_else(|_| panic!("invalid integer {}", value))
+}
+
+/// Encodes a list of constraints into the binary constraint program format.
+pub fn encode_constraints(constraints: &[Constraint]) -> Vec<u8> {
+    let mut vars = SlotAllocator::default();
+    let mut felts = SlotAllocator::default();
+    let mut exts = SlotAllocator::default();
+
+    let mut body = Vec::new();
+    for constraint in constraints {
+        let kinds = arg_kinds(constraint.opcode);
+        assert_eq!(
+            kinds.len(),
+            constraint.args.len(),
+            "wrong number of arguments for {:?}",
+            constraint.opcode
+        );
+        body.push(constraint.opcode as u8);
+        body.push(kinds.len() as u8);
+        for (kind, arg) in kinds.iter().zip(constraint.args.iter()) {
+            let mut words = Vec::with_capacity(arg.len());
+            for value in arg.iter() {
+                match kind {
+                    ArgKind::Var => words.push(vars.slot(value)),
+                    ArgKind::Felt => words.push(felts.slot(value)),
+                    ArgKind::Ext => words.push(exts.slot(value)),
+                    ArgKind::VarImm => words.extend(decimal_to_words(value)),
+                    ArgKind::FeltImm | ArgKind::Int => words.push(parse_u32(value)),
+                }
+            }
+            body.extend_from_slice(&(words.len() as u32).to_le_bytes());
+            for word in words {
+                body.extend_from_slice(&word.to_le_bytes());
+            }
+        }
+    }
+
+    let mut bytes = Vec::with_capacity(CONSTRAINT_PROGRAM_MAGIC.len() + 16 + body.len());
+    bytes.extend_from_slice(CONSTRAINT_PROGRAM_MAGIC);
+    bytes.extend_from_slice(&vars.len().to_le_bytes());
+    bytes.extend_from_slice(&felts.len().to_le_bytes());
+    bytes.extend_from_slice(&exts.len().to_le_bytes());
+    bytes.extend_from_slice(&(constraints.len() as u32).to_le_bytes());
+    bytes.extend_from_slice(&body);
+    bytes
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_decimal_to_words() {
+        assert_eq!(decimal_to_words("0"), [0; BN254_WORDS]);
+        assert_eq!(decimal_to_words("4294967296"), [0, 1, 0, 0, 0, 0, 0, 0]);
+        assert_eq!(
+            decimal_to_words(
+                "21888242871839275222246405745257275088548364400416034343698204186575808495616"
+            ),
+            [
+                0xf0000000, 0x43e1f593, 0x79b97091, 0x2833e848, 0x8181585d, 0xb85045b6, 0xe131a029,
+                0x30644e72
+            ]
+        );
+    }
+
+    #[test]
+    fn test_encode_constraints() {
+        let constraints = vec![
+            Constraint {
+                opcode: ConstraintOpcode::ImmF,
+                args: vec![vec!["felt0".to_string()], vec!["7".to_string()]],
+            },
+            Constraint {
+                opcode: ConstraintOpcode::AddF,
+                args: vec![
+                    vec!["felt1".to_string()],
+                    vec!["felt0".to_string()],
+                    vec!["felt0".to_string()],
+                ],
+            },
+        ];
+        let bytes = encode_constraints(&constraints);
+        let words = |start: usize, n: usize| {
+            bytes[start..start + 4 * n]
+                .chunks_exact(4)
+                .map(|b| u32::from_le_bytes(b.try_into().unwrap()))
+                .collect::<Vec<_>>()
+        };
+        assert_eq!(&bytes[0..4], CONSTRAINT_PROGRAM_MAGIC);
+        assert_eq!(words(4, 4), vec![0, 2, 0, 2]);
+        assert_eq!(bytes[20], ConstraintOpcode::ImmF as u8);
+        assert_eq!(bytes[21], 2);
+        assert_eq!(words(22, 4), vec![1, 0, 1, 7]);
+        assert_eq!(bytes[38], ConstraintOpcode::AddF as u8);
+        assert_eq!(words(40, 6), vec![1, 1, 1, 0, 1, 0]);
+    }
+}
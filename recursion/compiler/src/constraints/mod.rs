@@ -1,3 +1,4 @@
+pub mod binary;
 pub mod opcodes;
 
 use core::fmt::Debug;
@@ -7,6 +8,7 @@ use p3_field::PrimeField;
 use serde::{Deserialize, Serialize};
 use std::marker::PhantomData;
 
+use self::binary::encode_constraints;
 use self::opcodes::ConstraintOpcode;
 use crate::ir::Config;
 use crate::ir::DslIr;
@@ -77,6 +79,11 @@ impl<C: Config + Debug> ConstraintCompiler<C> {
         tmp_id
     }
 
+    /// Emit the constraints from a list of operations in the DSL as a binary constraint program.
+    pub fn emit_binary(&mut self, operations: TracedVec<DslIr<C>>) -> Vec<u8> {
+        encode_constraints(&self.emit(operations))
+    }
+
     /// Emit the constraints from a list of operations in the DSL.
     pub fn emit(&mut self, operations: TracedVec<DslIr<C>>) -> Vec<Constraint> {
         let mut constraints: Vec<Constraint> = Vec::new();
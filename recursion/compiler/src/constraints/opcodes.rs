@@ -1,7 +1,11 @@
 use serde::{Deserialize, Serialize};
 
 /// Operations that can be constrained inside the circuit.
-#[derive(Debug, Clone, Serialize, Deserialize)]
+///
+/// The discriminants are used as opcodes by the binary constraint program format, so variants must
+/// only ever be appended.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Serialize, Deserialize)]
+#[repr(u8)]
 pub enum ConstraintOpcode {
     ImmV,
     ImmF,
@@ -1,5 +1,6 @@
 mod instruction;
 mod opcode;
+mod paged;
 mod program;
 mod record;
 mod utils;
@@ -16,6 +17,7 @@ use p3_poseidon2::Poseidon2;
 use p3_poseidon2::Poseidon2ExternalMatrixGeneral;
 use p3_symmetric::CryptographicPermutation;
 use p3_symmetric::Permutation;
+pub use paged::*;
 pub use program::*;
 pub use record::*;
 pub use utils::*;
@@ -58,7 +60,7 @@ pub struct CpuRecord<F> {
     pub memory: Option<MemoryRecord<F>>,
 }
 
-#[derive(Debug, Clone, Default)]
+#[derive(Debug, Clone, Copy, Default)]
 pub struct MemoryEntry<F> {
     pub value: Block<F>,
     pub timestamp: F,
@@ -99,16 +101,15 @@ pub struct Runtime<F: PrimeField32, EF: ExtensionField<F>, Diffusion> {
     /// The program counter.
     pub pc: F,
 
-    /// The program.
-    pub program: RecursionProgram<F>,
+    /// The program, shared with the execution record.
+    pub program: Arc<RecursionProgram<F>>,
 
     /// Memory.
-    // pub memory: Vec<MemoryEntry<F>>,
-    pub memory: HashMap<usize, MemoryEntry<F>>,
+    pub memory: PagedMemory<MemoryEntry<F>>,
 
     /// Uninitialized memory addresses that have a specific value they should be initialized with.
     /// The Opcodes that start with Hint* utilize this to set memory values.
-    pub uninitialized_memory: HashMap<usize, Block<F>>,
+    pub uninitialized_memory: PagedMemory<Block<F>>,
 
     /// The execution record.
     pub record: ExecutionRecord<F>,
@@ -154,10 +155,8 @@ where
             POSEIDON2_SBOX_DEGREE,
         >,
     ) -> Self {
-        let record = ExecutionRecord::<F> {
-            program: Arc::new(program.clone()),
-            ..Default::default()
-        };
+        let program = Arc::new(program.clone());
+        let record = ExecutionRecord::new(program.clone());
         Self {
             timestamp: 0,
             nb_poseidons: 0,
@@ -169,11 +168,11 @@ where
             nb_print_f: 0,
             nb_print_e: 0,
             clk: F::zero(),
-            program: program.clone(),
+            program,
             fp: F::from_canonical_usize(STACK_SIZE),
             pc: F::zero(),
-            memory: HashMap::new(),
-            uninitialized_memory: HashMap::new(),
+            memory: PagedMemory::new(),
+            uninitialized_memory: PagedMemory::new(),
             record,
             perm: Some(perm),
             access: CpuRecord::default(),
@@ -184,10 +183,8 @@ where
     }
 
     pub fn new_no_perm(program: &RecursionProgram<F>) -> Self {
-        let record = ExecutionRecord::<F> {
-            program: Arc::new(program.clone()),
-            ..Default::default()
-        };
+        let program = Arc::new(program.clone());
+        let record = ExecutionRecord::new(program.clone());
         Self {
             timestamp: 0,
             nb_poseidons: 0,
@@ -199,11 +196,11 @@ where
             nb_print_e: 0,
             nb_branch_ops: 0,
             clk: F::zero(),
-            program: program.clone(),
+            program,
             fp: F::from_canonical_usize(STACK_SIZE),
             pc: F::zero(),
-            memory: HashMap::new(),
-            uninitialized_memory: HashMap::new(),
+            memory: PagedMemory::new(),
+            uninitialized_memory: PagedMemory::new(),
             record,
             perm: None,
             access: CpuRecord::default(),
@@ -230,7 +227,7 @@ where
         (
             addr,
             self.memory
-                .get(&(addr.as_canonical_u32() as usize))
+                .get(addr.as_canonical_u32() as usize)
                 .unwrap()
                 .value,
         )
@@ -239,18 +236,18 @@ where
     // Write to uninitialized memory.
     fn mw_uninitialized(&mut self, addr: usize, value: Block<F>) {
         // Write it to uninitialized memory for creating MemoryInit table later.
-        self.uninitialized_memory
-            .entry(addr)
-            .and_modify(|_| panic!("address already initialized"))
-            .or_insert(value);
+        if self.uninitialized_memory.contains(addr) || self.memory.contains(addr) {
+            panic!("address already initialized");
+        }
+        self.uninitialized_memory.insert(addr, value);
         // Also write it to the memory map so that it can be read later.
-        self.memory
-            .entry(addr)
-            .and_modify(|_| panic!("address already initialized"))
-            .or_insert(MemoryEntry {
+        self.memory.insert(
+            addr,
+            MemoryEntry {
                 value,
                 timestamp: F::zero(),
-            });
+            },
+        );
     }
 
     /// Given a MemoryRecord event, track the range checks for the memory access.
@@ -269,10 +266,7 @@ where
     }
 
     fn mr(&mut self, addr: F, timestamp: F) -> (MemoryRecord<F>, Block<F>) {
-        let entry = self
-            .memory
-            .entry(addr.as_canonical_u32() as usize)
-            .or_default();
+        let entry = self.memory.get_or_default(addr.as_canonical_u32() as usize);
         let (prev_value, prev_timestamp) = (entry.value, entry.timestamp);
         let record = MemoryRecord::new_read(addr, prev_value, timestamp, prev_timestamp);
         *entry = MemoryEntry {
@@ -297,7 +291,7 @@ where
 
     fn mw(&mut self, addr: F, value: impl Into<Block<F>>, timestamp: F) -> MemoryRecord<F> {
         let addr_usize = addr.as_canonical_u32() as usize;
-        let entry = self.memory.entry(addr_usize).or_default();
+        let entry = self.memory.get_or_default(addr_usize);
         let (prev_value, prev_timestamp) = (entry.value, entry.timestamp);
         let value_as_block = value.into();
         let record =
@@ -337,7 +331,7 @@ where
         (
             addr,
             self.memory
-                .get(&(addr.as_canonical_u32() as usize))
+                .get(addr.as_canonical_u32() as usize)
                 .map(|entry| entry.value)
                 .unwrap_or_default(),
         )
@@ -407,9 +401,12 @@ where
     pub fn run(&mut self) {
         let early_exit_ts = std::env::var("RECURSION_EARLY_EXIT_TS")
             .map_or(usize::MAX, |ts: String| ts.parse().unwrap());
-        while self.pc < F::from_canonical_u32(self.program.instructions.len() as u32) {
+        // Hold the program apart from `self`, so that the instructions are borrowed instead of
+        // cloned every cycle.
+        let program = self.program.clone();
+        while self.pc < F::from_canonical_u32(program.instructions.len() as u32) {
             let idx = self.pc.as_canonical_u32() as usize;
-            let instruction = self.program.instructions[idx].clone();
+            let instruction = &program.instructions[idx];
 
             let mut next_clk = self.clk + F::from_canonical_u32(4);
             let mut next_pc = self.pc + F::one();
@@ -417,18 +414,18 @@ where
             match instruction.opcode {
                 Opcode::PrintF => {
                     self.nb_print_f += 1;
-                    let (a_val, b_val, c_val) = self.all_rr(&instruction);
+                    let (a_val, b_val, c_val) = self.all_rr(instruction);
                     println!("PRINTF={}, clk={}", a_val[0], self.timestamp);
                     (a, b, c) = (a_val, b_val, c_val);
                 }
                 Opcode::PrintE => {
                     self.nb_print_e += 1;
-                    let (a_val, b_val, c_val) = self.all_rr(&instruction);
+                    let (a_val, b_val, c_val) = self.all_rr(instruction);
                     println!("PRINTEF={:?}", a_val);
                     (a, b, c) = (a_val, b_val, c_val);
                 }
                 Opcode::CycleTracker => {
-                    let (a_val, b_val, c_val) = self.all_rr(&instruction);
+                    let (a_val, b_val, c_val) = self.all_rr(instruction);
                     let name = instruction.debug.clone();
                     let entry = self.cycle_tracker.entry(name).or_default();
                     if !entry.span_entered {
@@ -443,14 +440,14 @@ where
                 }
                 Opcode::ADD => {
                     self.nb_base_ops += 1;
-                    let (a_ptr, b_val, c_val) = self.alu_rr(&instruction);
+                    let (a_ptr, b_val, c_val) = self.alu_rr(instruction);
                     let mut a_val = Block::default();
                     a_val[0] = b_val[0] + c_val[0];
                     self.mw_cpu(a_ptr, a_val, MemoryAccessPosition::A);
 
                     // If the instruction is a heap expansion, we need to add a range check event to
                     // ensure that the heap size never goes above 2^28.
-                    if instruction_is_heap_expand(&instruction) {
+                    if instruction_is_heap_expand(instruction) {
                         let (u16_range_check, u12_range_check) =
                             get_heap_size_range_check_events(a_val[0]);
                         self.record
@@ -460,7 +457,7 @@ where
                     (a, b, c) = (a_val, b_val, c_val);
                 }
                 Opcode::LessThanF => {
-                    let (a_ptr, b_val, c_val) = self.alu_rr(&instruction);
+                    let (a_ptr, b_val, c_val) = self.alu_rr(instruction);
                     let mut a_val = Block::default();
                     a_val[0] = F::from_bool(b_val[0] < c_val[0]);
                     self.mw_cpu(a_ptr, a_val, MemoryAccessPosition::A);
@@ -468,7 +465,7 @@ where
                 }
                 Opcode::SUB => {
                     self.nb_base_ops += 1;
-                    let (a_ptr, b_val, c_val) = self.alu_rr(&instruction);
+                    let (a_ptr, b_val, c_val) = self.alu_rr(instruction);
                     let mut a_val = Block::default();
                     a_val[0] = b_val[0] - c_val[0];
                     self.mw_cpu(a_ptr, a_val, MemoryAccessPosition::A);
@@ -476,7 +473,7 @@ where
                 }
                 Opcode::MUL => {
                     self.nb_base_ops += 1;
-                    let (a_ptr, b_val, c_val) = self.alu_rr(&instruction);
+                    let (a_ptr, b_val, c_val) = self.alu_rr(instruction);
                     let mut a_val = Block::default();
                     a_val[0] = b_val[0] * c_val[0];
                     self.mw_cpu(a_ptr, a_val, MemoryAccessPosition::A);
@@ -484,7 +481,7 @@ where
                 }
                 Opcode::DIV => {
                     self.nb_base_ops += 1;
-                    let (a_ptr, b_val, c_val) = self.alu_rr(&instruction);
+                    let (a_ptr, b_val, c_val) = self.alu_rr(instruction);
                     let mut a_val: Block<F> = Block::default();
                     a_val[0] = b_val[0] / c_val[0];
                     self.mw_cpu(a_ptr, a_val, MemoryAccessPosition::A);
@@ -492,7 +489,7 @@ where
                 }
                 Opcode::EADD => {
                     self.nb_ext_ops += 1;
-                    let (a_ptr, b_val, c_val) = self.alu_rr(&instruction);
+                    let (a_ptr, b_val, c_val) = self.alu_rr(instruction);
                     let sum = EF::from_base_slice(&b_val.0) + EF::from_base_slice(&c_val.0);
                     let a_val = Block::from(sum.as_base_slice());
                     self.mw_cpu(a_ptr, a_val, MemoryAccessPosition::A);
@@ -500,7 +497,7 @@ where
                 }
                 Opcode::EMUL => {
                     self.nb_ext_ops += 1;
-                    let (a_ptr, b_val, c_val) = self.alu_rr(&instruction);
+                    let (a_ptr, b_val, c_val) = self.alu_rr(instruction);
                     let product = EF::from_base_slice(&b_val.0) * EF::from_base_slice(&c_val.0);
                     let a_val = Block::from(product.as_base_slice());
                     self.mw_cpu(a_ptr, a_val, MemoryAccessPosition::A);
@@ -508,7 +505,7 @@ where
                 }
                 Opcode::ESUB => {
                     self.nb_ext_ops += 1;
-                    let (a_ptr, b_val, c_val) = self.alu_rr(&instruction);
+                    let (a_ptr, b_val, c_val) = self.alu_rr(instruction);
                     let diff = EF::from_base_slice(&b_val.0) - EF::from_base_slice(&c_val.0);
                     let a_val = Block::from(diff.as_base_slice());
                     self.mw_cpu(a_ptr, a_val, MemoryAccessPosition::A);
@@ -516,7 +513,7 @@ where
                 }
                 Opcode::EDIV => {
                     self.nb_ext_ops += 1;
-                    let (a_ptr, b_val, c_val) = self.alu_rr(&instruction);
+                    let (a_ptr, b_val, c_val) = self.alu_rr(instruction);
                     let quotient = EF::from_base_slice(&b_val.0) / EF::from_base_slice(&c_val.0);
                     let a_val = Block::from(quotient.as_base_slice());
                     self.mw_cpu(a_ptr, a_val, MemoryAccessPosition::A);
@@ -524,23 +521,23 @@ where
                 }
                 Opcode::LOAD => {
                     self.nb_memory_ops += 1;
-                    let (a_ptr, b_val, c_val) = self.mem_rr(&instruction);
-                    let addr = Self::calculate_address(b_val, c_val, &instruction);
+                    let (a_ptr, b_val, c_val) = self.mem_rr(instruction);
+                    let addr = Self::calculate_address(b_val, c_val, instruction);
                     let a_val = self.mr_cpu(addr, MemoryAccessPosition::Memory);
                     self.mw_cpu(a_ptr, a_val, MemoryAccessPosition::A);
                     (a, b, c) = (a_val, b_val, c_val);
                 }
                 Opcode::STORE => {
                     self.nb_memory_ops += 1;
-                    let (a_ptr, b_val, c_val) = self.mem_rr(&instruction);
-                    let addr = Self::calculate_address(b_val, c_val, &instruction);
+                    let (a_ptr, b_val, c_val) = self.mem_rr(instruction);
+                    let addr = Self::calculate_address(b_val, c_val, instruction);
                     let a_val = self.mr_cpu(a_ptr, MemoryAccessPosition::A);
                     self.mw_cpu(addr, a_val, MemoryAccessPosition::Memory);
                     (a, b, c) = (a_val, b_val, c_val);
                 }
                 Opcode::BEQ => {
                     self.nb_branch_ops += 1;
-                    let (a_val, b_val, c_offset) = self.branch_rr(&instruction);
+                    let (a_val, b_val, c_offset) = self.branch_rr(instruction);
                     (a, b, c) = (a_val, b_val, Block::from(c_offset));
                     if a == b {
                         next_pc = self.pc + c_offset;
@@ -548,7 +545,7 @@ where
                 }
                 Opcode::BNE => {
                     self.nb_branch_ops += 1;
-                    let (a_val, b_val, c_offset) = self.branch_rr(&instruction);
+                    let (a_val, b_val, c_offset) = self.branch_rr(instruction);
                     (a, b, c) = (a_val, b_val, Block::from(c_offset));
                     if a != b {
                         next_pc = self.pc + c_offset;
@@ -556,8 +553,8 @@ where
                 }
                 Opcode::BNEINC => {
                     self.nb_branch_ops += 1;
-                    let (_, b_val, c_offset) = self.alu_rr(&instruction);
-                    let (a_ptr, mut a_val) = self.peek_a(&instruction);
+                    let (_, b_val, c_offset) = self.alu_rr(instruction);
+                    let (a_ptr, mut a_val) = self.peek_a(instruction);
                     a_val[0] += F::one();
                     if a_val != b_val {
                         next_pc = self.pc + c_offset[0];
@@ -567,7 +564,7 @@ where
                 }
                 Opcode::JAL => {
                     self.nb_branch_ops += 1;
-                    let (a_ptr, b_val, c_offset) = self.alu_rr(&instruction);
+                    let (a_ptr, b_val, c_offset) = self.alu_rr(instruction);
                     let a_val = Block::from(self.pc);
                     self.mw_cpu(a_ptr, a_val, MemoryAccessPosition::A);
                     next_pc = self.pc + b_val[0];
@@ -576,7 +573,7 @@ where
                 }
                 Opcode::JALR => {
                     self.nb_branch_ops += 1;
-                    let (a_ptr, b_val, c_val) = self.alu_rr(&instruction);
+                    let (a_ptr, b_val, c_val) = self.alu_rr(instruction);
                     let a_val = Block::from(self.pc + F::one());
                     self.mw_cpu(a_ptr, a_val, MemoryAccessPosition::A);
                     next_pc = b_val[0];
@@ -616,11 +613,11 @@ where
                     self.record.public_values[RECURSION_PUBLIC_VALUES_COL_MAP.exit_code] =
                         F::zero();
 
-                    let (a_val, b_val, c_val) = self.all_rr(&instruction);
+                    let (a_val, b_val, c_val) = self.all_rr(instruction);
                     (a, b, c) = (a_val, b_val, c_val);
                 }
                 Opcode::HintExt2Felt => {
-                    let (a_val, b_val, c_val) = self.all_rr(&instruction);
+                    let (a_val, b_val, c_val) = self.all_rr(instruction);
                     let dst = a_val[0].as_canonical_u32() as usize;
                     self.mw_uninitialized(dst, Block::from(b_val[0]));
                     self.mw_uninitialized(dst + 1, Block::from(b_val[1]));
@@ -631,7 +628,7 @@ where
                 Opcode::Poseidon2Compress => {
                     self.nb_poseidons += 1;
 
-                    let (a_val, b_val, c_val) = self.all_rr(&instruction);
+                    let (a_val, b_val, c_val) = self.all_rr(instruction);
 
                     // Get the dst array ptr.
                     let dst = a_val[0];
@@ -689,7 +686,7 @@ where
                 }
                 Opcode::HintBits => {
                     self.nb_bit_decompositions += 1;
-                    let (a_val, b_val, c_val) = self.all_rr(&instruction);
+                    let (a_val, b_val, c_val) = self.all_rr(instruction);
 
                     // Get the dst array ptr.
                     let dst = a_val[0].as_canonical_u32() as usize;
@@ -705,14 +702,14 @@ where
                     (a, b, c) = (a_val, b_val, c_val);
                 }
                 Opcode::HintLen => {
-                    let (a_ptr, b_val, c_val) = self.alu_rr(&instruction);
+                    let (a_ptr, b_val, c_val) = self.alu_rr(instruction);
                     let a_val: Block<F> =
                         F::from_canonical_usize(self.witness_stream[0].len()).into();
                     self.mw_cpu(a_ptr, a_val, MemoryAccessPosition::A);
                     (a, b, c) = (a_val, b_val, c_val);
                 }
                 Opcode::Hint => {
-                    let (a_val, b_val, c_val) = self.all_rr(&instruction);
+                    let (a_val, b_val, c_val) = self.all_rr(instruction);
                     let dst = a_val[0].as_canonical_u32() as usize;
                     let blocks = self.witness_stream.pop_front().unwrap();
                     for (i, block) in blocks.into_iter().enumerate() {
@@ -721,7 +718,7 @@ where
                     (a, b, c) = (a_val, b_val, c_val);
                 }
                 Opcode::FRIFold => {
-                    let (a_val, b_val, c_val) = self.all_rr(&instruction);
+                    let (a_val, b_val, c_val) = self.all_rr(instruction);
 
                     // The timestamp for the memory reads for all of these operations will be self.clk
 
@@ -823,7 +820,7 @@ where
                 }
                 Opcode::ExpReverseBitsLen => {
                     // Read the operands.
-                    let (a_val, b_val, c_val) = self.all_rr(&instruction);
+                    let (a_val, b_val, c_val) = self.all_rr(instruction);
 
                     // A pointer to the base of the exponentiation.
                     let base = a_val[0];
@@ -891,7 +888,7 @@ where
                 }
                 // For both the Commit and RegisterPublicValue opcodes, we record the public value
                 Opcode::Commit | Opcode::RegisterPublicValue => {
-                    let (a_val, b_val, c_val) = self.all_rr(&instruction);
+                    let (a_val, b_val, c_val) = self.all_rr(instruction);
                     self.record.public_values.push(a_val[0]);
 
                     (a, b, c) = (a_val, b_val, c_val);
@@ -927,16 +924,19 @@ where
 
         let zero_block = Block::from(F::zero());
         // Collect all used memory addresses.
+        let num_addrs = self.memory.len();
+        self.record.first_memory_record.reserve(num_addrs);
+        self.record.last_memory_record.reserve(num_addrs);
         for (addr, entry) in self.memory.iter() {
             // Get the initial value of the memory address from either the uninitialized memory
             // or set it as a default to 0.
             let init_value = self.uninitialized_memory.get(addr).unwrap_or(&zero_block);
             self.record
                 .first_memory_record
-                .push((F::from_canonical_usize(*addr), *init_value));
+                .push((F::from_canonical_usize(addr), *init_value));
 
             self.record.last_memory_record.push((
-                F::from_canonical_usize(*addr),
+                F::from_canonical_usize(addr),
                 entry.timestamp,
                 entry.value,
             ))
@@ -989,6 +989,7 @@ mod tests {
                     "".to_string(),
                 ),
             ],
+            ..Default::default()
         };
         let machine = A::machine(SC::default());
         let mut runtime = Runtime::<F, EF, _>::new(&program, machine.config().perm.clone());
@@ -0,0 +1,62 @@
+use sp1_core::runtime::PageLayout;
+
+use super::MEMORY_SIZE;
+
+/// The layout of the recursion memory.
+///
+/// Recursion programs address the range below [MEMORY_SIZE] densely, with the stack growing down
+/// from its top and the heap growing up after it, so every address is its own slot and the page
+/// table covers the whole range from the start.
+#[derive(Debug, Clone, Copy, Default)]
+pub struct RecursionPageLayout;
+
+impl PageLayout for RecursionPageLayout {
+    type Addr = usize;
+
+    const LOG_PAGE_LEN: usize = 12;
+
+    const INITIAL_PAGES: usize = MEMORY_SIZE >> Self::LOG_PAGE_LEN;
+
+    #[inline]
+    fn compress(addr: usize) -> usize {
+        addr
+    }
+
+    #[inline]
+    fn decompress(index: usize) -> usize {
+        index
+    }
+}
+
+/// Memory stored in lazily allocated pages, so that an access indexes the page table and its page
+/// instead of hashing the address.
+pub type PagedMemory<V> = sp1_core::runtime::PagedMemory<V, RecursionPageLayout>;
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_paged_memory() {
+        let mut memory = PagedMemory::<u32>::new();
+        let addrs = [0, 1, 4095, 4096, 1 << 24, (1 << 24) + 4, MEMORY_SIZE - 1];
+        for (i, addr) in addrs.iter().enumerate() {
+            memory.insert(*addr, i as u32 + 1);
+        }
+        assert_eq!(memory.len(), addrs.len());
+        for (i, addr) in addrs.iter().enumerate() {
+            assert_eq!(memory.get(*addr), Some(&(i as u32 + 1)));
+        }
+        assert!(!memory.contains(2));
+        assert_eq!(*memory.get_or_default(2), 0);
+        assert!(memory.contains(2));
+
+        let mut expected = addrs.to_vec();
+        expected.push(2);
+        expected.sort();
+        assert_eq!(
+            memory.iter().map(|(addr, _)| addr).collect::<Vec<_>>(),
+            expected
+        );
+    }
+}
@@ -1,4 +1,6 @@
-use super::Instruction;
+use std::sync::Arc;
+
+use super::{Instruction, RecordPool};
 use backtrace::Backtrace;
 use p3_field::Field;
 use serde::{Deserialize, Serialize};
@@ -9,6 +11,9 @@ pub struct RecursionProgram<F> {
     pub instructions: Vec<Instruction<F>>,
     #[serde(skip)]
     pub traces: Vec<Option<Backtrace>>,
+    /// The event buffers of the records of earlier runs, shared by the clones of the program.
+    #[serde(skip)]
+    pub record_pool: Arc<RecordPool<F>>,
 }
 
 impl<F: Field> MachineProgram<F> for RecursionProgram<F> {
@@ -1,6 +1,8 @@
 use std::array;
-use std::collections::BTreeMap;
-use std::sync::Arc;
+use std::collections::{BTreeMap, VecDeque};
+use std::fmt;
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::sync::{Arc, Mutex, MutexGuard};
 
 use p3_field::{AbstractField, PrimeField32};
 use sp1_core::stark::{MachineRecord, PROOF_MAX_NUM_PVS};
@@ -33,6 +35,23 @@ pub struct ExecutionRecord<F: Default> {
 }
 
 impl<F: Default> ExecutionRecord<F> {
+    /// Creates an empty record for the program, reusing the event buffers of a dropped record of
+    /// the same program if there is one in its [RecordPool].
+    pub fn new(program: Arc<RecursionProgram<F>>) -> Self {
+        let buffers = program.record_pool.take().unwrap_or_default();
+        Self {
+            program,
+            cpu_events: buffers.cpu_events,
+            poseidon2_events: buffers.poseidon2_events,
+            fri_fold_events: buffers.fri_fold_events,
+            range_check_events: BTreeMap::new(),
+            exp_reverse_bits_len_events: buffers.exp_reverse_bits_len_events,
+            first_memory_record: buffers.first_memory_record,
+            last_memory_record: buffers.last_memory_record,
+            public_values: Vec::new(),
+        }
+    }
+
     pub fn add_range_check_events(&mut self, events: &[RangeCheckEvent]) {
         for event in events {
             *self.range_check_events.entry(*event).or_insert(0) += 1;
@@ -40,6 +59,175 @@ impl<F: Default> ExecutionRecord<F> {
     }
 }
 
+/// Hands the event buffers back to the pool of the program, so that the next record of the program
+/// starts with their capacity.
+impl<F: Default> Drop for ExecutionRecord<F> {
+    fn drop(&mut self) {
+        self.program.record_pool.put(EventBuffers {
+            cpu_events: std::mem::take(&mut self.cpu_events),
+            poseidon2_events: std::mem::take(&mut self.poseidon2_events),
+            fri_fold_events: std::mem::take(&mut self.fri_fold_events),
+            exp_reverse_bits_len_events: std::mem::take(&mut self.exp_reverse_bits_len_events),
+            first_memory_record: std::mem::take(&mut self.first_memory_record),
+            last_memory_record: std::mem::take(&mut self.last_memory_record),
+        });
+    }
+}
+
+/// The bytes of event buffers all the [RecordPool]s of the process keep at most together.
+const MAX_POOLED_BYTES: usize = 1 << 30;
+
+/// The number of recent records of a program whose event bytes are tracked by its [RecordPool].
+const NUM_RECENT_RECORDS: usize = 16;
+
+/// The factor over the median event bytes of the recent records above which the buffers of a
+/// record are released instead of pooled.
+const MAX_OUTSIZED_FACTOR: usize = 4;
+
+/// The bytes of the event buffers kept by all the [RecordPool]s.
+static POOLED_BYTES: AtomicUsize = AtomicUsize::new(0);
+
+/// The event buffers of an [ExecutionRecord].
+struct EventBuffers<F> {
+    cpu_events: Vec<CpuEvent<F>>,
+    poseidon2_events: Vec<Poseidon2Event<F>>,
+    fri_fold_events: Vec<FriFoldEvent<F>>,
+    exp_reverse_bits_len_events: Vec<ExpReverseBitsLenEvent<F>>,
+    first_memory_record: Vec<(F, Block<F>)>,
+    last_memory_record: Vec<(F, F, Block<F>)>,
+}
+
+impl<F> EventBuffers<F> {
+    /// The bytes of the events in the buffers.
+    fn len_bytes(&self) -> usize {
+        self.bytes(|len, _| len)
+    }
+
+    /// The bytes allocated by the buffers.
+    fn capacity_bytes(&self) -> usize {
+        self.bytes(|_, capacity| capacity)
+    }
+
+    fn bytes(&self, count: impl Fn(usize, usize) -> usize) -> usize {
+        fn vec_bytes<T>(v: &Vec<T>, count: &impl Fn(usize, usize) -> usize) -> usize {
+            count(v.len(), v.capacity()) * std::mem::size_of::<T>()
+        }
+        vec_bytes(&self.cpu_events, &count)
+            + vec_bytes(&self.poseidon2_events, &count)
+            + vec_bytes(&self.fri_fold_events, &count)
+            + vec_bytes(&self.exp_reverse_bits_len_events, &count)
+            + vec_bytes(&self.first_memory_record, &count)
+            + vec_bytes(&self.last_memory_record, &count)
+    }
+
+    fn clear(&mut self) {
+        self.cpu_events.clear();
+        self.poseidon2_events.clear();
+        self.fri_fold_events.clear();
+        self.exp_reverse_bits_len_events.clear();
+        self.first_memory_record.clear();
+        self.last_memory_record.clear();
+    }
+}
+
+impl<F> Default for EventBuffers<F> {
+    fn default() -> Self {
+        Self {
+            cpu_events: Vec::new(),
+            poseidon2_events: Vec::new(),
+            fri_fold_events: Vec::new(),
+            exp_reverse_bits_len_events: Vec::new(),
+            first_memory_record: Vec::new(),
+            last_memory_record: Vec::new(),
+        }
+    }
+}
+
+/// Cleared event buffers of the dropped records of a program.
+///
+/// A program is usually executed many times with inputs of the same shape, so its records need
+/// about the same capacity every time. Reusing the buffers saves growing them from empty on
+/// every run. The buffers of a record are released instead of pooled if they are more than
+/// [MAX_OUTSIZED_FACTOR] times the median size of the recent records of the program, or if they
+/// would take the pools of the process over [MAX_POOLED_BYTES].
+pub struct RecordPool<F> {
+    inner: Mutex<RecordPoolInner<F>>,
+}
+
+struct RecordPoolInner<F> {
+    buffers: Vec<EventBuffers<F>>,
+    /// The event bytes of the recent records of the program, oldest first.
+    recent_bytes: VecDeque<usize>,
+}
+
+impl<F> RecordPool<F> {
+    fn lock(&self) -> MutexGuard<'_, RecordPoolInner<F>> {
+        self.inner.lock().unwrap_or_else(|e| e.into_inner())
+    }
+
+    fn take(&self) -> Option<EventBuffers<F>> {
+        let buffers = self.lock().buffers.pop()?;
+        POOLED_BYTES.fetch_sub(buffers.capacity_bytes(), Ordering::Relaxed);
+        Some(buffers)
+    }
+
+    fn put(&self, mut buffers: EventBuffers<F>) {
+        // Records whose events were appended to another record are released without counting
+        // toward the median.
+        let len = buffers.len_bytes();
+        if len == 0 {
+            return;
+        }
+        let capacity = buffers.capacity_bytes();
+        buffers.clear();
+
+        let mut pool = self.lock();
+        if pool.recent_bytes.len() == NUM_RECENT_RECORDS {
+            pool.recent_bytes.pop_front();
+        }
+        pool.recent_bytes.push_back(len);
+        let mut recent = pool.recent_bytes.iter().copied().collect::<Vec<_>>();
+        recent.sort_unstable();
+        let median = recent[recent.len() / 2];
+        if capacity > MAX_OUTSIZED_FACTOR * median {
+            return;
+        }
+
+        let reserved = POOLED_BYTES.fetch_update(Ordering::Relaxed, Ordering::Relaxed, |pooled| {
+            (pooled + capacity <= MAX_POOLED_BYTES).then_some(pooled + capacity)
+        });
+        if reserved.is_ok() {
+            pool.buffers.push(buffers);
+        }
+    }
+}
+
+impl<F> Default for RecordPool<F> {
+    fn default() -> Self {
+        Self {
+            inner: Mutex::new(RecordPoolInner {
+                buffers: Vec::new(),
+                recent_bytes: VecDeque::new(),
+            }),
+        }
+    }
+}
+
+/// Releases the pooled bytes of the pool from the limit of the process.
+impl<F> Drop for RecordPool<F> {
+    fn drop(&mut self) {
+        let pool = self.lock();
+        let bytes = pool.buffers.iter().map(EventBuffers::capacity_bytes).sum();
+        POOLED_BYTES.fetch_sub(bytes, Ordering::Relaxed);
+    }
+}
+
+impl<F> fmt::Debug for RecordPool<F> {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        f.debug_struct("RecordPool").finish_non_exhaustive()
+    }
+}
+
 impl<F: PrimeField32> MachineRecord for ExecutionRecord<F> {
     type Config = ();
 
@@ -99,3 +287,36 @@ impl<F: PrimeField32> MachineRecord for ExecutionRecord<F> {
         ret.to_vec()
     }
 }
+
+#[cfg(test)]
+mod tests {
+    use p3_baby_bear::BabyBear;
+
+    use super::*;
+
+    fn buffers(len: usize, capacity: usize) -> EventBuffers<BabyBear> {
+        let mut buffers = EventBuffers::default();
+        buffers.first_memory_record.reserve_exact(capacity);
+        buffers
+            .first_memory_record
+            .resize(len, (BabyBear::zero(), Block::default()));
+        buffers
+    }
+
+    #[test]
+    fn test_record_pool_releases_outsized_buffers() {
+        let pool = RecordPool::default();
+        pool.put(buffers(100, 128));
+        let reused = pool.take().unwrap();
+        assert!(reused.first_memory_record.is_empty());
+        assert!(reused.first_memory_record.capacity() >= 128);
+        assert!(pool.take().is_none());
+
+        for _ in 0..4 {
+            pool.put(buffers(100, 128));
+        }
+        assert_eq!(pool.lock().buffers.len(), 4);
+        pool.put(buffers(100, 1000));
+        assert_eq!(pool.lock().buffers.len(), 4);
+    }
+}
@@ -1,8 +1,11 @@
 //! A simple CLI that wraps the gnark-ffi crate. This is called using Docker in gnark-ffi when the
-//! native feature is disabled.
+//! native feature is disabled, either once per command or as a long-lived `serve` container that
+//! keeps the PLONK circuit artifacts loaded.
 
 use sp1_recursion_gnark_ffi::ffi::{
-    build_plonk_bn254, prove_plonk_bn254, test_plonk_bn254, verify_plonk_bn254,
+    build_groth16_bn254, build_plonk_bn254, prove_groth16_bn254, serve_plonk_bn254,
+    test_plonk_bn254, verify_groth16_bn254, verify_plonk_bn254, PlonkBn254ProverSession,
+    VerifyMode,
 };
 
 use clap::{Args, Parser, Subcommand};
@@ -24,6 +27,10 @@ enum Command {
     ProvePlonk(ProveArgs),
     VerifyPlonk(VerifyArgs),
     TestPlonk(TestArgs),
+    BuildGroth16(BuildArgs),
+    ProveGroth16(ProveArgs),
+    VerifyGroth16(VerifyArgs),
+    Serve(ServeArgs),
 }
 
 #[derive(Debug, Args)]
@@ -33,6 +40,12 @@ struct BuildArgs {
 
 #[derive(Debug, Args)]
 struct ProveArgs {
+    /// Whether the witness is in the binary layout instead of JSON.
+    #[arg(long)]
+    binary: bool,
+    /// Whether to skip verifying the proof against the verifying key before writing it.
+    #[arg(long)]
+    skip_verify: bool,
     data_dir: String,
     witness_path: String,
     output_path: String,
@@ -47,6 +60,13 @@ struct VerifyArgs {
     output_path: String,
 }
 
+#[derive(Debug, Args)]
+struct ServeArgs {
+    data_dir: String,
+    /// The address to listen on for requests from the docker backend.
+    addr: String,
+}
+
 #[derive(Debug, Args)]
 struct TestArgs {
     witness_json: String,
@@ -58,7 +78,18 @@ fn run_build(args: BuildArgs) {
 }
 
 fn run_prove(args: ProveArgs) {
-    let proof = prove_plonk_bn254(&args.data_dir, &args.witness_path);
+    let verify_mode = if args.skip_verify {
+        VerifyMode::Off
+    } else {
+        VerifyMode::Sync
+    };
+    let session = PlonkBn254ProverSession::open(&args.data_dir);
+    let (proof, _) = if args.binary {
+        let witness = std::fs::read(&args.witness_path).unwrap();
+        session.prove_binary(&witness, verify_mode)
+    } else {
+        session.prove(&args.witness_path, verify_mode)
+    };
     let mut file = File::create(&args.output_path).unwrap();
     bincode::serialize_into(&mut file, &proof).unwrap();
 }
@@ -81,10 +112,46 @@ fn run_verify(args: VerifyArgs) {
     file.write_all(output.as_bytes()).unwrap();
 }
 
+fn run_build_groth16(args: BuildArgs) {
+    build_groth16_bn254(&args.data_dir);
+}
+
+fn run_prove_groth16(args: ProveArgs) {
+    assert!(
+        !args.binary,
+        "binary witnesses are only supported for plonk"
+    );
+    let proof = prove_groth16_bn254(&args.data_dir, &args.witness_path, false);
+    let mut file = File::create(&args.output_path).unwrap();
+    bincode::serialize_into(&mut file, &proof).unwrap();
+}
+
+fn run_verify_groth16(args: VerifyArgs) {
+    // For proof, we read the string from file since it can be large.
+    let file = File::open(&args.proof_path).unwrap();
+    let proof = read_to_string(file).unwrap();
+    let result = verify_groth16_bn254(
+        &args.data_dir,
+        proof.trim(),
+        &args.vkey_hash,
+        &args.committed_values_digest,
+    );
+    let output = match result {
+        Ok(_) => "OK".to_string(),
+        Err(e) => e,
+    };
+    let mut file = File::create(&args.output_path).unwrap();
+    file.write_all(output.as_bytes()).unwrap();
+}
+
 fn run_test(args: TestArgs) {
     test_plonk_bn254(&args.witness_json, &args.constraints_json);
 }
 
+fn run_serve(args: ServeArgs) {
+    serve_plonk_bn254(&args.data_dir, &args.addr);
+}
+
 fn main() {
     let cli = Cli::parse();
 
@@ -93,5 +160,9 @@ fn main() {
         Command::ProvePlonk(args) => run_prove(args),
         Command::VerifyPlonk(args) => run_verify(args),
         Command::TestPlonk(args) => run_test(args),
+        Command::BuildGroth16(args) => run_build_groth16(args),
+        Command::ProveGroth16(args) => run_prove_groth16(args),
+        Command::VerifyGroth16(args) => run_verify_groth16(args),
+        Command::Serve(args) => run_serve(args),
     }
 }
@@ -21,12 +21,19 @@ fn main() {
 
             println!("Building Go library at {}", dest.display());
 
+            // Enable the ICICLE GPU backend if requested.
+            let mut tags = Vec::new();
+            if cfg!(feature = "gpu") {
+                tags.push("-tags=icicle");
+            }
+
             // Run the go build command
             let status = Command::new("go")
                 .current_dir("go")
                 .env("CGO_ENABLED", "1")
+                .arg("build")
+                .args(tags)
                 .args([
-                    "build",
                     "-o",
                     dest.to_str().unwrap(),
                     "-buildmode=c-archive",
@@ -61,6 +68,16 @@ fn main() {
             println!("cargo:rustc-link-search=native={}", dest_path.display());
             println!("cargo:rustc-link-lib=static={}", lib_name);
 
+            // Link the ICICLE and CUDA runtime libraries used by the GPU backend.
+            if cfg!(feature = "gpu") {
+                println!("cargo:rerun-if-env-changed=ICICLE_LIB_DIR");
+                if let Ok(icicle_lib_dir) = env::var("ICICLE_LIB_DIR") {
+                    println!("cargo:rustc-link-search=native={}", icicle_lib_dir);
+                }
+                println!("cargo:rustc-link-lib=dylib=cudart");
+                println!("cargo:rustc-link-lib=dylib=stdc++");
+            }
+
             // Static linking doesn't really work on macos, so we need to link some system libs
             if cfg!(target_os = "macos") {
                 println!("cargo:rustc-link-lib=framework=CoreFoundation");
@@ -1,3 +1,6 @@
+#include <stddef.h>
 #include <stdint.h>
 uint32_t babybearextinv(uint32_t a, uint32_t b, uint32_t c, uint32_t d, uint32_t i);
-uint32_t babybearinv(uint32_t a);
\ No newline at end of file
+uint32_t babybearinv(uint32_t a);
+void babybearextinv_batch(const uint32_t *in, uint32_t *out, size_t n);
+void babybearinv_batch(const uint32_t *in, uint32_t *out, size_t n);
@@ -8,13 +8,21 @@ typedef struct {
 	char *EncodedProof;
 	char *RawProof;
 } C_PlonkBn254Proof;
+
+typedef struct {
+	char *PublicInputs[2];
+	char *EncodedProof;
+	char *RawProof;
+} C_Groth16Bn254Proof;
 */
 import "C"
 import (
 	"encoding/json"
 	"fmt"
 	"os"
+	"runtime/cgo"
 	"sync"
+	"unsafe"
 
 	"github.com/consensys/gnark-crypto/ecc"
 	"github.com/consensys/gnark/backend/groth16"
@@ -37,6 +45,78 @@ func ProvePlonkBn254(dataDir *C.char, witnessPath *C.char) *C.C_PlonkBn254Proof
 
 	sp1PlonkBn254Proof := sp1.Prove(dataDirString, witnessPathString)
 
+	return newCPlonkBn254Proof(sp1PlonkBn254Proof)
+}
+
+// GnarkMetrics returns the metrics of the gnark prover in the Prometheus text format. The string
+// must be freed by the caller.
+//
+//export GnarkMetrics
+func GnarkMetrics() *C.char {
+	return C.CString(sp1.RenderMetrics())
+}
+
+//export PlonkBn254ProverOpen
+func PlonkBn254ProverOpen(dataDir *C.char) C.uintptr_t {
+	dataDirString := C.GoString(dataDir)
+
+	prover := sp1.NewProver(dataDirString)
+	return C.uintptr_t(cgo.NewHandle(prover))
+}
+
+// The verifyMode arguments take the values of sp1.VerifyMode. In async mode, a handle to the
+// pending verification is written to verification, which must be passed to
+// PlonkBn254VerificationWait exactly once. Otherwise verification is set to zero.
+
+//export PlonkBn254ProverProve
+func PlonkBn254ProverProve(handle C.uintptr_t, witnessPath *C.char, verifyMode C.int, verification *C.uintptr_t) *C.C_PlonkBn254Proof {
+	witnessPathString := C.GoString(witnessPath)
+
+	prover := cgo.Handle(handle).Value().(*sp1.Prover)
+	sp1PlonkBn254Proof, sp1Verification := prover.Prove(witnessPathString, sp1.VerifyMode(verifyMode))
+	*verification = newVerificationHandle(sp1Verification)
+
+	return newCPlonkBn254Proof(sp1PlonkBn254Proof)
+}
+
+//export PlonkBn254ProverProveBinary
+func PlonkBn254ProverProveBinary(handle C.uintptr_t, witness *C.uint8_t, witnessLen C.size_t, verifyMode C.int, verification *C.uintptr_t) *C.C_PlonkBn254Proof {
+	// The witness buffer is owned by the caller and only borrowed for the duration of the call.
+	witnessBytes := unsafe.Slice((*byte)(unsafe.Pointer(witness)), int(witnessLen))
+
+	prover := cgo.Handle(handle).Value().(*sp1.Prover)
+	sp1PlonkBn254Proof, sp1Verification := prover.ProveBinary(witnessBytes, sp1.VerifyMode(verifyMode))
+	*verification = newVerificationHandle(sp1Verification)
+
+	return newCPlonkBn254Proof(sp1PlonkBn254Proof)
+}
+
+//export PlonkBn254VerificationWait
+func PlonkBn254VerificationWait(verification C.uintptr_t) *C.char {
+	h := cgo.Handle(verification)
+	sp1Verification := h.Value().(*sp1.Verification)
+	h.Delete()
+
+	err := sp1Verification.Wait()
+	if err != nil {
+		return C.CString(err.Error())
+	}
+	return nil
+}
+
+func newVerificationHandle(verification *sp1.Verification) C.uintptr_t {
+	if verification == nil {
+		return 0
+	}
+	return C.uintptr_t(cgo.NewHandle(verification))
+}
+
+//export PlonkBn254ProverClose
+func PlonkBn254ProverClose(handle C.uintptr_t) {
+	cgo.Handle(handle).Delete()
+}
+
+func newCPlonkBn254Proof(sp1PlonkBn254Proof sp1.Proof) *C.C_PlonkBn254Proof {
 	ms := C.malloc(C.sizeof_C_PlonkBn254Proof)
 	if ms == nil {
 		return nil
@@ -72,6 +152,82 @@ func VerifyPlonkBn254(dataDir *C.char, proof *C.char, vkeyHash *C.char, commited
 	return nil
 }
 
+// VerifyPlonkBn254Batch verifies n proofs in parallel with the verifying key kept resident for the
+// data directory. proofs, vkeyHashes and commitedValuesDigests are arrays of n strings, and the
+// error message of each proof is written to the array errs, or nil if the proof verified.
+//
+//export VerifyPlonkBn254Batch
+func VerifyPlonkBn254Batch(dataDir *C.char, proofs **C.char, vkeyHashes **C.char, commitedValuesDigests **C.char, n C.size_t, errs **C.char) {
+	count := int(n)
+	goStrings := func(strs **C.char) []string {
+		goStrs := make([]string, count)
+		for i, str := range unsafe.Slice(strs, count) {
+			goStrs[i] = C.GoString(str)
+		}
+		return goStrs
+	}
+
+	results := sp1.VerifyBatch(C.GoString(dataDir), goStrings(proofs), goStrings(vkeyHashes), goStrings(commitedValuesDigests))
+	errMessages := unsafe.Slice(errs, count)
+	for i, err := range results {
+		if err != nil {
+			errMessages[i] = C.CString(err.Error())
+		} else {
+			errMessages[i] = nil
+		}
+	}
+}
+
+//export ProveGroth16Bn254
+func ProveGroth16Bn254(dataDir *C.char, witnessPath *C.char, useGPU C.int) *C.C_Groth16Bn254Proof {
+	dataDirString := C.GoString(dataDir)
+	witnessPathString := C.GoString(witnessPath)
+
+	sp1Groth16Bn254Proof := sp1.ProveGroth16(dataDirString, witnessPathString, useGPU != 0)
+
+	ms := C.malloc(C.sizeof_C_Groth16Bn254Proof)
+	if ms == nil {
+		return nil
+	}
+
+	structPtr := (*C.C_Groth16Bn254Proof)(ms)
+	structPtr.PublicInputs[0] = C.CString(sp1Groth16Bn254Proof.PublicInputs[0])
+	structPtr.PublicInputs[1] = C.CString(sp1Groth16Bn254Proof.PublicInputs[1])
+	structPtr.EncodedProof = C.CString(sp1Groth16Bn254Proof.EncodedProof)
+	structPtr.RawProof = C.CString(sp1Groth16Bn254Proof.RawProof)
+	return structPtr
+}
+
+//export GnarkGpuEnabled
+func GnarkGpuEnabled() C.int {
+	if sp1.IcicleEnabled {
+		return 1
+	}
+	return 0
+}
+
+//export BuildGroth16Bn254
+func BuildGroth16Bn254(dataDir *C.char) {
+	// Sanity check the required arguments have been provided.
+	dataDirString := C.GoString(dataDir)
+
+	sp1.BuildGroth16(dataDirString)
+}
+
+//export VerifyGroth16Bn254
+func VerifyGroth16Bn254(dataDir *C.char, proof *C.char, vkeyHash *C.char, commitedValuesDigest *C.char) *C.char {
+	dataDirString := C.GoString(dataDir)
+	proofString := C.GoString(proof)
+	vkeyHashString := C.GoString(vkeyHash)
+	commitedValuesDigestString := C.GoString(commitedValuesDigest)
+
+	err := sp1.VerifyGroth16(dataDirString, proofString, vkeyHashString, commitedValuesDigestString)
+	if err != nil {
+		return C.CString(err.Error())
+	}
+	return nil
+}
+
 var testMutex = &sync.Mutex{}
 
 //export TestPlonkBn254
@@ -81,7 +237,12 @@ func TestPlonkBn254(witnessPath *C.char, constraintsJson *C.char) *C.char {
 	witnessPathString := C.GoString(witnessPath)
 	constraintsJsonString := C.GoString(constraintsJson)
 	os.Setenv("WITNESS_JSON", witnessPathString)
-	os.Setenv("CONSTRAINTS_JSON", constraintsJsonString)
+	if sp1.IsConstraintProgram(constraintsJsonString) {
+		os.Setenv("CONSTRAINTS_BIN", constraintsJsonString)
+	} else {
+		os.Unsetenv("CONSTRAINTS_BIN")
+		os.Setenv("CONSTRAINTS_JSON", constraintsJsonString)
+	}
 	err := TestMain()
 	testMutex.Unlock()
 	if err != nil {
@@ -22,6 +22,17 @@ func init() {
 	solver.RegisterHint(ReduceHint)
 }
 
+// MAX_NB_BITS bounds the number of bits of the values held by variables. Values are only reduced
+// when an operation could exceed it, or where a canonical value is needed: before hints, bit
+// decompositions and equality checks.
+//
+// The BN254 scalar field modulus exceeds 2^253. The bound leaves room for the offset difference
+// in AssertIsEqualF, which has up to 252 bits, so that neither a value nor the quotient times the
+// prime in a check wraps around the modulus.
+const MAX_NB_BITS = 250
+
+// Variable is a BabyBear element held as an integer of at most NbBits bits, which is congruent to
+// the element but not necessarily reduced unless NbBits is 31.
 type Variable struct {
 	Value  frontend.Variable
 	NbBits uint
@@ -62,17 +73,13 @@ func Felts2Ext(a, b, c, d Variable) ExtensionVariable {
 	return ExtensionVariable{Value: [4]Variable{a, b, c, d}}
 }
 
+// AddF adds two elements without reducing them, unless the sum could exceed MAX_NB_BITS.
 func (c *Chip) AddF(a, b Variable) Variable {
-	var maxBits uint
-	if a.NbBits > b.NbBits {
-		maxBits = a.NbBits
-	} else {
-		maxBits = b.NbBits
-	}
-	return c.ReduceFast(Variable{
+	a, b = c.fit(a, b, addBits)
+	return Variable{
 		Value:  c.api.Add(a.Value, b.Value),
-		NbBits: maxBits + 1,
-	})
+		NbBits: addBits(a.NbBits, b.NbBits),
+	}
 }
 
 func (c *Chip) SubF(a, b Variable) Variable {
@@ -80,18 +87,25 @@ func (c *Chip) SubF(a, b Variable) Variable {
 	return c.AddF(a, negB)
 }
 
+// MulF multiplies two elements without reducing them, unless the product could exceed
+// MAX_NB_BITS.
 func (c *Chip) MulF(a, b Variable) Variable {
-	return c.ReduceFast(Variable{
+	a, b = c.fit(a, b, mulBits)
+	return Variable{
 		Value:  c.api.Mul(a.Value, b.Value),
-		NbBits: a.NbBits + b.NbBits,
-	})
+		NbBits: mulBits(a.NbBits, b.NbBits),
+	}
 }
 
+// MulFConst multiplies an element by a constant below 16.
 func (c *Chip) MulFConst(a Variable, b int) Variable {
-	return c.ReduceFast(Variable{
+	if a.NbBits+4 > MAX_NB_BITS {
+		a = c.ReduceSlow(a)
+	}
+	return Variable{
 		Value:  c.api.Mul(a.Value, b),
 		NbBits: a.NbBits + 4,
-	})
+	}
 }
 
 func (c *Chip) NegF(a Variable) Variable {
@@ -119,10 +133,27 @@ func (c *Chip) InvF(in Variable) Variable {
 	return xinv
 }
 
+// AssertIsEqualF asserts that two elements are congruent modulo the BabyBear prime. Unless both
+// are reduced already, their difference is checked to be a multiple of the prime, which takes a
+// single quotient and range check instead of reducing each side.
 func (c *Chip) AssertIsEqualF(a, b Variable) {
-	a2 := c.ReduceSlow(a)
-	b2 := c.ReduceSlow(b)
-	c.api.AssertIsEqual(a2.Value, b2.Value)
+	if a.NbBits == 31 && b.NbBits == 31 {
+		c.api.AssertIsEqual(a.Value, b.Value)
+		return
+	}
+
+	// Offset the difference by a multiple of the prime larger than b, so that it is positive.
+	offset := new(big.Int).Lsh(MODULUS, b.NbBits-30)
+	diff := c.api.Sub(c.api.Add(a.Value, offset), b.Value)
+	nbBits := addBits(a.NbBits, b.NbBits+1)
+
+	result, err := c.api.Compiler().NewHint(ReduceHint, 2, diff)
+	if err != nil {
+		panic(err)
+	}
+	quotient := result[0]
+	c.rangeChecker.Check(quotient, int(nbBits-30))
+	c.api.AssertIsEqual(diff, c.api.Mul(quotient, MODULUS))
 }
 
 func (c *Chip) AssertIsEqualE(a, b ExtensionVariable) {
@@ -212,25 +243,39 @@ func (c *Chip) MulEF(a ExtensionVariable, b Variable) ExtensionVariable {
 }
 
 func (c *Chip) InvE(in ExtensionVariable) ExtensionVariable {
-	in.Value[0] = c.ReduceSlow(in.Value[0])
-	in.Value[1] = c.ReduceSlow(in.Value[1])
-	in.Value[2] = c.ReduceSlow(in.Value[2])
-	in.Value[3] = c.ReduceSlow(in.Value[3])
-	result, err := c.api.Compiler().NewHint(InvEHint, 4, in.Value[0].Value, in.Value[1].Value, in.Value[2].Value, in.Value[3].Value)
+	return c.BatchInvE([]ExtensionVariable{in})[0]
+}
+
+// BatchInvE inverts a group of extension elements with a single hint, so that the solver crosses
+// into Rust once and shares one Montgomery batch inversion across the whole group.
+func (c *Chip) BatchInvE(in []ExtensionVariable) []ExtensionVariable {
+	in = append([]ExtensionVariable(nil), in...)
+	inputs := make([]frontend.Variable, 0, 4*len(in))
+	for i := range in {
+		for j := 0; j < 4; j++ {
+			in[i].Value[j] = c.ReduceSlow(in[i].Value[j])
+			inputs = append(inputs, in[i].Value[j].Value)
+		}
+	}
+	result, err := c.api.Compiler().NewHint(InvEHint, len(inputs), inputs...)
 	if err != nil {
 		panic(err)
 	}
 
-	xinv := Variable{Value: result[0], NbBits: 31}
-	yinv := Variable{Value: result[1], NbBits: 31}
-	zinv := Variable{Value: result[2], NbBits: 31}
-	linv := Variable{Value: result[3], NbBits: 31}
-	out := ExtensionVariable{Value: [4]Variable{xinv, yinv, zinv, linv}}
-
-	product := c.MulE(in, out)
-	c.AssertIsEqualE(product, NewE([]string{"1", "0", "0", "0"}))
+	outs := make([]ExtensionVariable, len(in))
+	for i := range in {
+		xinv := Variable{Value: result[4*i], NbBits: 31}
+		yinv := Variable{Value: result[4*i+1], NbBits: 31}
+		zinv := Variable{Value: result[4*i+2], NbBits: 31}
+		linv := Variable{Value: result[4*i+3], NbBits: 31}
+		out := ExtensionVariable{Value: [4]Variable{xinv, yinv, zinv, linv}}
+
+		product := c.MulE(in[i], out)
+		c.AssertIsEqualE(product, NewE([]string{"1", "0", "0", "0"}))
+		outs[i] = out
+	}
 
-	return out
+	return outs
 }
 
 func (c *Chip) Ext2Felt(in ExtensionVariable) [4]Variable {
@@ -254,14 +299,28 @@ func (c *Chip) ToBinary(in Variable) []frontend.Variable {
 	return c.api.ToBinary(c.ReduceSlow(in).Value, 32)
 }
 
-func (p *Chip) ReduceFast(x Variable) Variable {
-	if x.NbBits >= uint(120) {
-		return Variable{
-			Value:  p.ReduceWithMaxBits(x.Value, uint64(x.NbBits)),
-			NbBits: 31,
+// fit reduces the operands of an operation, the one with more bits first, until the number of
+// bits of the result, as given by nbBits, is at most MAX_NB_BITS.
+func (c *Chip) fit(a, b Variable, nbBits func(a, b uint) uint) (Variable, Variable) {
+	for nbBits(a.NbBits, b.NbBits) > MAX_NB_BITS {
+		if a.NbBits >= b.NbBits {
+			a = c.ReduceSlow(a)
+		} else {
+			b = c.ReduceSlow(b)
 		}
 	}
-	return x
+	return a, b
+}
+
+func addBits(a, b uint) uint {
+	if a > b {
+		return a + 1
+	}
+	return b + 1
+}
+
+func mulBits(a, b uint) uint {
+	return a + b
 }
 
 func (p *Chip) ReduceSlow(x Variable) Variable {
@@ -296,33 +355,43 @@ func ReduceHint(_ *big.Int, inputs []*big.Int, results []*big.Int) error {
 	if len(inputs) != 1 {
 		panic("ReduceHint expects 1 input operand")
 	}
-	input := inputs[0]
-	quotient := new(big.Int).Div(input, MODULUS)
-	remainder := new(big.Int).Rem(input, MODULUS)
-	results[0] = quotient
-	results[1] = remainder
+	reduceInto(inputs[0], results[0], results[1])
 	return nil
 }
 
+// The hint used to compute InvF. Accepts any number of inputs and inverts them all natively with
+// one batch inversion.
 func InvFHint(_ *big.Int, inputs []*big.Int, results []*big.Int) error {
-	a := C.uint(inputs[0].Uint64())
-	ainv := C.babybearinv(a)
-	results[0].SetUint64(uint64(ainv))
+	if len(inputs) != len(results) {
+		panic("InvFHint expects as many results as inputs")
+	}
+	in := make([]Element, len(inputs))
+	for i := range inputs {
+		in[i] = NewElement(uint32(inputs[i].Uint64()))
+	}
+	out := BatchInverse(in)
+	for i := range results {
+		results[i].SetUint64(uint64(out[i].Uint32()))
+	}
 	return nil
 }
 
+// The hint used to compute InvE. Inputs are a flattened list of extension elements, four limbs
+// each, which are inverted together with one call into babybearextinv_batch.
 func InvEHint(_ *big.Int, inputs []*big.Int, results []*big.Int) error {
-	a := C.uint(inputs[0].Uint64())
-	b := C.uint(inputs[1].Uint64())
-	c := C.uint(inputs[2].Uint64())
-	d := C.uint(inputs[3].Uint64())
-	ainv := C.babybearextinv(a, b, c, d, 0)
-	binv := C.babybearextinv(a, b, c, d, 1)
-	cinv := C.babybearextinv(a, b, c, d, 2)
-	dinv := C.babybearextinv(a, b, c, d, 3)
-	results[0].SetUint64(uint64(ainv))
-	results[1].SetUint64(uint64(binv))
-	results[2].SetUint64(uint64(cinv))
-	results[3].SetUint64(uint64(dinv))
+	if len(inputs)%4 != 0 || len(inputs) != len(results) {
+		panic("InvEHint expects a multiple of 4 inputs and as many results")
+	}
+	in := make([]C.uint32_t, len(inputs))
+	for i := range inputs {
+		in[i] = C.uint32_t(inputs[i].Uint64())
+	}
+	out := make([]C.uint32_t, len(inputs))
+	if len(in) > 0 {
+		C.babybearextinv_batch(&in[0], &out[0], C.size_t(len(in)/4))
+	}
+	for i := range results {
+		results[i].SetUint64(uint64(out[i]))
+	}
 	return nil
 }
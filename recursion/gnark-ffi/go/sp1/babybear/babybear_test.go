@@ -0,0 +1,84 @@
+package babybear
+
+import (
+	"math/big"
+	"testing"
+
+	"github.com/consensys/gnark-crypto/ecc"
+	"github.com/consensys/gnark/frontend"
+	"github.com/consensys/gnark/frontend/cs/scs"
+	"github.com/consensys/gnark/test"
+)
+
+const lazyChainLength = 40
+
+// TestLazyCircuit evaluates acc = acc * x + y repeatedly, so that the values grow past the bits of
+// a variable and the chip has to reduce them along the way.
+type TestLazyCircuit struct {
+	X, Y, Expected frontend.Variable
+}
+
+func (circuit *TestLazyCircuit) Define(api frontend.API) error {
+	chip := NewChip(api)
+	x := Variable{Value: circuit.X, NbBits: 31}
+	y := Variable{Value: circuit.Y, NbBits: 31}
+	acc := x
+	for i := 0; i < lazyChainLength; i++ {
+		acc = chip.AddF(chip.MulF(acc, x), chip.NegF(y))
+	}
+	chip.AssertIsEqualF(acc, Variable{Value: circuit.Expected, NbBits: 31})
+	chip.ToBinary(acc)
+	return nil
+}
+
+func TestLazyReduction(t *testing.T) {
+	xValue, yValue := uint32(1234567890), uint32(987654321)
+	x, y := NewElement(xValue), NewElement(yValue)
+	acc := x
+	for i := 0; i < lazyChainLength; i++ {
+		acc = acc.Mul(x).Sub(y)
+	}
+
+	var circuit TestLazyCircuit
+	witness := TestLazyCircuit{X: xValue, Y: yValue, Expected: acc.Uint32()}
+	if err := test.IsSolved(&circuit, &witness, ecc.BN254.ScalarField()); err != nil {
+		t.Fatal(err)
+	}
+
+	witness.Expected = acc.Add(NewElement(1)).Uint32()
+	if err := test.IsSolved(&circuit, &witness, ecc.BN254.ScalarField()); err == nil {
+		t.Fatal("circuit accepted a wrong result")
+	}
+}
+
+func BenchmarkLazyCircuitCompile(b *testing.B) {
+	var circuit TestLazyCircuit
+	for i := 0; i < b.N; i++ {
+		if _, err := frontend.Compile(ecc.BN254.ScalarField(), scs.NewBuilder, &circuit); err != nil {
+			b.Fatal(err)
+		}
+	}
+}
+
+func benchmarkInverseHint(b *testing.B, hint func(*big.Int, []*big.Int, []*big.Int) error) {
+	inputs := make([]*big.Int, 1024)
+	results := make([]*big.Int, len(inputs))
+	for i := range inputs {
+		inputs[i] = big.NewInt(int64(i + 1))
+		results[i] = new(big.Int)
+	}
+	b.ResetTimer()
+	for i := 0; i < b.N; i++ {
+		if err := hint(MODULUS, inputs, results); err != nil {
+			b.Fatal(err)
+		}
+	}
+}
+
+func BenchmarkInvFHint(b *testing.B) {
+	benchmarkInverseHint(b, InvFHint)
+}
+
+func BenchmarkInvEHint(b *testing.B) {
+	benchmarkInverseHint(b, InvEHint)
+}
@@ -0,0 +1,134 @@
+package babybear
+
+import (
+	"math/big"
+	"math/bits"
+)
+
+// Native fixed-width BabyBear arithmetic used by the hints, so that the solver does not need to
+// allocate big.Int values or cross into Rust for base field operations.
+
+const (
+	// The BabyBear prime, 15 * 2^27 + 1.
+	P uint32 = 2013265921
+
+	// P^-1 mod 2^32, used for Montgomery reduction.
+	montyMu uint32 = 0x88000001
+
+	// R^2 mod P where R = 2^32, used to convert into Montgomery form.
+	montyR2 uint64 = 1172168163
+)
+
+// Element is a BabyBear field element stored in Montgomery form.
+type Element uint32
+
+// montyReduce computes x * R^-1 mod P for any x < P * 2^32.
+func montyReduce(x uint64) uint32 {
+	t := uint32(x) * montyMu
+	u := uint64(t) * uint64(P)
+	xSubU, borrow := bits.Sub64(x, u, 0)
+	res := uint32(xSubU >> 32)
+	return res + (P & -uint32(borrow))
+}
+
+// NewElement converts a canonical or non-canonical uint32 into Montgomery form.
+func NewElement(v uint32) Element {
+	return Element(montyReduce(uint64(v%P) * montyR2))
+}
+
+// Uint32 returns the canonical representative of e.
+func (e Element) Uint32() uint32 {
+	return montyReduce(uint64(e))
+}
+
+func (e Element) Add(o Element) Element {
+	sum := uint32(e) + uint32(o)
+	corr, borrow := bits.Sub32(sum, P, 0)
+	return Element(corr + (P & -borrow))
+}
+
+func (e Element) Sub(o Element) Element {
+	diff, borrow := bits.Sub32(uint32(e), uint32(o), 0)
+	return Element(diff + (P & -borrow))
+}
+
+func (e Element) Mul(o Element) Element {
+	return Element(montyReduce(uint64(e) * uint64(o)))
+}
+
+// Exp computes e^n. The loop always runs over all 32 bits of the exponent and selects the
+// multiplication with a mask, so its running time does not depend on n.
+func (e Element) Exp(n uint32) Element {
+	acc := NewElement(1)
+	for i := 31; i >= 0; i-- {
+		acc = acc.Mul(acc)
+		prod := acc.Mul(e)
+		mask := -((n >> uint(i)) & 1)
+		acc = Element((uint32(prod) & mask) | (uint32(acc) &^ mask))
+	}
+	return acc
+}
+
+// Inverse computes e^-1 through Fermat's little theorem. The inverse of zero is zero.
+func (e Element) Inverse() Element {
+	return e.Exp(P - 2)
+}
+
+// BatchInverse inverts all elements of in with Montgomery's trick, using a single field
+// inversion. Zero elements are mapped to zero.
+func BatchInverse(in []Element) []Element {
+	out := make([]Element, len(in))
+	if len(in) == 0 {
+		return out
+	}
+	one := NewElement(1)
+	acc := one
+	for i, x := range in {
+		out[i] = acc
+		if x != 0 {
+			acc = acc.Mul(x)
+		}
+	}
+	inv := acc.Inverse()
+	for i := len(in) - 1; i >= 0; i-- {
+		if in[i] == 0 {
+			out[i] = 0
+			continue
+		}
+		out[i] = out[i].Mul(inv)
+		inv = inv.Mul(in[i])
+	}
+	return out
+}
+
+// Reduce64 computes x mod P.
+func Reduce64(x uint64) uint32 {
+	_, rem := bits.Div64(0, x, uint64(P))
+	return uint32(rem)
+}
+
+// Reduce128 computes (hi * 2^64 + lo) mod P.
+func Reduce128(hi, lo uint64) uint32 {
+	_, rem := bits.Div64(hi%uint64(P), lo, uint64(P))
+	return uint32(rem)
+}
+
+// reduceInto writes floor(x / P) into quotient and x mod P into remainder using word-by-word long
+// division, reusing the storage already held by quotient. x must be non-negative.
+func reduceInto(x *big.Int, quotient *big.Int, remainder *big.Int) {
+	words := x.Bits()
+	q := quotient.Bits()
+	if cap(q) < len(words) {
+		q = make([]big.Word, len(words))
+	}
+	q = q[:len(words)]
+
+	var r uint
+	for i := len(words) - 1; i >= 0; i-- {
+		var qi uint
+		qi, r = bits.Div(r, uint(words[i]), uint(P))
+		q[i] = big.Word(qi)
+	}
+	quotient.SetBits(q)
+	remainder.SetUint64(uint64(r))
+}
@@ -0,0 +1,82 @@
+package babybear
+
+import (
+	"math/big"
+	"math/rand"
+	"testing"
+)
+
+func TestElementArithmetic(t *testing.T) {
+	modulus := uint64(P)
+	rng := rand.New(rand.NewSource(0))
+	for i := 0; i < 1000; i++ {
+		a := rng.Uint32()
+		b := rng.Uint32()
+		x := NewElement(a)
+		y := NewElement(b)
+		ar := uint64(a) % modulus
+		br := uint64(b) % modulus
+
+		if got, want := x.Uint32(), uint32(ar); got != want {
+			t.Fatalf("roundtrip(%d) = %d, want %d", a, got, want)
+		}
+		if got, want := x.Add(y).Uint32(), uint32((ar+br)%modulus); got != want {
+			t.Fatalf("%d + %d = %d, want %d", a, b, got, want)
+		}
+		if got, want := x.Sub(y).Uint32(), uint32((ar+modulus-br)%modulus); got != want {
+			t.Fatalf("%d - %d = %d, want %d", a, b, got, want)
+		}
+		if got, want := x.Mul(y).Uint32(), uint32(ar*br%modulus); got != want {
+			t.Fatalf("%d * %d = %d, want %d", a, b, got, want)
+		}
+		if ar != 0 {
+			if got := x.Mul(x.Inverse()).Uint32(); got != 1 {
+				t.Fatalf("%d * %d^-1 = %d, want 1", a, a, got)
+			}
+		}
+	}
+}
+
+func TestBatchInverse(t *testing.T) {
+	in := []Element{NewElement(1), NewElement(0), NewElement(7), NewElement(P - 1), NewElement(123456789)}
+	out := BatchInverse(in)
+	for i := range in {
+		if in[i] == 0 {
+			if out[i] != 0 {
+				t.Fatalf("inverse of zero should be zero")
+			}
+			continue
+		}
+		if out[i] != in[i].Inverse() {
+			t.Fatalf("batch inverse mismatch at %d", i)
+		}
+	}
+}
+
+func TestReduce(t *testing.T) {
+	modulus := new(big.Int).SetUint64(uint64(P))
+	rng := rand.New(rand.NewSource(1))
+	for _, nbBits := range []uint{0, 31, 63, 64, 65, 127, 128, 200, 253} {
+		x := new(big.Int).Rand(rng, new(big.Int).Lsh(big.NewInt(1), nbBits))
+		wantQ, wantR := new(big.Int).QuoRem(x, modulus, new(big.Int))
+
+		q, r := new(big.Int), new(big.Int)
+		reduceInto(x, q, r)
+		if q.Cmp(wantQ) != 0 || r.Cmp(wantR) != 0 {
+			t.Fatalf("reduce(%s) = (%s, %s), want (%s, %s)", x, q, r, wantQ, wantR)
+		}
+
+		if nbBits <= 64 {
+			if got := Reduce64(x.Uint64()); uint64(got) != wantR.Uint64() {
+				t.Fatalf("Reduce64(%s) = %d, want %s", x, got, wantR)
+			}
+		}
+		if nbBits <= 128 {
+			hi := new(big.Int).Rsh(x, 64).Uint64()
+			lo := new(big.Int).And(x, new(big.Int).SetUint64(^uint64(0))).Uint64()
+			if got := Reduce128(hi, lo); uint64(got) != wantR.Uint64() {
+				t.Fatalf("Reduce128(%s) = %d, want %s", x, got, wantR)
+			}
+		}
+	}
+}
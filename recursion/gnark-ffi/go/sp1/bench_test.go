@@ -0,0 +1,72 @@
+package sp1
+
+import (
+	"encoding/json"
+	"os"
+	"testing"
+
+	"github.com/consensys/gnark-crypto/ecc"
+	"github.com/consensys/gnark/frontend"
+	"github.com/consensys/gnark/frontend/cs/scs"
+)
+
+// The benchmarks of the PLONK pipeline run against the artifacts built in the directory given by
+// SP1_BENCH_DATA_DIR, such as ~/.sp1/circuits/plonk_bn254/dev, and are skipped without it.
+func benchDataDir(b *testing.B) string {
+	dataDir := os.Getenv("SP1_BENCH_DATA_DIR")
+	if dataDir == "" {
+		b.Skip("SP1_BENCH_DATA_DIR is not set")
+	}
+	SetConstraintsEnv(dataDir)
+	return dataDir
+}
+
+func readWitnessInput(b *testing.B, dataDir string) WitnessInput {
+	data, err := os.ReadFile(dataDir + "/witness.json")
+	if err != nil {
+		b.Fatal(err)
+	}
+	var witnessInput WitnessInput
+	if err := json.Unmarshal(data, &witnessInput); err != nil {
+		b.Fatal(err)
+	}
+	return witnessInput
+}
+
+func BenchmarkWitnessJSON(b *testing.B) {
+	dataDir := benchDataDir(b)
+	data, err := os.ReadFile(dataDir + "/witness.json")
+	if err != nil {
+		b.Fatal(err)
+	}
+	b.ResetTimer()
+	for i := 0; i < b.N; i++ {
+		var witnessInput WitnessInput
+		if err := json.Unmarshal(data, &witnessInput); err != nil {
+			b.Fatal(err)
+		}
+		assignment := NewCircuit(witnessInput)
+		if _, err := frontend.NewWitness(&assignment, ecc.BN254.ScalarField()); err != nil {
+			b.Fatal(err)
+		}
+	}
+}
+
+func BenchmarkCompile(b *testing.B) {
+	circuit := NewCircuit(readWitnessInput(b, benchDataDir(b)))
+	b.ResetTimer()
+	for i := 0; i < b.N; i++ {
+		if _, err := frontend.Compile(ecc.BN254.ScalarField(), scs.NewBuilder, &circuit); err != nil {
+			b.Fatal(err)
+		}
+	}
+}
+
+func BenchmarkProve(b *testing.B) {
+	dataDir := benchDataDir(b)
+	prover := NewProver(dataDir)
+	b.ResetTimer()
+	for i := 0; i < b.N; i++ {
+		prover.Prove(dataDir+"/witness.json", VerifyOff)
+	}
+}
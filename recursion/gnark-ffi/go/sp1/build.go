@@ -1,27 +1,36 @@
 package sp1
 
 import (
+	"bufio"
+	"crypto/sha256"
+	"encoding/hex"
 	"encoding/json"
 	"fmt"
-	"log"
+	"io"
 	"os"
 	"strings"
 
 	"github.com/consensys/gnark-crypto/ecc"
 	"github.com/consensys/gnark-crypto/kzg"
 	"github.com/consensys/gnark/backend/plonk"
+	plonk_bn254 "github.com/consensys/gnark/backend/plonk/bn254"
+	"github.com/consensys/gnark/constraint"
 	"github.com/consensys/gnark/frontend"
 	"github.com/consensys/gnark/frontend/cs/scs"
 	"github.com/consensys/gnark/test/unsafekzg"
 	"github.com/succinctlabs/sp1-recursion-gnark/sp1/trusted_setup"
 )
 
+// PK_BIN_ENV makes Build also write the proving key in the gnark encoding to pk.bin, which the
+// prover falls back to if the memory dump is missing.
+const PK_BIN_ENV = "SP1_BUILD_PK_BIN"
+
 func Build(dataDir string) {
 	// Set the enviroment variable for the constraints file.
 	//
 	// TODO: There might be some non-determinism if a single process is running this command
 	// multiple times.
-	os.Setenv("CONSTRAINTS_JSON", dataDir+"/"+CONSTRAINTS_JSON_FILE)
+	SetConstraintsEnv(dataDir)
 
 	// Read the file.
 	witnessInputPath := dataDir + "/witness.json"
@@ -46,88 +55,8 @@ func Build(dataDir string) {
 		panic(err)
 	}
 
-	// Download the trusted setup.
-	var srs kzg.SRS = kzg.NewSRS(ecc.BN254)
-	var srsLagrange kzg.SRS = kzg.NewSRS(ecc.BN254)
-	srsFileName := dataDir + "/" + SRS_FILE
-	srsLagrangeFileName := dataDir + "/" + SRS_LAGRANGE_FILE
-
-	srsLagrangeFile, err := os.Create(srsLagrangeFileName)
-	if err != nil {
-		log.Fatal("error creating srs file: ", err)
-		panic(err)
-	}
-	defer srsLagrangeFile.Close()
-
-	if !strings.Contains(dataDir, "dev") {
-		if _, err := os.Stat(srsFileName); os.IsNotExist(err) {
-			fmt.Println("downloading aztec ignition srs")
-			trusted_setup.DownloadAndSaveAztecIgnitionSrs(174, srsFileName)
-
-			srsFile, err := os.Open(srsFileName)
-			if err != nil {
-				panic(err)
-			}
-			defer srsFile.Close()
-
-			_, err = srs.ReadFrom(srsFile)
-			srsFile.Close()
-			if err != nil {
-				panic(err)
-			}
-
-			srsLagrange = trusted_setup.ToLagrange(scs, srs)
-			_, err = srsLagrange.WriteTo(srsLagrangeFile)
-			if err != nil {
-				panic(err)
-			}
-		} else {
-			srsFile, err := os.Open(srsFileName)
-			if err != nil {
-				panic(err)
-			}
-			defer srsFile.Close()
-
-			_, err = srs.ReadFrom(srsFile)
-			srsFile.Close()
-			if err != nil {
-				panic(err)
-			}
-
-			srsLagrangeFile, err := os.Open(srsLagrangeFileName)
-			if err != nil {
-				panic(err)
-			}
-			defer srsLagrangeFile.Close()
-
-			_, err = srsLagrange.ReadFrom(srsLagrangeFile)
-			srsLagrangeFile.Close()
-			if err != nil {
-				panic(err)
-			}
-		}
-	} else {
-		srs, srsLagrange, err = unsafekzg.NewSRS(scs)
-		if err != nil {
-			panic(err)
-		}
-
-		srsFile, err := os.Create(srsFileName)
-		if err != nil {
-			panic(err)
-		}
-		defer srsFile.Close()
-
-		_, err = srs.WriteTo(srsFile)
-		if err != nil {
-			panic(err)
-		}
-
-		_, err = srsLagrange.WriteTo(srsLagrangeFile)
-		if err != nil {
-			panic(err)
-		}
-	}
+	// Load the trusted setup.
+	srs, srsLagrange := loadSRS(dataDir, scs)
 
 	// Generate the proving and verifying key.
 	pk, vk, err := plonk.Setup(scs, srs, srsLagrange)
@@ -159,43 +88,98 @@ func Build(dataDir string) {
 	// Create the build directory.
 	os.MkdirAll(dataDir, 0755)
 
-	// Write the solidity verifier.
-	solidityVerifierFile, err := os.Create(dataDir + "/" + VERIFIER_CONTRACT_PATH)
-	if err != nil {
-		panic(err)
+	// Write the artifacts concurrently. The memory dump of the proving key is mapped read-only by
+	// the prover, so pk.bin is only written on request, as it would ship the key twice.
+	artifacts := []artifact{
+		{VERIFIER_CONTRACT_PATH, func(w io.Writer) error { return vk.ExportSolidity(w) }},
+		{CIRCUIT_PATH, writerToFunc(scs)},
+		{VK_PATH, writerToFunc(vk)},
+		{PK_DUMP_PATH, func(w io.Writer) error { return pk.(*plonk_bn254.ProvingKey).WriteDump(w) }},
 	}
-	vk.ExportSolidity(solidityVerifierFile)
+	if os.Getenv(PK_BIN_ENV) != "" {
+		artifacts = append(artifacts, artifact{PK_PATH, writerToFunc(pk)})
+	}
+	writeArtifacts(dataDir, artifacts)
+}
 
-	// Write the R1CS.
-	scsFile, err := os.Create(dataDir + "/" + CIRCUIT_PATH)
-	if err != nil {
-		panic(err)
+// writerToFunc adapts an io.WriterTo to an artifact write function.
+func writerToFunc(v io.WriterTo) func(w io.Writer) error {
+	return func(w io.Writer) error {
+		_, err := v.WriteTo(w)
+		return err
 	}
-	defer scsFile.Close()
-	_, err = scs.WriteTo(scsFile)
-	if err != nil {
-		panic(err)
+}
+
+// srsLagrangeFileName returns the cache file of the Lagrange SRS with the given size, derived from
+// the canonical SRS with the given hash.
+func srsLagrangeFileName(dataDir string, size int, srsHash string) string {
+	return fmt.Sprintf("%s/%s_%d_%s.bin", dataDir, SRS_LAGRANGE_FILE_PREFIX, size, srsHash[:16])
+}
+
+// loadSRS returns the canonical and Lagrange SRS for the constraint system. The Lagrange SRS is
+// cached in the data directory by circuit size and hash of the canonical SRS, so it is only
+// recomputed when either of them changes.
+func loadSRS(dataDir string, scs constraint.ConstraintSystem) (kzg.SRS, kzg.SRS) {
+	srsFileName := dataDir + "/" + SRS_FILE
+
+	if strings.Contains(dataDir, "dev") {
+		srs, srsLagrange, err := unsafekzg.NewSRS(scs)
+		if err != nil {
+			panic(err)
+		}
+		srsHash, err := writeArtifact(srsFileName, writerToFunc(srs))
+		if err != nil {
+			panic(err)
+		}
+		lagrangeFileName := srsLagrangeFileName(dataDir, trusted_setup.LagrangeSize(scs), srsHash)
+		_, err = writeArtifact(lagrangeFileName, writerToFunc(srsLagrange))
+		if err != nil {
+			panic(err)
+		}
+		return srs, srsLagrange
 	}
 
-	// Write the verifier key.
-	vkFile, err := os.Create(dataDir + "/" + VK_PATH)
-	if err != nil {
-		panic(err)
+	if _, err := os.Stat(srsFileName); os.IsNotExist(err) {
+		fmt.Println("downloading aztec ignition srs")
+		trusted_setup.DownloadAndSaveAztecIgnitionSrs(174, srsFileName)
 	}
-	defer vkFile.Close()
-	_, err = vk.WriteTo(vkFile)
+	var srs kzg.SRS = kzg.NewSRS(ecc.BN254)
+	srsHash, err := readSRS(srsFileName, srs)
 	if err != nil {
 		panic(err)
 	}
 
-	// Write the proving key.
-	pkFile, err := os.Create(dataDir + "/" + PK_PATH)
+	lagrangeFileName := srsLagrangeFileName(dataDir, trusted_setup.LagrangeSize(scs), srsHash)
+	var srsLagrange kzg.SRS = kzg.NewSRS(ecc.BN254)
+	if _, err := readSRS(lagrangeFileName, srsLagrange); err == nil {
+		return srs, srsLagrange
+	}
+
+	fmt.Println("computing lagrange srs")
+	srsLagrange = trusted_setup.ToLagrange(scs, srs)
+	_, err = writeArtifact(lagrangeFileName, writerToFunc(srsLagrange))
 	if err != nil {
 		panic(err)
 	}
-	defer pkFile.Close()
-	_, err = pk.WriteTo(pkFile)
+	return srs, srsLagrange
+}
+
+// readSRS decodes the SRS at path into srs and returns the hex encoded sha256 of the file, which
+// is computed while it is read.
+func readSRS(path string, srs kzg.SRS) (string, error) {
+	file, err := os.Open(path)
 	if err != nil {
-		panic(err)
+		return "", err
+	}
+	defer file.Close()
+
+	hasher := sha256.New()
+	reader := io.TeeReader(bufio.NewReaderSize(file, 1024*1024), hasher)
+	if _, err := srs.ReadFrom(reader); err != nil {
+		return "", err
+	}
+	if _, err := io.Copy(io.Discard, reader); err != nil {
+		return "", err
 	}
+	return hex.EncodeToString(hasher.Sum(nil)), nil
 }
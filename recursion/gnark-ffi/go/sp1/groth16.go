@@ -0,0 +1,271 @@
+package sp1
+
+import (
+	"bufio"
+	"bytes"
+	"encoding/hex"
+	"encoding/json"
+	"fmt"
+	"io"
+	"os"
+
+	"github.com/consensys/gnark-crypto/ecc"
+	"github.com/consensys/gnark/backend"
+	"github.com/consensys/gnark/backend/groth16"
+	groth16_bn254 "github.com/consensys/gnark/backend/groth16/bn254"
+	"github.com/consensys/gnark/frontend"
+	"github.com/consensys/gnark/frontend/cs/r1cs"
+	"github.com/succinctlabs/sp1-recursion-gnark/sp1/babybear"
+)
+
+var GROTH16_VERIFIER_CONTRACT_PATH string = "Groth16Verifier.sol"
+var GROTH16_CIRCUIT_PATH string = "groth16_circuit.bin"
+var GROTH16_VK_PATH string = "groth16_vk.bin"
+var GROTH16_PK_PATH string = "groth16_pk.bin"
+
+// BuildGroth16 compiles the circuit to R1CS and writes the Groth16 artifacts to the data
+// directory.
+//
+// The keys are generated with a local, single-party setup.
+func BuildGroth16(dataDir string) {
+	SetConstraintsEnv(dataDir)
+
+	// Read the file.
+	witnessInputPath := dataDir + "/" + WITNESS_JSON_FILE
+	data, err := os.ReadFile(witnessInputPath)
+	if err != nil {
+		panic(err)
+	}
+
+	// Deserialize the JSON data into a slice of Instruction structs
+	var witnessInput WitnessInput
+	err = json.Unmarshal(data, &witnessInput)
+	if err != nil {
+		panic(err)
+	}
+
+	// Initialize the circuit.
+	circuit := NewCircuit(witnessInput)
+
+	// Compile the circuit.
+	r1cs, err := frontend.Compile(ecc.BN254.ScalarField(), r1cs.NewBuilder, &circuit)
+	if err != nil {
+		panic(err)
+	}
+
+	// Generate the proving and verifying key.
+	pk, vk, err := groth16.Setup(r1cs)
+	if err != nil {
+		panic(err)
+	}
+
+	// Generate proof.
+	assignment := NewCircuit(witnessInput)
+	witness, err := frontend.NewWitness(&assignment, ecc.BN254.ScalarField())
+	if err != nil {
+		panic(err)
+	}
+	proof, err := groth16.Prove(r1cs, pk, witness)
+	if err != nil {
+		panic(err)
+	}
+
+	// Verify proof.
+	publicWitness, err := witness.Public()
+	if err != nil {
+		panic(err)
+	}
+	err = groth16.Verify(proof, vk, publicWitness)
+	if err != nil {
+		panic(err)
+	}
+
+	// Create the build directory.
+	os.MkdirAll(dataDir, 0755)
+
+	// Write the artifacts concurrently.
+	writeArtifacts(dataDir, []artifact{
+		{GROTH16_VERIFIER_CONTRACT_PATH, func(w io.Writer) error { return vk.ExportSolidity(w) }},
+		{GROTH16_CIRCUIT_PATH, writerToFunc(r1cs)},
+		{GROTH16_VK_PATH, writerToFunc(vk)},
+		{GROTH16_PK_PATH, writerToFunc(pk)},
+	})
+}
+
+// groth16ProverOptions returns the prover options for the requested acceleration. GPU acceleration
+// is only used if the library was built with ICICLE support.
+func groth16ProverOptions(useGPU bool) []backend.ProverOption {
+	if !useGPU {
+		return nil
+	}
+	if !IcicleEnabled {
+		fmt.Println("[sp1] gpu acceleration requested but the library was built without icicle, using cpu")
+		return nil
+	}
+	return []backend.ProverOption{backend.WithIcicleAcceleration()}
+}
+
+// ProveGroth16 generates a Groth16 proof for the JSON witness at the given path. If useGPU is set
+// and the GPU prover fails, the proof is generated on the CPU instead.
+func ProveGroth16(dataDir string, witnessPath string, useGPU bool) Proof {
+	// Sanity check the required arguments have been provided.
+	if dataDir == "" {
+		panic("dataDirStr is required")
+	}
+	SetConstraintsEnv(dataDir)
+
+	// Read the R1CS.
+	r1csFile, err := os.Open(dataDir + "/" + GROTH16_CIRCUIT_PATH)
+	if err != nil {
+		panic(err)
+	}
+	defer r1csFile.Close()
+	r1cs := groth16.NewCS(ecc.BN254)
+	r1cs.ReadFrom(r1csFile)
+
+	// Read the proving key.
+	pkFile, err := os.Open(dataDir + "/" + GROTH16_PK_PATH)
+	if err != nil {
+		panic(err)
+	}
+	defer pkFile.Close()
+	pk := groth16.NewProvingKey(ecc.BN254)
+	bufReader := bufio.NewReaderSize(pkFile, 1024*1024)
+	pk.UnsafeReadFrom(bufReader)
+
+	// Read the verifier key.
+	vkFile, err := os.Open(dataDir + "/" + GROTH16_VK_PATH)
+	if err != nil {
+		panic(err)
+	}
+	defer vkFile.Close()
+	vk := groth16.NewVerifyingKey(ecc.BN254)
+	vk.ReadFrom(vkFile)
+
+	// Read the file.
+	data, err := os.ReadFile(witnessPath)
+	if err != nil {
+		panic(err)
+	}
+
+	// Deserialize the JSON data into a slice of Instruction structs
+	var witnessInput WitnessInput
+	err = json.Unmarshal(data, &witnessInput)
+	if err != nil {
+		panic(err)
+	}
+
+	// Generate the witness.
+	assignment := NewCircuit(witnessInput)
+	witness, err := frontend.NewWitness(&assignment, ecc.BN254.ScalarField())
+	if err != nil {
+		panic(err)
+	}
+	publicWitness, err := witness.Public()
+	if err != nil {
+		panic(err)
+	}
+
+	// Generate the proof.
+	opts := groth16ProverOptions(useGPU)
+	proof, err := groth16.Prove(r1cs, pk, witness, opts...)
+	if err != nil && len(opts) > 0 {
+		fmt.Println("[sp1] gpu proving failed, falling back to cpu:", err)
+		proof, err = groth16.Prove(r1cs, pk, witness)
+	}
+	if err != nil {
+		panic(err)
+	}
+
+	// Verify proof.
+	err = groth16.Verify(proof, vk, publicWitness)
+	if err != nil {
+		panic(err)
+	}
+
+	return NewSP1Groth16Bn254Proof(&proof, witnessInput.VkeyHash, witnessInput.CommitedValuesDigest)
+}
+
+// VerifyGroth16 verifies a hex encoded raw Groth16 proof against the given public inputs.
+func VerifyGroth16(verifyCmdDataDir string, verifyCmdProof string, verifyCmdVkeyHash string, verifyCmdCommitedValuesDigest string) error {
+	// Sanity check the required arguments have been provided.
+	if verifyCmdDataDir == "" {
+		panic("--data is required")
+	}
+
+	// Decode the proof.
+	proofDecodedBytes, err := hex.DecodeString(verifyCmdProof)
+	if err != nil {
+		panic(err)
+	}
+	proof := groth16.NewProof(ecc.BN254)
+	if _, err := proof.ReadFrom(bytes.NewReader(proofDecodedBytes)); err != nil {
+		panic(err)
+	}
+
+	// Read the verifier key.
+	vkFile, err := os.Open(verifyCmdDataDir + "/" + GROTH16_VK_PATH)
+	if err != nil {
+		panic(err)
+	}
+	defer vkFile.Close()
+	vk := groth16.NewVerifyingKey(ecc.BN254)
+	vk.ReadFrom(vkFile)
+
+	// Compute the public witness.
+	circuit := Circuit{
+		Vars:                 []frontend.Variable{},
+		Felts:                []babybear.Variable{},
+		Exts:                 []babybear.ExtensionVariable{},
+		VkeyHash:             verifyCmdVkeyHash,
+		CommitedValuesDigest: verifyCmdCommitedValuesDigest,
+	}
+	witness, err := frontend.NewWitness(&circuit, ecc.BN254.ScalarField())
+	if err != nil {
+		panic(err)
+	}
+	publicWitness, err := witness.Public()
+	if err != nil {
+		panic(err)
+	}
+
+	// Verify proof.
+	err = groth16.Verify(proof, vk, publicWitness)
+	return err
+}
+
+// NewSP1Groth16Bn254Proof encodes a Groth16 proof. The encoded proof is the uncompressed
+// concatenation of Ar, Bs, Krs, the commitments and the commitment proof of knowledge, in the
+// coordinate order expected by the EVM pairing precompile.
+func NewSP1Groth16Bn254Proof(proof *groth16.Proof, vkeyHash string, commitedValuesDigest string) Proof {
+	var buf bytes.Buffer
+	(*proof).WriteRawTo(&buf)
+	proofBytes := buf.Bytes()
+
+	var publicInputs [2]string
+	publicInputs[0] = vkeyHash
+	publicInputs[1] = commitedValuesDigest
+
+	// Cast groth16 proof into groth16_bn254 proof so we can access the curve points.
+	p := (*proof).(*groth16_bn254.Proof)
+
+	var encodedProof bytes.Buffer
+	ar := p.Ar.RawBytes()
+	bs := p.Bs.RawBytes()
+	krs := p.Krs.RawBytes()
+	encodedProof.Write(ar[:])
+	encodedProof.Write(bs[:])
+	encodedProof.Write(krs[:])
+	for i := range p.Commitments {
+		commitment := p.Commitments[i].RawBytes()
+		encodedProof.Write(commitment[:])
+	}
+	commitmentPok := p.CommitmentPok.RawBytes()
+	encodedProof.Write(commitmentPok[:])
+
+	return Proof{
+		PublicInputs: publicInputs,
+		EncodedProof: hex.EncodeToString(encodedProof.Bytes()),
+		RawProof:     hex.EncodeToString(proofBytes),
+	}
+}
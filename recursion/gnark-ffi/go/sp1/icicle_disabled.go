@@ -0,0 +1,7 @@
+//go:build !icicle
+
+package sp1
+
+// IcicleEnabled reports whether the library was built with the icicle build tag, which links the
+// ICICLE CUDA backend used to offload BN254 MSMs and NTTs in the Groth16 prover.
+const IcicleEnabled = false
@@ -0,0 +1,75 @@
+package sp1
+
+import (
+	"github.com/succinctlabs/sp1-recursion-gnark/sp1/babybear"
+)
+
+// pendingInversion is an InvE or DivE whose result is not yet stored in its slot.
+type pendingInversion[K comparable] struct {
+	slot        K
+	numerator   babybear.ExtensionVariable
+	denominator babybear.ExtensionVariable
+	isDivision  bool
+}
+
+// inversionBatch defers the InvE and DivE constraints of an interpreter, so that independent
+// inversions are solved by a single BatchInvE hint instead of crossing into Rust once each. The
+// group is flushed when a slot with a pending result is read or written, and at the end.
+type inversionBatch[K comparable] struct {
+	fieldAPI *babybear.Chip
+	store    func(K, babybear.ExtensionVariable)
+	pending  []pendingInversion[K]
+	slots    map[K]struct{}
+}
+
+func newInversionBatch[K comparable](fieldAPI *babybear.Chip, store func(K, babybear.ExtensionVariable)) *inversionBatch[K] {
+	return &inversionBatch[K]{fieldAPI: fieldAPI, store: store, slots: make(map[K]struct{})}
+}
+
+// touch flushes the group if the slot holds a pending result. It must be called before the slot
+// is read or written.
+func (b *inversionBatch[K]) touch(slot K) {
+	if len(b.pending) == 0 {
+		return
+	}
+	if _, ok := b.slots[slot]; ok {
+		b.flush()
+	}
+}
+
+// inv stores the inverse of in into the slot when the group is flushed.
+func (b *inversionBatch[K]) inv(slot K, in babybear.ExtensionVariable) {
+	b.add(pendingInversion[K]{slot: slot, denominator: in})
+}
+
+// div stores a / in into the slot when the group is flushed.
+func (b *inversionBatch[K]) div(slot K, a, in babybear.ExtensionVariable) {
+	b.add(pendingInversion[K]{slot: slot, numerator: a, denominator: in, isDivision: true})
+}
+
+func (b *inversionBatch[K]) add(inversion pendingInversion[K]) {
+	b.touch(inversion.slot)
+	b.pending = append(b.pending, inversion)
+	b.slots[inversion.slot] = struct{}{}
+}
+
+// flush inverts the pending group with one hint and stores the results in their slots.
+func (b *inversionBatch[K]) flush() {
+	if len(b.pending) == 0 {
+		return
+	}
+	denominators := make([]babybear.ExtensionVariable, len(b.pending))
+	for i := range b.pending {
+		denominators[i] = b.pending[i].denominator
+	}
+	inverses := b.fieldAPI.BatchInvE(denominators)
+	for i, inversion := range b.pending {
+		if inversion.isDivision {
+			b.store(inversion.slot, b.fieldAPI.MulE(inversion.numerator, inverses[i]))
+		} else {
+			b.store(inversion.slot, inverses[i])
+		}
+	}
+	b.pending = b.pending[:0]
+	clear(b.slots)
+}
@@ -0,0 +1,68 @@
+package sp1
+
+import (
+	"fmt"
+	"testing"
+
+	"github.com/consensys/gnark-crypto/ecc"
+	"github.com/consensys/gnark/frontend"
+	"github.com/consensys/gnark/test"
+	"github.com/succinctlabs/sp1-recursion-gnark/sp1/babybear"
+)
+
+type testInversionBatchCircuit struct {
+	In [4]babybear.ExtensionVariable
+}
+
+func (circuit *testInversionBatchCircuit) Define(api frontend.API) error {
+	fieldAPI := babybear.NewChip(api)
+	results := make(map[int]babybear.ExtensionVariable)
+	inversions := newInversionBatch(fieldAPI, func(slot int, v babybear.ExtensionVariable) {
+		results[slot] = v
+	})
+	in := circuit.In
+
+	// Independent inversions are grouped until a pending result is needed.
+	inversions.inv(0, in[0])
+	inversions.div(1, in[1], in[2])
+	inversions.inv(2, in[3])
+	inversions.touch(3)
+	if len(inversions.pending) != 3 {
+		return fmt.Errorf("expected 3 pending inversions, got %d", len(inversions.pending))
+	}
+	inversions.touch(0)
+	if len(inversions.pending) != 0 {
+		return fmt.Errorf("reading a pending result should flush the group")
+	}
+
+	// An inversion of a flushed result starts a new group, and writing to a pending slot flushes
+	// the earlier inversion first.
+	inversions.inv(3, results[0])
+	inversions.div(4, in[0], in[1])
+	inversions.div(4, in[2], in[3])
+	if len(inversions.pending) != 1 {
+		return fmt.Errorf("overwriting a pending slot should flush the group")
+	}
+	inversions.flush()
+
+	fieldAPI.AssertIsEqualE(results[0], fieldAPI.InvE(in[0]))
+	fieldAPI.AssertIsEqualE(results[1], fieldAPI.DivE(in[1], in[2]))
+	fieldAPI.AssertIsEqualE(results[2], fieldAPI.InvE(in[3]))
+	fieldAPI.AssertIsEqualE(results[3], fieldAPI.InvE(fieldAPI.InvE(in[0])))
+	fieldAPI.AssertIsEqualE(results[3], in[0])
+	fieldAPI.AssertIsEqualE(results[4], fieldAPI.DivE(in[2], in[3]))
+	return nil
+}
+
+func TestInversionBatch(t *testing.T) {
+	assert := test.NewAssert(t)
+	in := [4]babybear.ExtensionVariable{
+		babybear.NewE([]string{"1", "2", "3", "4"}),
+		babybear.NewE([]string{"5", "0", "7", "2013265920"}),
+		babybear.NewE([]string{"0", "0", "0", "9"}),
+		babybear.NewE([]string{"123456789", "1", "0", "0"}),
+	}
+	circuit := testInversionBatchCircuit{In: in}
+	assignment := testInversionBatchCircuit{In: in}
+	assert.NoError(test.IsSolved(&circuit, &assignment, ecc.BN254.ScalarField()))
+}
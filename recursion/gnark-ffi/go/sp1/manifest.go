@@ -0,0 +1,102 @@
+package sp1
+
+import (
+	"bufio"
+	"crypto/sha256"
+	"encoding/hex"
+	"encoding/json"
+	"io"
+	"os"
+	"sync"
+)
+
+var MANIFEST_FILE string = "manifest.json"
+
+// BuildManifest records the sha256 checksum of every artifact written by a build, keyed by file
+// name, so that consumers can look up digests such as the verifier key hash without rereading
+// the artifacts.
+type BuildManifest struct {
+	Artifacts map[string]string `json:"artifacts"`
+}
+
+// artifact is a build output that is streamed to a file in the data directory.
+type artifact struct {
+	name  string
+	write func(w io.Writer) error
+}
+
+// writeArtifacts writes all artifacts to the data directory concurrently, each through its own
+// buffered writer, and records their checksums in the build manifest. The checksums are computed
+// while the artifacts are written, so no file is read back.
+func writeArtifacts(dataDir string, artifacts []artifact) {
+	checksums := make([]string, len(artifacts))
+	errs := make([]error, len(artifacts))
+
+	var wg sync.WaitGroup
+	for i, a := range artifacts {
+		wg.Add(1)
+		go func(i int, a artifact) {
+			defer wg.Done()
+			checksums[i], errs[i] = writeArtifact(dataDir+"/"+a.name, a.write)
+		}(i, a)
+	}
+	wg.Wait()
+
+	for _, err := range errs {
+		if err != nil {
+			panic(err)
+		}
+	}
+
+	manifest := ReadBuildManifest(dataDir)
+	for i, a := range artifacts {
+		manifest.Artifacts[a.name] = checksums[i]
+	}
+	manifestFile, err := os.Create(dataDir + "/" + MANIFEST_FILE)
+	if err != nil {
+		panic(err)
+	}
+	defer manifestFile.Close()
+	encoder := json.NewEncoder(manifestFile)
+	encoder.SetIndent("", "  ")
+	err = encoder.Encode(manifest)
+	if err != nil {
+		panic(err)
+	}
+}
+
+// writeArtifact streams an artifact to path and returns the hex encoded sha256 of its contents.
+func writeArtifact(path string, write func(w io.Writer) error) (string, error) {
+	file, err := os.Create(path)
+	if err != nil {
+		return "", err
+	}
+	defer file.Close()
+
+	hasher := sha256.New()
+	writer := bufio.NewWriterSize(file, 1024*1024)
+	if err := write(io.MultiWriter(writer, hasher)); err != nil {
+		return "", err
+	}
+	if err := writer.Flush(); err != nil {
+		return "", err
+	}
+	if err := file.Close(); err != nil {
+		return "", err
+	}
+	return hex.EncodeToString(hasher.Sum(nil)), nil
+}
+
+// ReadBuildManifest reads the build manifest in the data directory. A missing or unreadable
+// manifest yields an empty one, so builds that share a directory extend it.
+func ReadBuildManifest(dataDir string) BuildManifest {
+	manifest := BuildManifest{Artifacts: map[string]string{}}
+	data, err := os.ReadFile(dataDir + "/" + MANIFEST_FILE)
+	if err != nil {
+		return manifest
+	}
+	if err := json.Unmarshal(data, &manifest); err != nil || manifest.Artifacts == nil {
+		return BuildManifest{Artifacts: map[string]string{}}
+	}
+	return manifest
+}
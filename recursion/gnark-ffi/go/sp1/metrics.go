@@ -0,0 +1,74 @@
+package sp1
+
+import (
+	"fmt"
+	"sort"
+	"strings"
+	"sync"
+	"time"
+)
+
+// The upper bounds of the histogram buckets, in seconds. They match the buckets of the Rust
+// registry in sp1_core::utils::metrics.
+var metricBuckets = []float64{
+	0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10, 30, 60, 300,
+}
+
+type histogram struct {
+	buckets []uint64
+	sum     float64
+	count   uint64
+}
+
+// Histograms of the durations of the prover stages, keyed by metric name. They are rendered for
+// the Rust side, which serves them along with its own metrics.
+var metrics = struct {
+	sync.Mutex
+	histograms map[string]*histogram
+}{histograms: map[string]*histogram{}}
+
+// observeDuration records the time since start in the histogram with the given name.
+func observeDuration(name string, start time.Time) {
+	seconds := time.Since(start).Seconds()
+	metrics.Lock()
+	defer metrics.Unlock()
+	h, ok := metrics.histograms[name]
+	if !ok {
+		h = &histogram{buckets: make([]uint64, len(metricBuckets))}
+		metrics.histograms[name] = h
+	}
+	for i, bound := range metricBuckets {
+		if seconds <= bound {
+			h.buckets[i]++
+			break
+		}
+	}
+	h.sum += seconds
+	h.count++
+}
+
+// RenderMetrics returns the histograms in the Prometheus text format.
+func RenderMetrics() string {
+	metrics.Lock()
+	defer metrics.Unlock()
+	names := make([]string, 0, len(metrics.histograms))
+	for name := range metrics.histograms {
+		names = append(names, name)
+	}
+	sort.Strings(names)
+
+	var out strings.Builder
+	for _, name := range names {
+		h := metrics.histograms[name]
+		fmt.Fprintf(&out, "# TYPE %s histogram\n", name)
+		var cumulative uint64
+		for i, bound := range metricBuckets {
+			cumulative += h.buckets[i]
+			fmt.Fprintf(&out, "%s_bucket{le=\"%v\"} %d\n", name, bound, cumulative)
+		}
+		fmt.Fprintf(&out, "%s_bucket{le=\"+Inf\"} %d\n", name, h.count)
+		fmt.Fprintf(&out, "%s_sum %v\n", name, h.sum)
+		fmt.Fprintf(&out, "%s_count %d\n", name, h.count)
+	}
+	return out.String()
+}
@@ -0,0 +1,31 @@
+package sp1
+
+import (
+	"os"
+	"syscall"
+)
+
+// mmapFile maps the file at path read-only into memory. The mapping is shared, so several
+// processes loading the same file are served from the same page cache pages. The caller must call
+// the returned function to unmap the file once the data is no longer referenced.
+func mmapFile(path string) ([]byte, func() error, error) {
+	f, err := os.Open(path)
+	if err != nil {
+		return nil, nil, err
+	}
+	defer f.Close()
+
+	info, err := f.Stat()
+	if err != nil {
+		return nil, nil, err
+	}
+	if info.Size() == 0 {
+		return []byte{}, func() error { return nil }, nil
+	}
+
+	data, err := syscall.Mmap(int(f.Fd()), 0, int(info.Size()), syscall.PROT_READ, syscall.MAP_SHARED)
+	if err != nil {
+		return nil, nil, err
+	}
+	return data, func() error { return syscall.Munmap(data) }, nil
+}
@@ -1,6 +1,8 @@
 package poseidon2
 
 import (
+	"math/big"
+
 	"github.com/consensys/gnark/frontend"
 	"github.com/succinctlabs/sp1-recursion-gnark/sp1/babybear"
 )
@@ -57,20 +59,21 @@ func (p *Poseidon2BabyBearChip) addRc(state *[BABYBEAR_WIDTH]babybear.Variable,
 	}
 }
 
+// sboxP raises an element to the seventh power. The input is reduced only if its power could
+// exceed the bits available to a variable, and the output is left unreduced for the linear layer.
 func (p *Poseidon2BabyBearChip) sboxP(input babybear.Variable) babybear.Variable {
-	zero := babybear.NewF("0")
-	inputCpy := p.fieldApi.AddF(input, zero)
-	inputCpy = p.fieldApi.ReduceSlow(inputCpy)
-	inputValue := inputCpy.Value
+	if BABYBEAR_DEGREE*input.NbBits > babybear.MAX_NB_BITS {
+		input = p.fieldApi.ReduceSlow(input)
+	}
+	inputValue := input.Value
 	i2 := p.api.Mul(inputValue, inputValue)
 	i4 := p.api.Mul(i2, i2)
 	i6 := p.api.Mul(i4, i2)
 	i7 := p.api.Mul(i6, inputValue)
-	i7bb := p.fieldApi.ReduceSlow(babybear.Variable{
+	return babybear.Variable{
 		Value:  i7,
-		NbBits: 31 * 7,
-	})
-	return i7bb
+		NbBits: BABYBEAR_DEGREE * input.NbBits,
+	}
 }
 
 func (p *Poseidon2BabyBearChip) sbox(state *[BABYBEAR_WIDTH]babybear.Variable) {
@@ -114,44 +117,38 @@ func (p *Poseidon2BabyBearChip) externalLinearLayer(state *[BABYBEAR_WIDTH]babyb
 	}
 }
 
-func (p *Poseidon2BabyBearChip) diffusionPermuteMut(state *[BABYBEAR_WIDTH]babybear.Variable) {
-	matInternalDiagM1 := [BABYBEAR_WIDTH]babybear.Variable{
-		babybear.NewF("2013265919"),
-		babybear.NewF("1"),
-		babybear.NewF("2"),
-		babybear.NewF("4"),
-		babybear.NewF("8"),
-		babybear.NewF("16"),
-		babybear.NewF("32"),
-		babybear.NewF("64"),
-		babybear.NewF("128"),
-		babybear.NewF("256"),
-		babybear.NewF("512"),
-		babybear.NewF("1024"),
-		babybear.NewF("2048"),
-		babybear.NewF("4096"),
-		babybear.NewF("8192"),
-		babybear.NewF("32768"),
-	}
-	montyInverse := babybear.NewF("943718400")
-	p.matmulInternal(state, &matInternalDiagM1)
-	for i := 0; i < BABYBEAR_WIDTH; i++ {
-		state[i] = p.fieldApi.MulF(state[i], montyInverse)
-	}
+// The diagonal of the internal matrix minus the identity, scaled by the Montgomery inverse.
+var matInternalDiagM1Monty [BABYBEAR_WIDTH]babybear.Variable
 
+// The Montgomery inverse that scales the sum of the state in the internal linear layer.
+var montyInverse = babybear.NewF("943718400")
+
+func init() {
+	matInternalDiagM1 := [BABYBEAR_WIDTH]string{
+		"2013265919", "1", "2", "4", "8", "16", "32", "64",
+		"128", "256", "512", "1024", "2048", "4096", "8192", "32768",
+	}
+	monty, _ := new(big.Int).SetString("943718400", 10)
+	for i, d := range matInternalDiagM1 {
+		diag, _ := new(big.Int).SetString(d, 10)
+		diag.Mul(diag, monty).Mod(diag, babybear.MODULUS)
+		matInternalDiagM1Monty[i] = babybear.NewF(diag.String())
+	}
 }
 
-func (p *Poseidon2BabyBearChip) matmulInternal(
-	state *[BABYBEAR_WIDTH]babybear.Variable,
-	matInternalDiagM1 *[BABYBEAR_WIDTH]babybear.Variable,
-) {
-	sum := babybear.NewF("0")
-	for i := 0; i < BABYBEAR_WIDTH; i++ {
+// diffusionPermuteMut applies the internal linear layer, which multiplies each element by its
+// diagonal entry minus one, adds the sum of the state and scales the result by the Montgomery
+// inverse. The scaling is folded into the diagonal and applied to the sum once, so that each
+// element takes a single multiplication by a constant and the values grow by fewer bits.
+func (p *Poseidon2BabyBearChip) diffusionPermuteMut(state *[BABYBEAR_WIDTH]babybear.Variable) {
+	sum := state[0]
+	for i := 1; i < BABYBEAR_WIDTH; i++ {
 		sum = p.fieldApi.AddF(sum, state[i])
 	}
+	sum = p.fieldApi.MulF(sum, montyInverse)
 
 	for i := 0; i < BABYBEAR_WIDTH; i++ {
-		state[i] = p.fieldApi.MulF(state[i], matInternalDiagM1[i])
+		state[i] = p.fieldApi.MulF(state[i], matInternalDiagM1Monty[i])
 		state[i] = p.fieldApi.AddF(state[i], sum)
 	}
 }
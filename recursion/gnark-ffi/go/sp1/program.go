@@ -0,0 +1,299 @@
+package sp1
+
+import (
+	"bytes"
+	"encoding/binary"
+	"fmt"
+	"io"
+	"math/big"
+	"os"
+
+	"github.com/consensys/gnark/frontend"
+	"github.com/succinctlabs/sp1-recursion-gnark/sp1/babybear"
+	"github.com/succinctlabs/sp1-recursion-gnark/sp1/poseidon2"
+)
+
+// The opcodes of the binary constraint program. These must match the discriminants of
+// `ConstraintOpcode` in recursion/compiler/src/constraints/opcodes.rs.
+const (
+	OpImmV uint8 = iota
+	OpImmF
+	OpImmE
+	OpAddV
+	OpAddF
+	OpAddE
+	OpAddEF
+	OpSubV
+	OpSubF
+	OpSubE
+	OpSubEF
+	OpMulV
+	OpMulF
+	OpMulE
+	OpMulEF
+	OpDivF
+	OpDivE
+	OpDivEF
+	OpNegV
+	OpNegF
+	OpNegE
+	OpInvV
+	OpInvF
+	OpInvE
+	OpAssertEqV
+	OpAssertEqF
+	OpAssertEqE
+	OpPermute
+	OpNum2BitsV
+	OpNum2BitsF
+	OpSelectV
+	OpSelectF
+	OpSelectE
+	OpExt2Felt
+	OpPrintV
+	OpPrintF
+	OpPrintE
+	OpWitnessV
+	OpWitnessF
+	OpWitnessE
+	OpCommitVkeyHash
+	OpCommitCommitedValuesDigest
+	OpCircuitFelts2Ext
+	OpPermuteBabyBear
+)
+
+var constraintProgramMagic = []byte("SP1C")
+
+// ProgramConstraint is a decoded constraint of a binary constraint program. Arguments hold slot
+// indices or immediates depending on the opcode.
+type ProgramConstraint struct {
+	Opcode uint8
+	Args   [][]uint32
+}
+
+// ConstraintProgram is the binary form of the constraint system emitted by
+// `encode_constraints` in the recursion compiler.
+type ConstraintProgram struct {
+	NbVars      uint32
+	NbFelts     uint32
+	NbExts      uint32
+	Constraints []ProgramConstraint
+}
+
+// IsConstraintProgram reports whether the file at path is a binary constraint program.
+func IsConstraintProgram(path string) bool {
+	f, err := os.Open(path)
+	if err != nil {
+		return false
+	}
+	defer f.Close()
+	header := make([]byte, len(constraintProgramMagic))
+	if _, err := io.ReadFull(f, header); err != nil {
+		return false
+	}
+	return bytes.Equal(header, constraintProgramMagic)
+}
+
+// DecodeConstraintProgram parses a binary constraint program.
+func DecodeConstraintProgram(data []byte) (*ConstraintProgram, error) {
+	if !bytes.HasPrefix(data, constraintProgramMagic) {
+		return nil, fmt.Errorf("not a binary constraint program")
+	}
+	offset := len(constraintProgramMagic)
+	if len(data) < offset+16 {
+		return nil, fmt.Errorf("binary constraint program truncated")
+	}
+	readU32 := func() uint32 {
+		v := binary.LittleEndian.Uint32(data[offset:])
+		offset += 4
+		return v
+	}
+
+	program := &ConstraintProgram{}
+	program.NbVars = readU32()
+	program.NbFelts = readU32()
+	program.NbExts = readU32()
+	nbConstraints := readU32()
+
+	// All argument words share a single backing slice to avoid an allocation per argument.
+	words := make([]uint32, 0, (len(data)-offset)/4)
+	program.Constraints = make([]ProgramConstraint, nbConstraints)
+	for i := range program.Constraints {
+		if len(data) < offset+2 {
+			return nil, fmt.Errorf("binary constraint program truncated at constraint %d", i)
+		}
+		cs := &program.Constraints[i]
+		cs.Opcode = data[offset]
+		nbArgs := int(data[offset+1])
+		offset += 2
+		cs.Args = make([][]uint32, nbArgs)
+		for j := 0; j < nbArgs; j++ {
+			if len(data) < offset+4 {
+				return nil, fmt.Errorf("binary constraint program truncated at constraint %d", i)
+			}
+			nbWords := int(readU32())
+			if len(data) < offset+4*nbWords {
+				return nil, fmt.Errorf("binary constraint program truncated at constraint %d", i)
+			}
+			start := len(words)
+			for k := 0; k < nbWords; k++ {
+				words = append(words, readU32())
+			}
+			cs.Args[j] = words[start:len(words):len(words)]
+		}
+	}
+	if offset != len(data) {
+		return nil, fmt.Errorf("binary constraint program has %d trailing bytes", len(data)-offset)
+	}
+	return program, nil
+}
+
+// wordsToBigInt converts little-endian 32-bit words into a big integer.
+func wordsToBigInt(words []uint32) *big.Int {
+	be := make([]byte, 4*len(words))
+	for i, w := range words {
+		binary.BigEndian.PutUint32(be[4*(len(words)-1-i):], w)
+	}
+	return new(big.Int).SetBytes(be)
+}
+
+func newFFromUint32(v uint32) babybear.Variable {
+	return babybear.Variable{Value: frontend.Variable(v), NbBits: 31}
+}
+
+// defineProgram interprets a binary constraint program, storing intermediate values in slices
+// indexed by slot.
+func (circuit *Circuit) defineProgram(api frontend.API, program *ConstraintProgram) error {
+	hashAPI := poseidon2.NewChip(api)
+	hashBabyBearAPI := poseidon2.NewBabyBearChip(api)
+	fieldAPI := babybear.NewChip(api)
+	vars := make([]frontend.Variable, program.NbVars)
+	felts := make([]babybear.Variable, program.NbFelts)
+	exts := make([]babybear.ExtensionVariable, program.NbExts)
+
+	// Inversions are deferred so that independent ones share one hint. Every access to an
+	// extension slot goes through the batch, which flushes the group on a pending result.
+	inversions := newInversionBatch(fieldAPI, func(slot uint32, v babybear.ExtensionVariable) {
+		exts[slot] = v
+	})
+	getE := func(slot uint32) babybear.ExtensionVariable {
+		inversions.touch(slot)
+		return exts[slot]
+	}
+	setE := func(slot uint32, v babybear.ExtensionVariable) {
+		inversions.touch(slot)
+		exts[slot] = v
+	}
+
+	for _, cs := range program.Constraints {
+		a := cs.Args
+		switch cs.Opcode {
+		case OpImmV:
+			vars[a[0][0]] = frontend.Variable(wordsToBigInt(a[1]))
+		case OpImmF:
+			felts[a[0][0]] = newFFromUint32(a[1][0])
+		case OpImmE:
+			setE(a[0][0], babybear.Felts2Ext(newFFromUint32(a[1][0]), newFFromUint32(a[1][1]), newFFromUint32(a[1][2]), newFFromUint32(a[1][3])))
+		case OpAddV:
+			vars[a[0][0]] = api.Add(vars[a[1][0]], vars[a[2][0]])
+		case OpAddF:
+			felts[a[0][0]] = fieldAPI.AddF(felts[a[1][0]], felts[a[2][0]])
+		case OpAddE:
+			setE(a[0][0], fieldAPI.AddE(getE(a[1][0]), getE(a[2][0])))
+		case OpAddEF:
+			setE(a[0][0], fieldAPI.AddEF(getE(a[1][0]), felts[a[2][0]]))
+		case OpSubV:
+			vars[a[0][0]] = api.Sub(vars[a[1][0]], vars[a[2][0]])
+		case OpSubF:
+			felts[a[0][0]] = fieldAPI.SubF(felts[a[1][0]], felts[a[2][0]])
+		case OpSubE:
+			setE(a[0][0], fieldAPI.SubE(getE(a[1][0]), getE(a[2][0])))
+		case OpSubEF:
+			setE(a[0][0], fieldAPI.SubEF(getE(a[1][0]), felts[a[2][0]]))
+		case OpMulV:
+			vars[a[0][0]] = api.Mul(vars[a[1][0]], vars[a[2][0]])
+		case OpMulF:
+			felts[a[0][0]] = fieldAPI.MulF(felts[a[1][0]], felts[a[2][0]])
+		case OpMulE:
+			setE(a[0][0], fieldAPI.MulE(getE(a[1][0]), getE(a[2][0])))
+		case OpMulEF:
+			setE(a[0][0], fieldAPI.MulEF(getE(a[1][0]), felts[a[2][0]]))
+		case OpDivE:
+			inversions.div(a[0][0], getE(a[1][0]), getE(a[2][0]))
+		case OpNegE:
+			setE(a[0][0], fieldAPI.NegE(getE(a[1][0])))
+		case OpInvE:
+			inversions.inv(a[0][0], getE(a[1][0]))
+		case OpNum2BitsV:
+			bits := api.ToBinary(vars[a[1][0]], int(a[2][0]))
+			for i := 0; i < len(a[0]); i++ {
+				vars[a[0][i]] = bits[i]
+			}
+		case OpNum2BitsF:
+			bits := fieldAPI.ToBinary(felts[a[1][0]])
+			for i := 0; i < len(a[0]); i++ {
+				vars[a[0][i]] = bits[i]
+			}
+		case OpPermute:
+			state := [3]frontend.Variable{vars[a[0][0]], vars[a[1][0]], vars[a[2][0]]}
+			hashAPI.PermuteMut(&state)
+			vars[a[0][0]] = state[0]
+			vars[a[1][0]] = state[1]
+			vars[a[2][0]] = state[2]
+		case OpPermuteBabyBear:
+			var state [16]babybear.Variable
+			for i := 0; i < 16; i++ {
+				state[i] = felts[a[i][0]]
+			}
+			hashBabyBearAPI.PermuteMut(&state)
+			for i := 0; i < 16; i++ {
+				felts[a[i][0]] = state[i]
+			}
+		case OpSelectV:
+			vars[a[0][0]] = api.Select(vars[a[1][0]], vars[a[2][0]], vars[a[3][0]])
+		case OpSelectF:
+			felts[a[0][0]] = fieldAPI.SelectF(vars[a[1][0]], felts[a[2][0]], felts[a[3][0]])
+		case OpSelectE:
+			setE(a[0][0], fieldAPI.SelectE(vars[a[1][0]], getE(a[2][0]), getE(a[3][0])))
+		case OpExt2Felt:
+			out := fieldAPI.Ext2Felt(getE(a[4][0]))
+			for i := 0; i < 4; i++ {
+				felts[a[i][0]] = out[i]
+			}
+		case OpAssertEqV:
+			api.AssertIsEqual(vars[a[0][0]], vars[a[1][0]])
+		case OpAssertEqF:
+			fieldAPI.AssertIsEqualF(felts[a[0][0]], felts[a[1][0]])
+		case OpAssertEqE:
+			fieldAPI.AssertIsEqualE(getE(a[0][0]), getE(a[1][0]))
+		case OpPrintV:
+			api.Println(vars[a[0][0]])
+		case OpPrintF:
+			f := felts[a[0][0]]
+			api.Println(f.Value)
+		case OpPrintE:
+			e := getE(a[0][0])
+			api.Println(e.Value[0].Value)
+			api.Println(e.Value[1].Value)
+			api.Println(e.Value[2].Value)
+			api.Println(e.Value[3].Value)
+		case OpWitnessV:
+			vars[a[0][0]] = circuit.Vars[a[1][0]]
+		case OpWitnessF:
+			felts[a[0][0]] = circuit.Felts[a[1][0]]
+		case OpWitnessE:
+			setE(a[0][0], circuit.Exts[a[1][0]])
+		case OpCommitVkeyHash:
+			api.AssertIsEqual(circuit.VkeyHash, vars[a[0][0]])
+		case OpCommitCommitedValuesDigest:
+			api.AssertIsEqual(circuit.CommitedValuesDigest, vars[a[0][0]])
+		case OpCircuitFelts2Ext:
+			setE(a[0][0], babybear.Felts2Ext(felts[a[1][0]], felts[a[2][0]], felts[a[3][0]], felts[a[4][0]]))
+		default:
+			return fmt.Errorf("unhandled opcode: %d", cs.Opcode)
+		}
+	}
+	inversions.flush()
+
+	return nil
+}
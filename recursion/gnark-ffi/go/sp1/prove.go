@@ -2,46 +2,103 @@ package sp1
 
 import (
 	"bufio"
+	"bytes"
 	"encoding/json"
+	"fmt"
+	"math/big"
 	"os"
+	"sync"
+	"time"
 
 	"github.com/consensys/gnark-crypto/ecc"
 	"github.com/consensys/gnark/backend/plonk"
+	plonk_bn254 "github.com/consensys/gnark/backend/plonk/bn254"
+	"github.com/consensys/gnark/constraint"
 	"github.com/consensys/gnark/frontend"
 )
 
-func Prove(dataDir string, witnessPath string) Proof {
+// Prover holds the deserialized circuit artifacts so that they can be reused across proofs.
+type Prover struct {
+	scs constraint.ConstraintSystem
+	pk  plonk.ProvingKey
+	vk  plonk.VerifyingKey
+
+	// Serializes access to the artifacts, which gnark does not guarantee to be safe for concurrent
+	// use by multiple provers.
+	mu sync.Mutex
+}
+
+// NewProver reads the constraint system, proving key and verifying key from the data directory.
+func NewProver(dataDir string) *Prover {
 	// Sanity check the required arguments have been provided.
 	if dataDir == "" {
 		panic("dataDirStr is required")
 	}
-	os.Setenv("CONSTRAINTS_JSON", dataDir+"/"+CONSTRAINTS_JSON_FILE)
+	SetConstraintsEnv(dataDir)
+	defer observeDuration("sp1_gnark_key_load_seconds", time.Now())
 
 	// Read the R1CS.
 	scsFile, err := os.Open(dataDir + "/" + CIRCUIT_PATH)
 	if err != nil {
 		panic(err)
 	}
+	defer scsFile.Close()
 	scs := plonk.NewCS(ecc.BN254)
 	scs.ReadFrom(scsFile)
 
-	// Read the proving key.
-	pkFile, err := os.Open(dataDir + "/" + PK_PATH)
-	if err != nil {
-		panic(err)
+	// Read the proving key, preferring the memory dump written by Build if it is present.
+	pk := readProvingKeyDump(dataDir + "/" + PK_DUMP_PATH)
+	if pk == nil {
+		pkFile, err := os.Open(dataDir + "/" + PK_PATH)
+		if err != nil {
+			panic(err)
+		}
+		defer pkFile.Close()
+		pk = plonk.NewProvingKey(ecc.BN254)
+		bufReader := bufio.NewReaderSize(pkFile, 1024*1024)
+		pk.UnsafeReadFrom(bufReader)
 	}
-	pk := plonk.NewProvingKey(ecc.BN254)
-	bufReader := bufio.NewReaderSize(pkFile, 1024*1024)
-	pk.UnsafeReadFrom(bufReader)
 
 	// Read the verifier key.
 	vkFile, err := os.Open(dataDir + "/" + VK_PATH)
 	if err != nil {
 		panic(err)
 	}
+	defer vkFile.Close()
 	vk := plonk.NewVerifyingKey(ecc.BN254)
 	vk.ReadFrom(vkFile)
 
+	return &Prover{scs: scs, pk: pk, vk: vk}
+}
+
+// VerifyMode selects how a proof is checked against the verifying key after it is generated.
+type VerifyMode int
+
+const (
+	// VerifyOff returns the proof without verifying it.
+	VerifyOff VerifyMode = iota
+	// VerifySync verifies the proof before returning it and panics if it does not verify.
+	VerifySync
+	// VerifyAsync returns the proof immediately and verifies it in the background. The result is
+	// reported through the returned Verification.
+	VerifyAsync
+)
+
+// Verification is the result of a self-verification running in the background.
+type Verification struct {
+	done chan struct{}
+	err  error
+}
+
+// Wait blocks until the verification has finished and returns its error, if any.
+func (v *Verification) Wait() error {
+	<-v.done
+	return v.err
+}
+
+// Prove generates a proof for the JSON witness at the given path using the resident artifacts.
+// The returned Verification is only set in VerifyAsync mode.
+func (p *Prover) Prove(witnessPath string, mode VerifyMode) (Proof, *Verification) {
 	// Read the file.
 	data, err := os.ReadFile(witnessPath)
 	if err != nil {
@@ -55,9 +112,29 @@ func Prove(dataDir string, witnessPath string) Proof {
 		panic(err)
 	}
 
-	// Generate the witness.
 	assignment := NewCircuit(witnessInput)
-	witness, err := frontend.NewWitness(&assignment, ecc.BN254.ScalarField())
+	return p.prove(&assignment, witnessInput.VkeyHash, witnessInput.CommitedValuesDigest, mode)
+}
+
+// ProveBinary generates a proof for a witness in the binary layout decoded by DecodeBinaryWitness.
+// The returned Verification is only set in VerifyAsync mode.
+func (p *Prover) ProveBinary(data []byte, mode VerifyMode) (Proof, *Verification) {
+	decodeStart := time.Now()
+	assignment, err := DecodeBinaryWitness(data)
+	if err != nil {
+		panic(err)
+	}
+	observeDuration("sp1_gnark_witness_decode_seconds", decodeStart)
+
+	vkeyHash := assignment.VkeyHash.(*big.Int).String()
+	commitedValuesDigest := assignment.CommitedValuesDigest.(*big.Int).String()
+	return p.prove(&assignment, vkeyHash, commitedValuesDigest, mode)
+}
+
+func (p *Prover) prove(assignment *Circuit, vkeyHash string, commitedValuesDigest string, mode VerifyMode) (Proof, *Verification) {
+	// Generate the witness.
+	witnessStart := time.Now()
+	witness, err := frontend.NewWitness(assignment, ecc.BN254.ScalarField())
 	if err != nil {
 		panic(err)
 	}
@@ -66,17 +143,67 @@ func Prove(dataDir string, witnessPath string) Proof {
 		panic(err)
 	}
 
-	// Generate the proof.
-	proof, err := plonk.Prove(scs, pk, witness)
+	observeDuration("sp1_gnark_witness_seconds", witnessStart)
+
+	// Generate the proof, which solves the constraint system for the witness first.
+	p.mu.Lock()
+	proveStart := time.Now()
+	proof, err := plonk.Prove(p.scs, p.pk, witness)
+	observeDuration("sp1_gnark_prove_seconds", proveStart)
+	p.mu.Unlock()
 	if err != nil {
 		panic(err)
 	}
 
-	// Verify proof.
-	err = plonk.Verify(proof, vk, publicWitness)
+	// Verify proof. Verification only reads the verifying key, so it does not need to hold the
+	// lock and can overlap with the next proof.
+	var verification *Verification
+	switch mode {
+	case VerifyOff:
+	case VerifySync:
+		verifyStart := time.Now()
+		err = plonk.Verify(proof, p.vk, publicWitness)
+		observeDuration("sp1_gnark_verify_seconds", verifyStart)
+		if err != nil {
+			panic(err)
+		}
+	case VerifyAsync:
+		verification = &Verification{done: make(chan struct{})}
+		go func() {
+			defer close(verification.done)
+			defer observeDuration("sp1_gnark_verify_seconds", time.Now())
+			verification.err = plonk.Verify(proof, p.vk, publicWitness)
+		}()
+	default:
+		panic(fmt.Sprintf("unknown verify mode %d", mode))
+	}
+
+	return NewSP1PlonkBn254Proof(&proof, vkeyHash, commitedValuesDigest), verification
+}
+
+// Prove loads the circuit artifacts from the data directory and generates a single, verified
+// proof.
+func Prove(dataDir string, witnessPath string) Proof {
+	proof, _ := NewProver(dataDir).Prove(witnessPath, VerifySync)
+	return proof
+}
+
+// readProvingKeyDump maps the proving key dump at path read-only and decodes it directly from the
+// mapped pages. Returns nil if the dump does not exist.
+func readProvingKeyDump(path string) plonk.ProvingKey {
+	if _, err := os.Stat(path); os.IsNotExist(err) {
+		return nil
+	}
+
+	data, unmap, err := mmapFile(path)
 	if err != nil {
 		panic(err)
 	}
+	defer unmap()
 
-	return NewSP1PlonkBn254Proof(&proof, witnessInput)
+	pk := &plonk_bn254.ProvingKey{}
+	if err := pk.ReadDump(bytes.NewReader(data)); err != nil {
+		panic(err)
+	}
+	return pk
 }
@@ -12,13 +12,15 @@ import (
 )
 
 var SRS_FILE string = "srs.bin"
-var SRS_LAGRANGE_FILE string = "srs_lagrange.bin"
+var SRS_LAGRANGE_FILE_PREFIX string = "srs_lagrange"
 var CONSTRAINTS_JSON_FILE string = "constraints.json"
+var CONSTRAINTS_BIN_FILE string = "constraints.bin"
 var WITNESS_JSON_FILE string = "witness.json"
 var VERIFIER_CONTRACT_PATH string = "PlonkVerifier.sol"
 var CIRCUIT_PATH string = "circuit.bin"
 var VK_PATH string = "vk.bin"
 var PK_PATH string = "pk.bin"
+var PK_DUMP_PATH string = "pk.dump"
 
 type Circuit struct {
 	VkeyHash             frontend.Variable `gnark:",public"`
@@ -47,7 +49,32 @@ type Proof struct {
 	RawProof     string    `json:"raw_proof"`
 }
 
+// SetConstraintsEnv points Define at the constraint system in the data directory, preferring the
+// binary constraint program if it is present.
+func SetConstraintsEnv(dataDir string) {
+	os.Setenv("CONSTRAINTS_JSON", dataDir+"/"+CONSTRAINTS_JSON_FILE)
+	binPath := dataDir + "/" + CONSTRAINTS_BIN_FILE
+	if _, err := os.Stat(binPath); err == nil {
+		os.Setenv("CONSTRAINTS_BIN", binPath)
+	} else {
+		os.Unsetenv("CONSTRAINTS_BIN")
+	}
+}
+
 func (circuit *Circuit) Define(api frontend.API) error {
+	// Prefer the binary constraint program if one was provided.
+	if binFileName := os.Getenv("CONSTRAINTS_BIN"); binFileName != "" {
+		data, err := os.ReadFile(binFileName)
+		if err != nil {
+			return fmt.Errorf("failed to read file: %w", err)
+		}
+		program, err := DecodeConstraintProgram(data)
+		if err != nil {
+			return fmt.Errorf("error decoding constraint program: %v", err)
+		}
+		return circuit.defineProgram(api, program)
+	}
+
 	// Get the file name from an environment variable.
 	fileName := os.Getenv("CONSTRAINTS_JSON")
 	if fileName == "" {
@@ -74,6 +101,20 @@ func (circuit *Circuit) Define(api frontend.API) error {
 	felts := make(map[string]babybear.Variable)
 	exts := make(map[string]babybear.ExtensionVariable)
 
+	// Inversions are deferred so that independent ones share one hint. Every access to an
+	// extension slot goes through the batch, which flushes the group on a pending result.
+	inversions := newInversionBatch(fieldAPI, func(slot string, v babybear.ExtensionVariable) {
+		exts[slot] = v
+	})
+	getE := func(slot string) babybear.ExtensionVariable {
+		inversions.touch(slot)
+		return exts[slot]
+	}
+	setE := func(slot string, v babybear.ExtensionVariable) {
+		inversions.touch(slot)
+		exts[slot] = v
+	}
+
 	// Iterate through the instructions and handle each opcode.
 	for _, cs := range constraints {
 		switch cs.Opcode {
@@ -82,37 +123,37 @@ func (circuit *Circuit) Define(api frontend.API) error {
 		case "ImmF":
 			felts[cs.Args[0][0]] = babybear.NewF(cs.Args[1][0])
 		case "ImmE":
-			exts[cs.Args[0][0]] = babybear.NewE(cs.Args[1])
+			setE(cs.Args[0][0], babybear.NewE(cs.Args[1]))
 		case "AddV":
 			vars[cs.Args[0][0]] = api.Add(vars[cs.Args[1][0]], vars[cs.Args[2][0]])
 		case "AddF":
 			felts[cs.Args[0][0]] = fieldAPI.AddF(felts[cs.Args[1][0]], felts[cs.Args[2][0]])
 		case "AddE":
-			exts[cs.Args[0][0]] = fieldAPI.AddE(exts[cs.Args[1][0]], exts[cs.Args[2][0]])
+			setE(cs.Args[0][0], fieldAPI.AddE(getE(cs.Args[1][0]), getE(cs.Args[2][0])))
 		case "AddEF":
-			exts[cs.Args[0][0]] = fieldAPI.AddEF(exts[cs.Args[1][0]], felts[cs.Args[2][0]])
+			setE(cs.Args[0][0], fieldAPI.AddEF(getE(cs.Args[1][0]), felts[cs.Args[2][0]]))
 		case "SubV":
 			vars[cs.Args[0][0]] = api.Sub(vars[cs.Args[1][0]], vars[cs.Args[2][0]])
 		case "SubF":
 			felts[cs.Args[0][0]] = fieldAPI.SubF(felts[cs.Args[1][0]], felts[cs.Args[2][0]])
 		case "SubE":
-			exts[cs.Args[0][0]] = fieldAPI.SubE(exts[cs.Args[1][0]], exts[cs.Args[2][0]])
+			setE(cs.Args[0][0], fieldAPI.SubE(getE(cs.Args[1][0]), getE(cs.Args[2][0])))
 		case "SubEF":
-			exts[cs.Args[0][0]] = fieldAPI.SubEF(exts[cs.Args[1][0]], felts[cs.Args[2][0]])
+			setE(cs.Args[0][0], fieldAPI.SubEF(getE(cs.Args[1][0]), felts[cs.Args[2][0]]))
 		case "MulV":
 			vars[cs.Args[0][0]] = api.Mul(vars[cs.Args[1][0]], vars[cs.Args[2][0]])
 		case "MulF":
 			felts[cs.Args[0][0]] = fieldAPI.MulF(felts[cs.Args[1][0]], felts[cs.Args[2][0]])
 		case "MulE":
-			exts[cs.Args[0][0]] = fieldAPI.MulE(exts[cs.Args[1][0]], exts[cs.Args[2][0]])
+			setE(cs.Args[0][0], fieldAPI.MulE(getE(cs.Args[1][0]), getE(cs.Args[2][0])))
 		case "MulEF":
-			exts[cs.Args[0][0]] = fieldAPI.MulEF(exts[cs.Args[1][0]], felts[cs.Args[2][0]])
+			setE(cs.Args[0][0], fieldAPI.MulEF(getE(cs.Args[1][0]), felts[cs.Args[2][0]]))
 		case "DivE":
-			exts[cs.Args[0][0]] = fieldAPI.DivE(exts[cs.Args[1][0]], exts[cs.Args[2][0]])
+			inversions.div(cs.Args[0][0], getE(cs.Args[1][0]), getE(cs.Args[2][0]))
 		case "NegE":
-			exts[cs.Args[0][0]] = fieldAPI.NegE(exts[cs.Args[1][0]])
+			setE(cs.Args[0][0], fieldAPI.NegE(getE(cs.Args[1][0])))
 		case "InvE":
-			exts[cs.Args[0][0]] = fieldAPI.InvE(exts[cs.Args[1][0]])
+			inversions.inv(cs.Args[0][0], getE(cs.Args[1][0]))
 		case "Num2BitsV":
 			numBits, err := strconv.Atoi(cs.Args[2][0])
 			if err != nil {
@@ -147,9 +188,9 @@ func (circuit *Circuit) Define(api frontend.API) error {
 		case "SelectF":
 			felts[cs.Args[0][0]] = fieldAPI.SelectF(vars[cs.Args[1][0]], felts[cs.Args[2][0]], felts[cs.Args[3][0]])
 		case "SelectE":
-			exts[cs.Args[0][0]] = fieldAPI.SelectE(vars[cs.Args[1][0]], exts[cs.Args[2][0]], exts[cs.Args[3][0]])
+			setE(cs.Args[0][0], fieldAPI.SelectE(vars[cs.Args[1][0]], getE(cs.Args[2][0]), getE(cs.Args[3][0])))
 		case "Ext2Felt":
-			out := fieldAPI.Ext2Felt(exts[cs.Args[4][0]])
+			out := fieldAPI.Ext2Felt(getE(cs.Args[4][0]))
 			for i := 0; i < 4; i++ {
 				felts[cs.Args[i][0]] = out[i]
 			}
@@ -158,14 +199,14 @@ func (circuit *Circuit) Define(api frontend.API) error {
 		case "AssertEqF":
 			fieldAPI.AssertIsEqualF(felts[cs.Args[0][0]], felts[cs.Args[1][0]])
 		case "AssertEqE":
-			fieldAPI.AssertIsEqualE(exts[cs.Args[0][0]], exts[cs.Args[1][0]])
+			fieldAPI.AssertIsEqualE(getE(cs.Args[0][0]), getE(cs.Args[1][0]))
 		case "PrintV":
 			api.Println(vars[cs.Args[0][0]])
 		case "PrintF":
 			f := felts[cs.Args[0][0]]
 			api.Println(f.Value)
 		case "PrintE":
-			e := exts[cs.Args[0][0]]
+			e := getE(cs.Args[0][0])
 			api.Println(e.Value[0].Value)
 			api.Println(e.Value[1].Value)
 			api.Println(e.Value[2].Value)
@@ -187,7 +228,7 @@ func (circuit *Circuit) Define(api frontend.API) error {
 			if err != nil {
 				panic(err)
 			}
-			exts[cs.Args[0][0]] = circuit.Exts[i]
+			setE(cs.Args[0][0], circuit.Exts[i])
 		case "CommitVkeyHash":
 			element := vars[cs.Args[0][0]]
 			api.AssertIsEqual(circuit.VkeyHash, element)
@@ -195,11 +236,12 @@ func (circuit *Circuit) Define(api frontend.API) error {
 			element := vars[cs.Args[0][0]]
 			api.AssertIsEqual(circuit.CommitedValuesDigest, element)
 		case "CircuitFelts2Ext":
-			exts[cs.Args[0][0]] = babybear.Felts2Ext(felts[cs.Args[1][0]], felts[cs.Args[2][0]], felts[cs.Args[3][0]], felts[cs.Args[4][0]])
+			setE(cs.Args[0][0], babybear.Felts2Ext(felts[cs.Args[1][0]], felts[cs.Args[2][0]], felts[cs.Args[3][0]], felts[cs.Args[4][0]]))
 		default:
 			return fmt.Errorf("unhandled opcode: %s", cs.Opcode)
 		}
 	}
+	inversions.flush()
 
 	return nil
 }
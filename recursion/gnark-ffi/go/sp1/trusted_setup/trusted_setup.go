@@ -148,14 +148,20 @@ func DownloadAndSaveAztecIgnitionSrs(startIdx int, fileName string) {
 	}
 }
 
+// LagrangeSize returns the number of points of the Lagrange SRS that ToLagrange derives for the
+// constraint system.
+func LagrangeSize(scs constraint.ConstraintSystem) int {
+	sizeSystem := scs.GetNbPublicVariables() + scs.GetNbConstraints()
+	return 1 << stdbits.Len(uint(sizeSystem))
+}
+
 func ToLagrange(scs constraint.ConstraintSystem, canonicalSRS kzg.SRS) kzg.SRS {
 	var lagrangeSRS kzg.SRS
 
 	switch srs := canonicalSRS.(type) {
 	case *kzg_bn254.SRS:
 		var err error
-		sizeSystem := scs.GetNbPublicVariables() + scs.GetNbConstraints()
-		nextPowerTwo := 1 << stdbits.Len(uint(sizeSystem))
+		nextPowerTwo := LagrangeSize(scs)
 		newSRS := &kzg_bn254.SRS{Vk: srs.Vk}
 		newSRS.Pk.G1, err = kzg_bn254.ToLagrangeG1(srs.Pk.G1[:nextPowerTwo])
 		if err != nil {
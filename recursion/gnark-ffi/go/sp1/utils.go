@@ -10,14 +10,14 @@ import (
 	"github.com/succinctlabs/sp1-recursion-gnark/sp1/babybear"
 )
 
-func NewSP1PlonkBn254Proof(proof *plonk.Proof, witnessInput WitnessInput) Proof {
+func NewSP1PlonkBn254Proof(proof *plonk.Proof, vkeyHash string, commitedValuesDigest string) Proof {
 	var buf bytes.Buffer
 	(*proof).WriteRawTo(&buf)
 	proofBytes := buf.Bytes()
 
 	var publicInputs [2]string
-	publicInputs[0] = witnessInput.VkeyHash
-	publicInputs[1] = witnessInput.CommitedValuesDigest
+	publicInputs[0] = vkeyHash
+	publicInputs[1] = commitedValuesDigest
 
 	// Cast plonk proof into plonk_bn254 proof so we can call MarshalSolidity.
 	p := (*proof).(*plonk_bn254.Proof)
@@ -3,7 +3,12 @@ package sp1
 import (
 	"bytes"
 	"encoding/hex"
+	"fmt"
 	"os"
+	"runtime"
+	"sync"
+	"sync/atomic"
+	"time"
 
 	"github.com/consensys/gnark-crypto/ecc"
 	"github.com/consensys/gnark/backend/plonk"
@@ -11,48 +16,125 @@ import (
 	"github.com/succinctlabs/sp1-recursion-gnark/sp1/babybear"
 )
 
+// residentVerifyingKey is a verifying key read from a data directory, along with the state of the
+// file it was read from.
+type residentVerifyingKey struct {
+	vk      plonk.VerifyingKey
+	size    int64
+	modTime time.Time
+}
+
+// verifyingKeys holds the verifying keys read by Verify and VerifyBatch, keyed by data directory,
+// so that they are read from disk once instead of for every proof.
+var verifyingKeys sync.Map
+
+// loadVerifyingKey returns the verifying key of the data directory, reading it again if the file
+// changed since it was last read.
+func loadVerifyingKey(dataDir string) (plonk.VerifyingKey, error) {
+	path := dataDir + "/" + VK_PATH
+	info, err := os.Stat(path)
+	if err != nil {
+		return nil, err
+	}
+	if cached, ok := verifyingKeys.Load(dataDir); ok {
+		resident := cached.(*residentVerifyingKey)
+		if resident.size == info.Size() && resident.modTime.Equal(info.ModTime()) {
+			return resident.vk, nil
+		}
+	}
+
+	vkFile, err := os.Open(path)
+	if err != nil {
+		return nil, err
+	}
+	defer vkFile.Close()
+	vk := plonk.NewVerifyingKey(ecc.BN254)
+	if _, err := vk.ReadFrom(vkFile); err != nil {
+		return nil, fmt.Errorf("failed to read verifying key: %w", err)
+	}
+	verifyingKeys.Store(dataDir, &residentVerifyingKey{vk: vk, size: info.Size(), modTime: info.ModTime()})
+	return vk, nil
+}
+
 func Verify(verifyCmdDataDir string, verifyCmdProof string, verifyCmdVkeyHash string, verifyCmdCommitedValuesDigest string) error {
 	// Sanity check the required arguments have been provided.
 	if verifyCmdDataDir == "" {
 		panic("--data is required")
 	}
 
-	// Decode the proof.
-	proofDecodedBytes, err := hex.DecodeString(verifyCmdProof)
+	vk, err := loadVerifyingKey(verifyCmdDataDir)
 	if err != nil {
 		panic(err)
 	}
-	proof := plonk.NewProof(ecc.BN254)
-	if _, err := proof.ReadFrom(bytes.NewReader(proofDecodedBytes)); err != nil {
-		panic(err)
+	return verifyProof(vk, verifyCmdProof, verifyCmdVkeyHash, verifyCmdCommitedValuesDigest)
+}
+
+// VerifyBatch verifies the proofs against the verifying key of the data directory on all CPUs. It
+// returns the error of each proof, which is nil if the proof verified.
+func VerifyBatch(dataDir string, proofs []string, vkeyHashes []string, commitedValuesDigests []string) []error {
+	if len(vkeyHashes) != len(proofs) || len(commitedValuesDigests) != len(proofs) {
+		panic("every proof needs a vkey hash and a committed values digest")
 	}
 
-	// Read the verifier key.
-	vkFile, err := os.Open(verifyCmdDataDir + "/" + VK_PATH)
+	errs := make([]error, len(proofs))
+	vk, err := loadVerifyingKey(dataDir)
 	if err != nil {
-		panic(err)
+		for i := range errs {
+			errs[i] = err
+		}
+		return errs
+	}
+
+	var next atomic.Int64
+	var wg sync.WaitGroup
+	for w := 0; w < min(runtime.NumCPU(), len(proofs)); w++ {
+		wg.Add(1)
+		go func() {
+			defer wg.Done()
+			for {
+				i := int(next.Add(1) - 1)
+				if i >= len(proofs) {
+					return
+				}
+				errs[i] = verifyProof(vk, proofs[i], vkeyHashes[i], commitedValuesDigests[i])
+			}
+		}()
+	}
+	wg.Wait()
+	return errs
+}
+
+// verifyProof verifies a hex-encoded proof with the given public inputs.
+func verifyProof(vk plonk.VerifyingKey, proofHex string, vkeyHash string, commitedValuesDigest string) error {
+	defer observeDuration("sp1_gnark_verify_seconds", time.Now())
+
+	// Decode the proof.
+	proofDecodedBytes, err := hex.DecodeString(proofHex)
+	if err != nil {
+		return fmt.Errorf("failed to decode proof: %w", err)
+	}
+	proof := plonk.NewProof(ecc.BN254)
+	if _, err := proof.ReadFrom(bytes.NewReader(proofDecodedBytes)); err != nil {
+		return fmt.Errorf("failed to read proof: %w", err)
 	}
-	vk := plonk.NewVerifyingKey(ecc.BN254)
-	vk.ReadFrom(vkFile)
 
 	// Compute the public witness.
 	circuit := Circuit{
 		Vars:                 []frontend.Variable{},
 		Felts:                []babybear.Variable{},
 		Exts:                 []babybear.ExtensionVariable{},
-		VkeyHash:             verifyCmdVkeyHash,
-		CommitedValuesDigest: verifyCmdCommitedValuesDigest,
+		VkeyHash:             vkeyHash,
+		CommitedValuesDigest: commitedValuesDigest,
 	}
 	witness, err := frontend.NewWitness(&circuit, ecc.BN254.ScalarField())
 	if err != nil {
-		panic(err)
+		return err
 	}
 	publicWitness, err := witness.Public()
 	if err != nil {
-		panic(err)
+		return err
 	}
 
 	// Verify proof.
-	err = plonk.Verify(proof, vk, publicWitness)
-	return err
+	return plonk.Verify(proof, vk, publicWitness)
 }
@@ -0,0 +1,132 @@
+package sp1
+
+import (
+	"bytes"
+	"encoding/hex"
+	"os"
+	"testing"
+	"time"
+
+	"github.com/consensys/gnark-crypto/ecc"
+	"github.com/consensys/gnark/backend/plonk"
+	"github.com/consensys/gnark/constraint"
+	"github.com/consensys/gnark/frontend"
+	"github.com/consensys/gnark/frontend/cs/scs"
+	"github.com/consensys/gnark/test/unsafekzg"
+)
+
+// commitConstraints returns a constraint system that commits to the given vkey hash and committed
+// values digest, which is enough to fix the public inputs of the circuit.
+func commitConstraints(vkeyHash string, commitedValuesDigest string) string {
+	return `[
+		{"opcode": "ImmV", "args": [["hash"], ["` + vkeyHash + `"]]},
+		{"opcode": "ImmV", "args": [["digest"], ["` + commitedValuesDigest + `"]]},
+		{"opcode": "CommitVkeyHash", "args": [["hash"]]},
+		{"opcode": "CommitCommitedValuesDigest", "args": [["digest"]]}
+	]`
+}
+
+// setupTestCircuit compiles the constraints in the data directory and writes the verifying key to
+// vk.bin, as Build does for the real circuit.
+func setupTestCircuit(t *testing.T, dataDir string, constraints string) (constraint.ConstraintSystem, plonk.ProvingKey) {
+	if err := os.WriteFile(dataDir+"/"+CONSTRAINTS_JSON_FILE, []byte(constraints), 0644); err != nil {
+		t.Fatal(err)
+	}
+	SetConstraintsEnv(dataDir)
+
+	circuit := Circuit{}
+	ccs, err := frontend.Compile(ecc.BN254.ScalarField(), scs.NewBuilder, &circuit)
+	if err != nil {
+		t.Fatal(err)
+	}
+	srs, srsLagrange, err := unsafekzg.NewSRS(ccs)
+	if err != nil {
+		t.Fatal(err)
+	}
+	pk, vk, err := plonk.Setup(ccs, srs, srsLagrange)
+	if err != nil {
+		t.Fatal(err)
+	}
+
+	vkFile, err := os.Create(dataDir + "/" + VK_PATH)
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer vkFile.Close()
+	if _, err := vk.WriteTo(vkFile); err != nil {
+		t.Fatal(err)
+	}
+	return ccs, pk
+}
+
+// proveTestCircuit returns the hex-encoded proof of the circuit for the given public inputs.
+func proveTestCircuit(t *testing.T, ccs constraint.ConstraintSystem, pk plonk.ProvingKey, vkeyHash string, commitedValuesDigest string) string {
+	assignment := Circuit{VkeyHash: vkeyHash, CommitedValuesDigest: commitedValuesDigest}
+	witness, err := frontend.NewWitness(&assignment, ecc.BN254.ScalarField())
+	if err != nil {
+		t.Fatal(err)
+	}
+	proof, err := plonk.Prove(ccs, pk, witness)
+	if err != nil {
+		t.Fatal(err)
+	}
+	var buf bytes.Buffer
+	if _, err := proof.WriteTo(&buf); err != nil {
+		t.Fatal(err)
+	}
+	return hex.EncodeToString(buf.Bytes())
+}
+
+func TestVerifyBatch(t *testing.T) {
+	dataDir := t.TempDir()
+	ccs, pk := setupTestCircuit(t, dataDir, commitConstraints("1", "2"))
+	proof := proveTestCircuit(t, ccs, pk, "1", "2")
+
+	// The second proof is checked against public inputs it was not proven for.
+	proofs := []string{proof, proof, proof}
+	vkeyHashes := []string{"1", "3", "1"}
+	digests := []string{"2", "2", "2"}
+	errs := VerifyBatch(dataDir, proofs, vkeyHashes, digests)
+	for i, err := range errs {
+		if (err != nil) != (i == 1) {
+			t.Errorf("proof %d: unexpected verification result %v", i, err)
+		}
+	}
+}
+
+func TestLoadVerifyingKeyReloadsChangedFile(t *testing.T) {
+	dataDir := t.TempDir()
+	ccs, pk := setupTestCircuit(t, dataDir, commitConstraints("1", "2"))
+	proof := proveTestCircuit(t, ccs, pk, "1", "2")
+
+	vk, err := loadVerifyingKey(dataDir)
+	if err != nil {
+		t.Fatal(err)
+	}
+	cached, err := loadVerifyingKey(dataDir)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if cached != vk {
+		t.Fatal("the verifying key was read again although vk.bin did not change")
+	}
+
+	// Replace vk.bin with the key of another circuit. The modification time is moved forward in
+	// case the file system does not tell the two writes apart.
+	setupTestCircuit(t, dataDir, commitConstraints("3", "2"))
+	later := time.Now().Add(time.Minute)
+	if err := os.Chtimes(dataDir+"/"+VK_PATH, later, later); err != nil {
+		t.Fatal(err)
+	}
+
+	reloaded, err := loadVerifyingKey(dataDir)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if reloaded == vk {
+		t.Fatal("the verifying key was not read again after vk.bin changed")
+	}
+	if errs := VerifyBatch(dataDir, []string{proof}, []string{"1"}, []string{"2"}); errs[0] == nil {
+		t.Fatal("the proof verified against the replaced verifying key")
+	}
+}
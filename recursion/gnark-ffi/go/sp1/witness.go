@@ -0,0 +1,122 @@
+package sp1
+
+import (
+	"encoding/binary"
+	"fmt"
+	"math/big"
+
+	"github.com/consensys/gnark/frontend"
+	"github.com/succinctlabs/sp1-recursion-gnark/sp1/babybear"
+)
+
+// The binary witness layout produced by `GnarkWitness::encode_binary` on the Rust side. All
+// integers are little-endian:
+//
+//	u32 nbVars | u32 nbFelts | u32 nbExts
+//	nbVars * 32-byte BN254 elements
+//	nbFelts * u32 BabyBear elements
+//	nbExts * 4 * u32 BabyBear elements
+//	32-byte vkey hash | 32-byte commited values digest
+const bn254ElementSize = 32
+
+type binaryWitnessReader struct {
+	data   []byte
+	offset int
+}
+
+func (r *binaryWitnessReader) take(n int) ([]byte, error) {
+	if n < 0 || len(r.data)-r.offset < n {
+		return nil, fmt.Errorf("binary witness truncated at offset %d", r.offset)
+	}
+	b := r.data[r.offset : r.offset+n]
+	r.offset += n
+	return b, nil
+}
+
+func (r *binaryWitnessReader) u32() (uint32, error) {
+	b, err := r.take(4)
+	if err != nil {
+		return 0, err
+	}
+	return binary.LittleEndian.Uint32(b), nil
+}
+
+func (r *binaryWitnessReader) bn254() (*big.Int, error) {
+	b, err := r.take(bn254ElementSize)
+	if err != nil {
+		return nil, err
+	}
+	var be [bn254ElementSize]byte
+	for i := range b {
+		be[bn254ElementSize-1-i] = b[i]
+	}
+	return new(big.Int).SetBytes(be[:]), nil
+}
+
+func (r *binaryWitnessReader) felt() (babybear.Variable, error) {
+	v, err := r.u32()
+	if err != nil {
+		return babybear.Variable{}, err
+	}
+	return babybear.Variable{Value: frontend.Variable(v), NbBits: 31}, nil
+}
+
+// DecodeBinaryWitness builds a circuit assignment directly from a binary witness, without going
+// through decimal strings.
+func DecodeBinaryWitness(data []byte) (Circuit, error) {
+	r := &binaryWitnessReader{data: data}
+
+	nbVars, err := r.u32()
+	if err != nil {
+		return Circuit{}, err
+	}
+	nbFelts, err := r.u32()
+	if err != nil {
+		return Circuit{}, err
+	}
+	nbExts, err := r.u32()
+	if err != nil {
+		return Circuit{}, err
+	}
+	expected := 12 + int(nbVars)*bn254ElementSize + int(nbFelts)*4 + int(nbExts)*16 + 2*bn254ElementSize
+	if len(data) != expected {
+		return Circuit{}, fmt.Errorf("binary witness has %d bytes, expected %d", len(data), expected)
+	}
+
+	vars := make([]frontend.Variable, nbVars)
+	for i := range vars {
+		if vars[i], err = r.bn254(); err != nil {
+			return Circuit{}, err
+		}
+	}
+	felts := make([]babybear.Variable, nbFelts)
+	for i := range felts {
+		if felts[i], err = r.felt(); err != nil {
+			return Circuit{}, err
+		}
+	}
+	exts := make([]babybear.ExtensionVariable, nbExts)
+	for i := range exts {
+		for j := 0; j < 4; j++ {
+			if exts[i].Value[j], err = r.felt(); err != nil {
+				return Circuit{}, err
+			}
+		}
+	}
+	vkeyHash, err := r.bn254()
+	if err != nil {
+		return Circuit{}, err
+	}
+	commitedValuesDigest, err := r.bn254()
+	if err != nil {
+		return Circuit{}, err
+	}
+
+	return Circuit{
+		VkeyHash:             vkeyHash,
+		CommitedValuesDigest: commitedValuesDigest,
+		Vars:                 vars,
+		Felts:                felts,
+		Exts:                 exts,
+	}, nil
+}
@@ -0,0 +1,93 @@
+package sp1
+
+import (
+	"encoding/json"
+	"fmt"
+	"math/big"
+	"os"
+	"testing"
+
+	"github.com/consensys/gnark/frontend"
+	"github.com/succinctlabs/sp1-recursion-gnark/sp1/babybear"
+)
+
+// The fixtures are the same witness encoded by `GnarkWitness::encode_binary` and
+// `GnarkWitness::save` on the Rust side, which checks that they are up to date.
+const (
+	binaryWitnessFixture = "testdata/binary_witness.bin"
+	jsonWitnessFixture   = "testdata/json_witness.json"
+)
+
+func variableToBig(t *testing.T, v frontend.Variable) *big.Int {
+	switch v := v.(type) {
+	case string:
+		n, ok := new(big.Int).SetString(v, 10)
+		if !ok {
+			t.Fatalf("invalid decimal witness value %q", v)
+		}
+		return n
+	case *big.Int:
+		return v
+	case uint32:
+		return new(big.Int).SetUint64(uint64(v))
+	default:
+		t.Fatalf("unexpected witness value type %T", v)
+		return nil
+	}
+}
+
+func assertVariableEqual(t *testing.T, name string, got, want frontend.Variable) {
+	if variableToBig(t, got).Cmp(variableToBig(t, want)) != 0 {
+		t.Errorf("%s: got %v, want %v", name, got, want)
+	}
+}
+
+func assertFeltEqual(t *testing.T, name string, got, want babybear.Variable) {
+	assertVariableEqual(t, name, got.Value, want.Value)
+	if got.NbBits != want.NbBits {
+		t.Errorf("%s: got %d bits, want %d", name, got.NbBits, want.NbBits)
+	}
+}
+
+func TestDecodeBinaryWitness(t *testing.T) {
+	data, err := os.ReadFile(binaryWitnessFixture)
+	if err != nil {
+		t.Fatal(err)
+	}
+	got, err := DecodeBinaryWitness(data)
+	if err != nil {
+		t.Fatal(err)
+	}
+
+	jsonData, err := os.ReadFile(jsonWitnessFixture)
+	if err != nil {
+		t.Fatal(err)
+	}
+	var witnessInput WitnessInput
+	if err := json.Unmarshal(jsonData, &witnessInput); err != nil {
+		t.Fatal(err)
+	}
+	want := NewCircuit(witnessInput)
+
+	assertVariableEqual(t, "vkey hash", got.VkeyHash, want.VkeyHash)
+	assertVariableEqual(t, "commited values digest", got.CommitedValuesDigest, want.CommitedValuesDigest)
+	if len(got.Vars) != len(want.Vars) || len(got.Felts) != len(want.Felts) || len(got.Exts) != len(want.Exts) {
+		t.Fatalf("got %d vars, %d felts, %d exts, want %d, %d, %d",
+			len(got.Vars), len(got.Felts), len(got.Exts), len(want.Vars), len(want.Felts), len(want.Exts))
+	}
+	for i := range want.Vars {
+		assertVariableEqual(t, fmt.Sprintf("var %d", i), got.Vars[i], want.Vars[i])
+	}
+	for i := range want.Felts {
+		assertFeltEqual(t, fmt.Sprintf("felt %d", i), got.Felts[i], want.Felts[i])
+	}
+	for i := range want.Exts {
+		for j := 0; j < 4; j++ {
+			assertFeltEqual(t, fmt.Sprintf("ext %d.%d", i, j), got.Exts[i].Value[j], want.Exts[i].Value[j])
+		}
+	}
+
+	if _, err := DecodeBinaryWitness(data[:len(data)-1]); err == nil {
+		t.Error("decoding a truncated witness should fail")
+	}
+}
@@ -1,6 +1,11 @@
 use p3_baby_bear::BabyBear;
 use p3_field::PrimeField32;
-use p3_field::{extension::BinomialExtensionField, AbstractExtensionField, AbstractField, Field};
+use p3_field::{
+    batch_multiplicative_inverse, extension::BinomialExtensionField, AbstractExtensionField,
+    AbstractField, Field,
+};
+
+type EF = BinomialExtensionField<BabyBear, 4>;
 
 #[no_mangle]
 pub extern "C" fn babybearextinv(a: u32, b: u32, c: u32, d: u32, i: u32) -> u32 {
@@ -8,7 +13,7 @@ pub extern "C" fn babybearextinv(a: u32, b: u32, c: u32, d: u32, i: u32) -> u32
     let b = BabyBear::from_wrapped_u32(b);
     let c = BabyBear::from_wrapped_u32(c);
     let d = BabyBear::from_wrapped_u32(d);
-    let inv = BinomialExtensionField::<BabyBear, 4>::from_base_slice(&[a, b, c, d]).inverse();
+    let inv = EF::from_base_slice(&[a, b, c, d]).inverse();
     let inv: &[BabyBear] = inv.as_base_slice();
     inv[i as usize].as_canonical_u32()
 }
@@ -19,12 +24,84 @@ pub extern "C" fn babybearinv(a: u32) -> u32 {
     a.inverse().as_canonical_u32()
 }
 
+/// Inverts `n` extension field elements with a single Montgomery batch inversion.
+///
+/// `input` and `output` must both point to `4 * n` limbs, laid out as `n` consecutive elements
+/// of four base field coefficients each.
+///
+/// # Safety
+/// The caller must ensure that `input` and `output` are valid for `4 * n` reads and writes.
+#[no_mangle]
+pub unsafe extern "C" fn babybearextinv_batch(input: *const u32, output: *mut u32, n: usize) {
+    if n == 0 {
+        return;
+    }
+    let input = std::slice::from_raw_parts(input, 4 * n);
+    let output = std::slice::from_raw_parts_mut(output, 4 * n);
+    let values = input
+        .chunks_exact(4)
+        .map(|limbs| EF::from_base_fn(|i| BabyBear::from_wrapped_u32(limbs[i])))
+        .collect::<Vec<_>>();
+    let inverses = batch_multiplicative_inverse(&values);
+    for (limbs, inv) in output.chunks_exact_mut(4).zip(inverses.iter()) {
+        for (limb, x) in limbs.iter_mut().zip(inv.as_base_slice()) {
+            *limb = x.as_canonical_u32();
+        }
+    }
+}
+
+/// Inverts `n` base field elements with a single Montgomery batch inversion.
+///
+/// # Safety
+/// The caller must ensure that `input` and `output` are valid for `n` reads and writes.
+#[no_mangle]
+pub unsafe extern "C" fn babybearinv_batch(input: *const u32, output: *mut u32, n: usize) {
+    if n == 0 {
+        return;
+    }
+    let input = std::slice::from_raw_parts(input, n);
+    let output = std::slice::from_raw_parts_mut(output, n);
+    let values = input
+        .iter()
+        .map(|x| BabyBear::from_wrapped_u32(*x))
+        .collect::<Vec<_>>();
+    let inverses = batch_multiplicative_inverse(&values);
+    for (out, inv) in output.iter_mut().zip(inverses) {
+        *out = inv.as_canonical_u32();
+    }
+}
+
 #[cfg(test)]
 pub mod test {
-    use super::babybearextinv;
+    use super::{babybearextinv, babybearextinv_batch, babybearinv, babybearinv_batch};
 
     #[test]
     fn test_babybearextinv() {
         babybearextinv(1, 2, 3, 4, 0);
     }
+
+    #[test]
+    fn test_babybearextinv_batch() {
+        let input = [1, 2, 3, 4, 5, 6, 7, 8, 2013265920, 0, 11, 1];
+        let mut output = [0u32; 12];
+        unsafe { babybearextinv_batch(input.as_ptr(), output.as_mut_ptr(), 3) };
+        for (limbs, out) in input.chunks_exact(4).zip(output.chunks_exact(4)) {
+            for i in 0..4 {
+                assert_eq!(
+                    out[i],
+                    babybearextinv(limbs[0], limbs[1], limbs[2], limbs[3], i as u32)
+                );
+            }
+        }
+    }
+
+    #[test]
+    fn test_babybearinv_batch() {
+        let input = [1, 2, 3, 2013265920, 123456789];
+        let mut output = [0u32; 5];
+        unsafe { babybearinv_batch(input.as_ptr(), output.as_mut_ptr(), input.len()) };
+        for (x, inv) in input.iter().zip(output) {
+            assert_eq!(inv, babybearinv(*x));
+        }
+    }
 }
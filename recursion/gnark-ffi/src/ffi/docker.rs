@@ -1,8 +1,15 @@
 use sp1_core::SP1_CIRCUIT_VERSION;
 
-use crate::PlonkBn254Proof;
+use super::{ServerConnection, ServerRequest, ServerResponse, VerifyMode, GNARK_SERVER_PORT};
+use crate::{Groth16Bn254Proof, PlonkBn254Proof};
 use std::io::Write;
+use std::net::{SocketAddr, TcpStream};
 use std::process::Command;
+use std::sync::Mutex;
+use std::time::{Duration, Instant};
+
+/// How long to wait for a gnark server container to load the circuit artifacts.
+const SERVER_STARTUP_TIMEOUT: Duration = Duration::from_secs(600);
 
 /// Checks that docker is installed and running.
 fn check_docker() -> bool {
@@ -52,6 +59,227 @@ pub fn prove_plonk_bn254(data_dir: &str, witness_path: &str) -> PlonkBn254Proof
     bincode::deserialize_from(&output_file).expect("failed to deserialize result")
 }
 
+/// A prover session for the docker backend, backed by a `gnark-cli serve` container that keeps
+/// the circuit artifacts resident across proofs. Witnesses and proofs are passed over a TCP
+/// connection to a port the container publishes on the loopback interface. The container is
+/// stopped when the session is dropped.
+#[derive(Debug)]
+pub struct PlonkBn254ProverSession {
+    data_dir: String,
+    container_id: String,
+    addr: SocketAddr,
+    connection: Mutex<Option<ServerConnection<TcpStream>>>,
+}
+
+impl PlonkBn254ProverSession {
+    /// Starts a server container for the data directory and waits until it has loaded the
+    /// circuit artifacts.
+    pub fn open(data_dir: &str) -> Self {
+        assert_docker();
+        let port = GNARK_SERVER_PORT.to_string();
+        let listen_addr = format!("0.0.0.0:{}", port);
+        let output = Command::new("docker")
+            .args(["run", "-d", "--rm", "-p"])
+            .arg(format!("127.0.0.1::{}", port))
+            .arg("-v")
+            .arg(format!("{}:/circuit", data_dir))
+            .arg(get_docker_image())
+            .args(["serve", "/circuit", &listen_addr])
+            .output()
+            .expect("failed to run docker");
+        if !output.status.success() {
+            panic!(
+                "failed to start the gnark server: {}",
+                String::from_utf8_lossy(&output.stderr)
+            );
+        }
+        let container_id = String::from_utf8(output.stdout).unwrap().trim().to_string();
+        log::info!("started gnark server in container {}", container_id);
+
+        let mut session = Self {
+            data_dir: data_dir.to_string(),
+            addr: Self::published_addr(&container_id, &port),
+            container_id,
+            connection: Mutex::new(None),
+        };
+        let connection = session.wait_until_ready();
+        *session.connection.get_mut().unwrap() = Some(connection);
+        session
+    }
+
+    /// Returns the host address that docker publishes the server port on.
+    fn published_addr(container_id: &str, port: &str) -> SocketAddr {
+        let output = Command::new("docker")
+            .args(["port", container_id, &format!("{}/tcp", port)])
+            .output()
+            .expect("failed to run docker");
+        let stdout = String::from_utf8(output.stdout).unwrap();
+        stdout
+            .lines()
+            .find_map(|line| line.trim().parse().ok())
+            .unwrap_or_else(|| panic!("failed to find the gnark server port in {:?}", stdout))
+    }
+
+    /// Pings the server until it answers. The published port accepts connections before the
+    /// server inside the container listens, so a connection alone does not mean it is ready.
+    fn wait_until_ready(&self) -> ServerConnection<TcpStream> {
+        let start = Instant::now();
+        loop {
+            let ready = TcpStream::connect(self.addr)
+                .and_then(ServerConnection::new)
+                .ok()
+                .and_then(
+                    |mut connection| match connection.call(&ServerRequest::Ping) {
+                        Ok(ServerResponse::Ready) => Some(connection),
+                        _ => None,
+                    },
+                );
+            if let Some(connection) = ready {
+                log::info!("gnark server ready after {:?}", start.elapsed());
+                return connection;
+            }
+            if !self.is_running() {
+                panic!("gnark server container {} exited", self.container_id);
+            }
+            if start.elapsed() > SERVER_STARTUP_TIMEOUT {
+                panic!("timed out waiting for the gnark server to load the circuit");
+            }
+            std::thread::sleep(Duration::from_millis(500));
+        }
+    }
+
+    fn is_running(&self) -> bool {
+        Command::new("docker")
+            .args(["inspect", "-f", "{{.State.Running}}", &self.container_id])
+            .output()
+            .map(|output| String::from_utf8_lossy(&output.stdout).trim() == "true")
+            .unwrap_or(false)
+    }
+
+    /// Sends a request to the server, reusing the idle connection or opening another one if it
+    /// is in use by a concurrent request.
+    fn call(&self, request: &ServerRequest) -> ServerResponse {
+        let idle = self.connection.lock().unwrap().take();
+        let mut connection = match idle {
+            Some(connection) => connection,
+            None => TcpStream::connect(self.addr)
+                .and_then(ServerConnection::new)
+                .expect("failed to connect to the gnark server"),
+        };
+        let response = connection
+            .call(request)
+            .expect("failed to communicate with the gnark server");
+        *self.connection.lock().unwrap() = Some(connection);
+        response
+    }
+
+    /// Proves a JSON witness, which the server does not take, in a fresh container.
+    pub fn prove(
+        &self,
+        witness_path: &str,
+        verify_mode: VerifyMode,
+    ) -> (PlonkBn254Proof, Option<PendingVerification>) {
+        self.prove_in_docker(witness_path, verify_mode)
+    }
+
+    /// Proves a witness encoded with [crate::GnarkWitness::encode_binary] on the server.
+    pub fn prove_binary(
+        &self,
+        witness: &[u8],
+        verify_mode: VerifyMode,
+    ) -> (PlonkBn254Proof, Option<PendingVerification>) {
+        let request = ServerRequest::ProvePlonk {
+            witness: witness.to_vec(),
+            verify: verify_mode == VerifyMode::Sync,
+        };
+        let proof = match self.call(&request) {
+            ServerResponse::Proof(proof) => proof,
+            response => panic!("unexpected gnark server response {:?}", response),
+        };
+        (proof.clone(), self.pending_verification(proof, verify_mode))
+    }
+
+    /// Verifies the proof on the server from a background thread, in [VerifyMode::Async] mode.
+    fn pending_verification(
+        &self,
+        proof: PlonkBn254Proof,
+        verify_mode: VerifyMode,
+    ) -> Option<PendingVerification> {
+        (verify_mode == VerifyMode::Async).then(|| {
+            let addr = self.addr;
+            PendingVerification {
+                handle: std::thread::spawn(move || {
+                    let mut connection = TcpStream::connect(addr)
+                        .and_then(ServerConnection::new)
+                        .map_err(|e| e.to_string())?;
+                    let request = ServerRequest::VerifyPlonk {
+                        proof: proof.raw_proof,
+                        vkey_hash: proof.public_inputs[0].clone(),
+                        committed_values_digest: proof.public_inputs[1].clone(),
+                    };
+                    match connection.call(&request).map_err(|e| e.to_string())? {
+                        ServerResponse::Verified(result) => result,
+                        response => Err(format!("unexpected gnark server response {:?}", response)),
+                    }
+                }),
+            }
+        })
+    }
+
+    /// Runs `prove-plonk` on a JSON witness in a fresh container, verifying asynchronous proofs on
+    /// the server.
+    fn prove_in_docker(
+        &self,
+        witness_path: &str,
+        verify_mode: VerifyMode,
+    ) -> (PlonkBn254Proof, Option<PendingVerification>) {
+        let output_file = tempfile::NamedTempFile::new().unwrap();
+        let mounts = [
+            (self.data_dir.as_str(), "/circuit"),
+            (witness_path, "/witness"),
+            (output_file.path().to_str().unwrap(), "/output"),
+        ];
+        let mut args = vec!["prove-plonk"];
+        if verify_mode != VerifyMode::Sync {
+            args.push("--skip-verify");
+        }
+        args.extend(["/circuit", "/witness", "/output"]);
+        call_docker(&args, &mounts).expect("failed to prove with docker");
+        let proof: PlonkBn254Proof =
+            bincode::deserialize_from(&output_file).expect("failed to deserialize result");
+        (proof.clone(), self.pending_verification(proof, verify_mode))
+    }
+}
+
+impl Drop for PlonkBn254ProverSession {
+    fn drop(&mut self) {
+        // The container was started with `--rm`, so killing it also removes it.
+        let status = Command::new("docker")
+            .args(["kill", &self.container_id])
+            .output()
+            .map(|output| output.status.success());
+        if status.ok() != Some(true) {
+            log::warn!(
+                "failed to stop gnark server container {}",
+                self.container_id
+            );
+        }
+    }
+}
+
+/// A self-verification of a proof running on the gnark server, waited on by a background thread.
+#[derive(Debug)]
+pub struct PendingVerification {
+    handle: std::thread::JoinHandle<Result<(), String>>,
+}
+
+impl PendingVerification {
+    /// Blocks until the verification has finished.
+    pub fn wait(self) -> Result<(), String> {
+        self.handle.join().expect("verification thread panicked")
+    }
+}
+
 pub fn build_plonk_bn254(data_dir: &str) {
     let circuit_dir = if data_dir.ends_with("dev") {
         "/circuit_dev"
@@ -99,6 +327,91 @@ pub fn verify_plonk_bn254(
     }
 }
 
+/// Verifies PLONK proofs against the verifying key in the data directory, one container run per
+/// proof, returning the result of each proof in order.
+pub fn verify_plonk_bn254_batch(
+    data_dir: &str,
+    proofs: &[(&str, &str, &str)],
+) -> Vec<Result<(), String>> {
+    proofs
+        .iter()
+        .map(|(proof, vkey_hash, committed_values_digest)| {
+            verify_plonk_bn254(data_dir, proof, vkey_hash, committed_values_digest)
+        })
+        .collect()
+}
+
+/// The docker image is built without GPU support.
+pub fn gnark_gpu_enabled() -> bool {
+    false
+}
+
+pub fn prove_groth16_bn254(data_dir: &str, witness_path: &str, use_gpu: bool) -> Groth16Bn254Proof {
+    if use_gpu {
+        log::warn!("gpu acceleration is not available with docker, proving on cpu");
+    }
+    let output_file = tempfile::NamedTempFile::new().unwrap();
+    let mounts = [
+        (data_dir, "/circuit"),
+        (witness_path, "/witness"),
+        (output_file.path().to_str().unwrap(), "/output"),
+    ];
+    assert_docker();
+    call_docker(
+        &["prove-groth16", "/circuit", "/witness", "/output"],
+        &mounts,
+    )
+    .expect("failed to prove with docker");
+    bincode::deserialize_from(&output_file).expect("failed to deserialize result")
+}
+
+pub fn build_groth16_bn254(data_dir: &str) {
+    let circuit_dir = if data_dir.ends_with("dev") {
+        "/circuit_dev"
+    } else {
+        "/circuit"
+    };
+    let mounts = [(data_dir, circuit_dir)];
+    assert_docker();
+    call_docker(&["build-groth16", circuit_dir], &mounts).expect("failed to build with docker");
+}
+
+pub fn verify_groth16_bn254(
+    data_dir: &str,
+    proof: &str,
+    vkey_hash: &str,
+    committed_values_digest: &str,
+) -> Result<(), String> {
+    // Write proof string to a file since it can be large.
+    let mut proof_file = tempfile::NamedTempFile::new().unwrap();
+    proof_file.write_all(proof.as_bytes()).unwrap();
+    let output_file = tempfile::NamedTempFile::new().unwrap();
+    let mounts = [
+        (data_dir, "/circuit"),
+        (proof_file.path().to_str().unwrap(), "/proof"),
+        (output_file.path().to_str().unwrap(), "/output"),
+    ];
+    assert_docker();
+    call_docker(
+        &[
+            "verify-groth16",
+            "/circuit",
+            "/proof",
+            vkey_hash,
+            committed_values_digest,
+            "/output",
+        ],
+        &mounts,
+    )
+    .expect("failed to verify with docker");
+    let result = std::fs::read_to_string(output_file.path()).unwrap();
+    if result == "OK" {
+        Ok(())
+    } else {
+        Err(result)
+    }
+}
+
 pub fn test_plonk_bn254(witness_json: &str, constraints_json: &str) {
     let mounts = [
         (constraints_json, "/constraints"),
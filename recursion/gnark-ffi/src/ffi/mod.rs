@@ -7,3 +7,20 @@ cfg_if::cfg_if! {
         pub use docker::*;
     }
 }
+
+mod server;
+pub use server::*;
+
+/// How the gnark prover checks a proof against the verifying key after generating it. The
+/// discriminants match `sp1.VerifyMode` in the Go library.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Default)]
+pub enum VerifyMode {
+    /// Return the proof without verifying it.
+    Off = 0,
+    /// Verify the proof before returning it, panicking if it does not verify.
+    #[default]
+    Sync = 1,
+    /// Return the proof immediately and verify it in the background. The result is reported
+    /// through the returned [PendingVerification].
+    Async = 2,
+}
@@ -5,8 +5,10 @@
 //! Although we cast to *mut c_char because the Go signatures can't be immutable, the Go functions
 //! should not modify the strings.
 
-use crate::PlonkBn254Proof;
+use super::VerifyMode;
+use crate::{Groth16Bn254Proof, PlonkBn254Proof};
 use cfg_if::cfg_if;
+use sp1_core::utils::metrics;
 use sp1_core::SP1_CIRCUIT_VERSION;
 use std::ffi::{c_char, CString};
 
@@ -32,6 +34,125 @@ pub fn prove_plonk_bn254(data_dir: &str, witness_path: &str) -> PlonkBn254Proof
     proof.into_rust()
 }
 
+/// A prover session in the Go library that keeps the circuit, proving key and verifying key
+/// resident in memory across proofs. The session is closed when dropped.
+#[derive(Debug)]
+pub struct PlonkBn254ProverSession {
+    handle: uintptr_t,
+}
+
+impl PlonkBn254ProverSession {
+    /// Loads the circuit artifacts from the data directory into a new session. The timings of the
+    /// Go prover are added to the metrics, if they are enabled.
+    pub fn open(data_dir: &str) -> Self {
+        metrics::register_collector(gnark_metrics);
+        let data_dir = CString::new(data_dir).expect("CString::new failed");
+        let handle = unsafe { bind::PlonkBn254ProverOpen(data_dir.as_ptr() as *mut c_char) };
+        Self { handle }
+    }
+
+    /// Generates a proof for the witness at the given path using the resident artifacts. A
+    /// pending verification is returned in [VerifyMode::Async] mode.
+    pub fn prove(
+        &self,
+        witness_path: &str,
+        verify_mode: VerifyMode,
+    ) -> (PlonkBn254Proof, Option<PendingVerification>) {
+        let witness_path = CString::new(witness_path).expect("CString::new failed");
+
+        let mut verification: uintptr_t = 0;
+        let proof = unsafe {
+            let proof = bind::PlonkBn254ProverProve(
+                self.handle,
+                witness_path.as_ptr() as *mut c_char,
+                verify_mode as i32,
+                &mut verification,
+            );
+            // Safety: The pointer is returned from the go code and is guaranteed to be valid.
+            *proof
+        };
+
+        (proof.into_rust(), PendingVerification::new(verification))
+    }
+
+    /// Generates a proof for a witness encoded with [crate::GnarkWitness::encode_binary], passing
+    /// the bytes to Go directly instead of through a file. A pending verification is returned in
+    /// [VerifyMode::Async] mode.
+    pub fn prove_binary(
+        &self,
+        witness: &[u8],
+        verify_mode: VerifyMode,
+    ) -> (PlonkBn254Proof, Option<PendingVerification>) {
+        let mut verification: uintptr_t = 0;
+        let proof = unsafe {
+            let proof = bind::PlonkBn254ProverProveBinary(
+                self.handle,
+                witness.as_ptr() as *mut u8,
+                witness.len(),
+                verify_mode as i32,
+                &mut verification,
+            );
+            // Safety: The pointer is returned from the go code and is guaranteed to be valid.
+            *proof
+        };
+
+        (proof.into_rust(), PendingVerification::new(verification))
+    }
+}
+
+/// Returns the metrics recorded by the Go library in the Prometheus text format.
+fn gnark_metrics() -> String {
+    let metrics_ptr = unsafe { bind::GnarkMetrics() };
+    // Safety: The string is returned from the go code and is guaranteed to be valid.
+    let metrics = unsafe { CString::from_raw(metrics_ptr) };
+    metrics.into_string().unwrap()
+}
+
+/// A self-verification of a proof that is still running in the Go library.
+#[derive(Debug)]
+pub struct PendingVerification {
+    handle: uintptr_t,
+}
+
+impl PendingVerification {
+    fn new(handle: uintptr_t) -> Option<Self> {
+        (handle != 0).then_some(Self { handle })
+    }
+
+    /// Blocks until the verification has finished.
+    pub fn wait(mut self) -> Result<(), String> {
+        let handle = std::mem::take(&mut self.handle);
+        let err_ptr = unsafe { bind::PlonkBn254VerificationWait(handle) };
+        if err_ptr.is_null() {
+            Ok(())
+        } else {
+            // Safety: The error message is returned from the go code and is guaranteed to be valid.
+            let err = unsafe { CString::from_raw(err_ptr) };
+            Err(err.into_string().unwrap())
+        }
+    }
+}
+
+impl Drop for PendingVerification {
+    /// Releases the Go handle if the verification was never waited on, discarding its result.
+    fn drop(&mut self) {
+        if self.handle != 0 {
+            let err_ptr = unsafe { bind::PlonkBn254VerificationWait(self.handle) };
+            if !err_ptr.is_null() {
+                // Safety: The error message is returned from the go code and is guaranteed to be
+                // valid.
+                drop(unsafe { CString::from_raw(err_ptr) });
+            }
+        }
+    }
+}
+
+impl Drop for PlonkBn254ProverSession {
+    fn drop(&mut self) {
+        unsafe { bind::PlonkBn254ProverClose(self.handle) }
+    }
+}
+
 pub fn build_plonk_bn254(data_dir: &str) {
     let data_dir = CString::new(data_dir).expect("CString::new failed");
 
@@ -69,6 +190,116 @@ pub fn verify_plonk_bn254(
     }
 }
 
+/// Verifies PLONK proofs in parallel against the verifying key in the data directory, which the Go
+/// library keeps resident across calls. Each proof is given with its vkey hash and committed values
+/// digest, and the result of each proof is returned in order.
+pub fn verify_plonk_bn254_batch(
+    data_dir: &str,
+    proofs: &[(&str, &str, &str)],
+) -> Vec<Result<(), String>> {
+    let data_dir = CString::new(data_dir).expect("CString::new failed");
+    let to_c_strings = |strs: Vec<&str>| {
+        strs.into_iter()
+            .map(|s| CString::new(s).expect("CString::new failed"))
+            .collect::<Vec<_>>()
+    };
+    let raw_proofs = to_c_strings(proofs.iter().map(|p| p.0).collect());
+    let vkey_hashes = to_c_strings(proofs.iter().map(|p| p.1).collect());
+    let committed_values_digests = to_c_strings(proofs.iter().map(|p| p.2).collect());
+    let to_ptrs = |strs: &[CString]| {
+        strs.iter()
+            .map(|s| s.as_ptr() as *mut c_char)
+            .collect::<Vec<_>>()
+    };
+    let mut raw_proof_ptrs = to_ptrs(&raw_proofs);
+    let mut vkey_hash_ptrs = to_ptrs(&vkey_hashes);
+    let mut committed_values_digest_ptrs = to_ptrs(&committed_values_digests);
+    let mut err_ptrs = vec![std::ptr::null_mut::<c_char>(); proofs.len()];
+
+    unsafe {
+        bind::VerifyPlonkBn254Batch(
+            data_dir.as_ptr() as *mut c_char,
+            raw_proof_ptrs.as_mut_ptr(),
+            vkey_hash_ptrs.as_mut_ptr(),
+            committed_values_digest_ptrs.as_mut_ptr(),
+            proofs.len(),
+            err_ptrs.as_mut_ptr(),
+        )
+    };
+    err_ptrs
+        .into_iter()
+        .map(|err_ptr| {
+            if err_ptr.is_null() {
+                Ok(())
+            } else {
+                // Safety: The error message is returned from the go code and is guaranteed to be
+                // valid.
+                let err = unsafe { CString::from_raw(err_ptr) };
+                Err(err.into_string().unwrap())
+            }
+        })
+        .collect()
+}
+
+/// Returns whether the Go library was built with GPU acceleration.
+pub fn gnark_gpu_enabled() -> bool {
+    unsafe { bind::GnarkGpuEnabled() != 0 }
+}
+
+pub fn prove_groth16_bn254(data_dir: &str, witness_path: &str, use_gpu: bool) -> Groth16Bn254Proof {
+    let data_dir = CString::new(data_dir).expect("CString::new failed");
+    let witness_path = CString::new(witness_path).expect("CString::new failed");
+
+    let proof = unsafe {
+        let proof = bind::ProveGroth16Bn254(
+            data_dir.as_ptr() as *mut c_char,
+            witness_path.as_ptr() as *mut c_char,
+            use_gpu as i32,
+        );
+        // Safety: The pointer is returned from the go code and is guaranteed to be valid.
+        *proof
+    };
+
+    proof.into_rust()
+}
+
+pub fn build_groth16_bn254(data_dir: &str) {
+    let data_dir = CString::new(data_dir).expect("CString::new failed");
+
+    unsafe {
+        bind::BuildGroth16Bn254(data_dir.as_ptr() as *mut c_char);
+    }
+}
+
+pub fn verify_groth16_bn254(
+    data_dir: &str,
+    proof: &str,
+    vkey_hash: &str,
+    committed_values_digest: &str,
+) -> Result<(), String> {
+    let data_dir = CString::new(data_dir).expect("CString::new failed");
+    let proof = CString::new(proof).expect("CString::new failed");
+    let vkey_hash = CString::new(vkey_hash).expect("CString::new failed");
+    let committed_values_digest =
+        CString::new(committed_values_digest).expect("CString::new failed");
+
+    let err_ptr = unsafe {
+        bind::VerifyGroth16Bn254(
+            data_dir.as_ptr() as *mut c_char,
+            proof.as_ptr() as *mut c_char,
+            vkey_hash.as_ptr() as *mut c_char,
+            committed_values_digest.as_ptr() as *mut c_char,
+        )
+    };
+    if err_ptr.is_null() {
+        Ok(())
+    } else {
+        // Safety: The error message is returned from the go code and is guaranteed to be valid.
+        let err = unsafe { CString::from_raw(err_ptr) };
+        Err(err.into_string().unwrap())
+    }
+}
+
 pub fn test_plonk_bn254(witness_json: &str, constraints_json: &str) {
     unsafe {
         let witness_json = CString::new(witness_json).expect("CString::new failed");
@@ -127,6 +358,24 @@ impl C_PlonkBn254Proof {
     }
 }
 
+impl C_Groth16Bn254Proof {
+    /// Converts a C Groth16Bn254Proof into a Rust Groth16Bn254Proof, freeing the C strings.
+    fn into_rust(self) -> Groth16Bn254Proof {
+        // Safety: The raw pointers are not used anymore after converted into Rust strings.
+        unsafe {
+            Groth16Bn254Proof {
+                public_inputs: [
+                    c_char_ptr_to_string(self.PublicInputs[0]),
+                    c_char_ptr_to_string(self.PublicInputs[1]),
+                ],
+                encoded_proof: c_char_ptr_to_string(self.EncodedProof),
+                raw_proof: c_char_ptr_to_string(self.RawProof),
+                groth16_vkey_hash: [0; 32],
+            }
+        }
+    }
+}
+
 #[cfg(test)]
 mod tests {
     use p3_baby_bear::BabyBear;
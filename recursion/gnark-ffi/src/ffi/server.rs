@@ -0,0 +1,193 @@
+//! A long-lived gnark server for the docker backend.
+//!
+//! `gnark-cli serve` opens a [PlonkBn254ProverSession] once and answers requests over TCP, so a
+//! docker session pays for container startup and key loading once instead of per proof. Each
+//! message is a bincode encoded [ServerRequest] or [ServerResponse], and a connection may carry
+//! any number of requests in turn. The socket is TCP rather than a Unix socket because Unix
+//! sockets in bind mounts do not cross the VM boundary of Docker Desktop.
+
+use std::io::{BufReader, BufWriter, Read, Write};
+
+use serde::{de::DeserializeOwned, Deserialize, Serialize};
+
+use crate::PlonkBn254Proof;
+
+/// The port that the server listens on inside the container.
+pub const GNARK_SERVER_PORT: u16 = 7878;
+
+/// A request to the gnark server.
+#[derive(Debug, Serialize, Deserialize)]
+pub enum ServerRequest {
+    /// Answered with [ServerResponse::Ready] once the circuit artifacts are loaded.
+    Ping,
+    /// Proves a witness encoded with [crate::GnarkWitness::encode_binary].
+    ProvePlonk { witness: Vec<u8>, verify: bool },
+    /// Verifies a proof against the resident verifying key.
+    VerifyPlonk {
+        proof: String,
+        vkey_hash: String,
+        committed_values_digest: String,
+    },
+}
+
+/// A response of the gnark server, in the order of the requests on the connection.
+#[derive(Debug, Serialize, Deserialize)]
+pub enum ServerResponse {
+    Ready,
+    Proof(PlonkBn254Proof),
+    Verified(Result<(), String>),
+}
+
+/// A connection to a gnark server, or the server side of one.
+#[derive(Debug)]
+pub struct ServerConnection<S: Read + Write> {
+    reader: BufReader<S>,
+    writer: BufWriter<S>,
+}
+
+impl ServerConnection<std::net::TcpStream> {
+    pub fn new(stream: std::net::TcpStream) -> std::io::Result<Self> {
+        stream.set_nodelay(true)?;
+        Ok(Self {
+            reader: BufReader::new(stream.try_clone()?),
+            writer: BufWriter::new(stream),
+        })
+    }
+}
+
+impl<S: Read + Write> ServerConnection<S> {
+    /// Writes a message and flushes it to the peer.
+    pub fn send<T: Serialize>(&mut self, message: &T) -> bincode::Result<()> {
+        bincode::serialize_into(&mut self.writer, message)?;
+        self.writer.flush()?;
+        Ok(())
+    }
+
+    /// Reads the next message from the peer.
+    pub fn receive<T: DeserializeOwned>(&mut self) -> bincode::Result<T> {
+        bincode::deserialize_from(&mut self.reader)
+    }
+
+    /// Sends a request and waits for its response.
+    pub fn call(&mut self, request: &ServerRequest) -> bincode::Result<ServerResponse> {
+        self.send(request)?;
+        self.receive()
+    }
+}
+
+#[cfg(feature = "native")]
+pub use self::serve::serve_plonk_bn254;
+
+#[cfg(feature = "native")]
+mod serve {
+    use std::net::{TcpListener, TcpStream};
+    use std::sync::Arc;
+
+    use super::*;
+    use crate::ffi::{verify_plonk_bn254, PlonkBn254ProverSession, VerifyMode};
+
+    /// Loads the circuit artifacts in the data directory and serves requests on the address until
+    /// the process is killed. Connections are served concurrently, and the Go prover serializes
+    /// the proofs among them.
+    pub fn serve_plonk_bn254(data_dir: &str, addr: &str) {
+        let session = Arc::new(PlonkBn254ProverSession::open(data_dir));
+        let listener = TcpListener::bind(addr).expect("failed to bind the gnark server");
+        log::info!("gnark server listening on {}", addr);
+
+        for stream in listener.incoming() {
+            let stream = match stream {
+                Ok(stream) => stream,
+                Err(e) => {
+                    log::warn!("failed to accept a connection: {}", e);
+                    continue;
+                }
+            };
+            let session = session.clone();
+            let data_dir = data_dir.to_string();
+            std::thread::spawn(move || {
+                if let Err(e) = serve_connection(&session, &data_dir, stream) {
+                    log::debug!("gnark server connection closed: {}", e);
+                }
+            });
+        }
+    }
+
+    fn serve_connection(
+        session: &PlonkBn254ProverSession,
+        data_dir: &str,
+        stream: TcpStream,
+    ) -> bincode::Result<()> {
+        let mut connection = ServerConnection::new(stream)?;
+        loop {
+            let response = match connection.receive()? {
+                ServerRequest::Ping => ServerResponse::Ready,
+                ServerRequest::ProvePlonk { witness, verify } => {
+                    let verify_mode = if verify {
+                        VerifyMode::Sync
+                    } else {
+                        VerifyMode::Off
+                    };
+                    ServerResponse::Proof(session.prove_binary(&witness, verify_mode).0)
+                }
+                ServerRequest::VerifyPlonk {
+                    proof,
+                    vkey_hash,
+                    committed_values_digest,
+                } => ServerResponse::Verified(verify_plonk_bn254(
+                    data_dir,
+                    &proof,
+                    &vkey_hash,
+                    &committed_values_digest,
+                )),
+            };
+            connection.send(&response)?;
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_messages_round_trip() {
+        let (client, server) = std::os::unix::net::UnixStream::pair().unwrap();
+        let mut client = ServerConnection {
+            reader: BufReader::new(client.try_clone().unwrap()),
+            writer: BufWriter::new(client),
+        };
+        let mut server = ServerConnection {
+            reader: BufReader::new(server.try_clone().unwrap()),
+            writer: BufWriter::new(server),
+        };
+
+        let handle = std::thread::spawn(move || {
+            for _ in 0..2 {
+                let response = match server.receive().unwrap() {
+                    ServerRequest::ProvePlonk { witness, .. } => {
+                        ServerResponse::Proof(PlonkBn254Proof {
+                            raw_proof: hex::encode(witness),
+                            ..Default::default()
+                        })
+                    }
+                    _ => ServerResponse::Ready,
+                };
+                server.send(&response).unwrap();
+            }
+        });
+
+        assert!(matches!(
+            client.call(&ServerRequest::Ping).unwrap(),
+            ServerResponse::Ready
+        ));
+        let request = ServerRequest::ProvePlonk {
+            witness: vec![1, 2, 3],
+            verify: false,
+        };
+        match client.call(&request).unwrap() {
+            ServerResponse::Proof(proof) => assert_eq!(proof.raw_proof, "010203"),
+            response => panic!("unexpected response {:?}", response),
+        }
+        handle.join().unwrap();
+    }
+}
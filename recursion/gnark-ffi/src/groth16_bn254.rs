@@ -0,0 +1,123 @@
+use std::{
+    fs::File,
+    io::Write,
+    path::{Path, PathBuf},
+};
+
+use crate::ffi::{
+    build_groth16_bn254, gnark_gpu_enabled, prove_groth16_bn254, verify_groth16_bn254,
+};
+use crate::manifest::artifact_checksum;
+use crate::witness::GnarkWitness;
+
+use num_bigint::BigUint;
+use serde::{Deserialize, Serialize};
+use sp1_recursion_compiler::{
+    constraints::{binary::encode_constraints, Constraint},
+    ir::{Config, Witness},
+};
+
+/// A prover that can generate proofs with the Groth16 protocol using bindings to Gnark.
+#[derive(Debug, Clone)]
+pub struct Groth16Bn254Prover {
+    use_gpu: bool,
+}
+
+impl Default for Groth16Bn254Prover {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+/// A zero-knowledge proof generated by the Groth16 protocol with a hex encoded gnark Groth16 proof.
+#[derive(Debug, Clone, Serialize, Deserialize, Default)]
+pub struct Groth16Bn254Proof {
+    pub public_inputs: [String; 2],
+    pub encoded_proof: String,
+    pub raw_proof: String,
+    pub groth16_vkey_hash: [u8; 32],
+}
+
+impl Groth16Bn254Prover {
+    /// Creates a new [Groth16Bn254Prover]. GPU acceleration is used by default if the Go library
+    /// was built with the `gpu` feature.
+    pub fn new() -> Self {
+        Self {
+            use_gpu: gnark_gpu_enabled(),
+        }
+    }
+
+    /// Sets whether to offload MSMs and NTTs to the GPU. If the GPU prover is unavailable or
+    /// fails, proofs are generated on the CPU.
+    pub fn with_gpu(mut self, use_gpu: bool) -> Self {
+        self.use_gpu = use_gpu;
+        self
+    }
+
+    /// Returns the sha256 hash of the verifier key, as recorded in the build manifest.
+    pub fn get_vkey_hash(build_dir: &Path) -> [u8; 32] {
+        artifact_checksum(build_dir, "groth16_vk.bin")
+    }
+
+    /// Builds the Groth16 circuit locally.
+    pub fn build<C: Config>(constraints: Vec<Constraint>, witness: Witness<C>, build_dir: PathBuf) {
+        let serialized = serde_json::to_string(&constraints).unwrap();
+
+        // Write constraints.
+        let constraints_path = build_dir.join("constraints.json");
+        let mut file = File::create(constraints_path).unwrap();
+        file.write_all(serialized.as_bytes()).unwrap();
+
+        // Write the binary constraint program, which Go prefers over the JSON constraints.
+        let constraints_bin_path = build_dir.join("constraints.bin");
+        let mut file = File::create(constraints_bin_path).unwrap();
+        file.write_all(&encode_constraints(&constraints)).unwrap();
+
+        // Write witness.
+        let witness_path = build_dir.join("witness.json");
+        let gnark_witness = GnarkWitness::new(witness);
+        let mut file = File::create(witness_path).unwrap();
+        let serialized = serde_json::to_string(&gnark_witness).unwrap();
+        file.write_all(serialized.as_bytes()).unwrap();
+
+        build_groth16_bn254(build_dir.to_str().unwrap());
+    }
+
+    /// Generates a Groth16 proof given a witness.
+    pub fn prove<C: Config>(&self, witness: Witness<C>, build_dir: PathBuf) -> Groth16Bn254Proof {
+        // Write witness.
+        let mut witness_file = tempfile::NamedTempFile::new().unwrap();
+        let gnark_witness = GnarkWitness::new(witness);
+        let serialized = serde_json::to_string(&gnark_witness).unwrap();
+        witness_file.write_all(serialized.as_bytes()).unwrap();
+
+        let mut proof = prove_groth16_bn254(
+            build_dir.to_str().unwrap(),
+            witness_file.path().to_str().unwrap(),
+            self.use_gpu,
+        );
+        proof.groth16_vkey_hash = Self::get_vkey_hash(&build_dir);
+        proof
+    }
+
+    /// Verify a Groth16 proof and verify that the supplied vkey_hash and committed_values_digest
+    /// match.
+    pub fn verify(
+        &self,
+        proof: &Groth16Bn254Proof,
+        vkey_hash: &BigUint,
+        committed_values_digest: &BigUint,
+        build_dir: &Path,
+    ) {
+        if proof.groth16_vkey_hash != Self::get_vkey_hash(build_dir) {
+            panic!("Proof vkey hash does not match circuit vkey hash, it was generated with a different circuit.");
+        }
+        verify_groth16_bn254(
+            build_dir.to_str().unwrap(),
+            &proof.raw_proof,
+            &vkey_hash.to_string(),
+            &committed_values_digest.to_string(),
+        )
+        .expect("failed to verify proof")
+    }
+}
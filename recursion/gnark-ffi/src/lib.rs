@@ -1,9 +1,14 @@
 mod babybear;
 
 pub mod ffi;
+pub use ffi::VerifyMode;
 
+pub mod groth16_bn254;
+pub mod manifest;
 pub mod plonk_bn254;
 pub mod witness;
 
+pub use groth16_bn254::*;
+pub use manifest::*;
 pub use plonk_bn254::*;
 pub use witness::*;
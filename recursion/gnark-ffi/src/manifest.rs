@@ -0,0 +1,101 @@
+use std::{collections::BTreeMap, fs::File, path::Path};
+
+use serde::{Deserialize, Serialize};
+use sha2::{Digest, Sha256};
+
+/// The name of the build manifest written next to the circuit artifacts.
+pub const BUILD_MANIFEST_FILE: &str = "manifest.json";
+
+/// The sha256 checksums of the artifacts in a build directory, keyed by file name.
+///
+/// The manifest is written by the gnark build, which hashes the artifacts as they are streamed to
+/// disk.
+#[derive(Debug, Clone, Serialize, Deserialize, Default)]
+pub struct BuildManifest {
+    pub artifacts: BTreeMap<String, String>,
+}
+
+impl BuildManifest {
+    /// Reads the manifest of the build directory, if there is one.
+    pub fn read(build_dir: &Path) -> Option<Self> {
+        let data = std::fs::read(build_dir.join(BUILD_MANIFEST_FILE)).ok()?;
+        serde_json::from_slice(&data).ok()
+    }
+
+    /// Returns the recorded checksum of the artifact.
+    pub fn checksum(&self, name: &str) -> Option<[u8; 32]> {
+        let checksum = hex::decode(self.artifacts.get(name)?).ok()?;
+        checksum.try_into().ok()
+    }
+
+    /// Checks that every artifact recorded in the manifest is in the build directory with the
+    /// recorded checksum, such as after extracting downloaded artifacts.
+    pub fn verify(&self, build_dir: &Path) -> anyhow::Result<()> {
+        for name in self.artifacts.keys() {
+            let recorded = self
+                .checksum(name)
+                .ok_or_else(|| anyhow::anyhow!("invalid checksum of artifact {}", name))?;
+            let path = build_dir.join(name);
+            let mut file = File::open(&path)
+                .map_err(|e| anyhow::anyhow!("failed to open artifact {:?}: {}", path, e))?;
+            let mut hasher = Sha256::new();
+            std::io::copy(&mut file, &mut hasher)?;
+            let checksum: [u8; 32] = hasher.finalize().into();
+            anyhow::ensure!(
+                checksum == recorded,
+                "artifact {:?} does not match the checksum in the build manifest",
+                path
+            );
+        }
+        Ok(())
+    }
+}
+
+/// Returns the sha256 checksum of an artifact in the build directory.
+///
+/// The checksum is computed from the file rather than taken from the build manifest. The vkey hash
+/// guards against proofs of another circuit, which a stale manifest next to a replaced vk would
+/// defeat.
+pub fn artifact_checksum(build_dir: &Path, name: &str) -> [u8; 32] {
+    let bytes = std::fs::read(build_dir.join(name)).unwrap();
+    Sha256::digest(bytes).into()
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_manifest_checksums() {
+        let dir = tempfile::tempdir().unwrap();
+        std::fs::write(dir.path().join("vk.bin"), b"vk").unwrap();
+        let hashed: [u8; 32] = Sha256::digest(b"vk").into();
+        assert_eq!(artifact_checksum(dir.path(), "vk.bin"), hashed);
+
+        let mut manifest = BuildManifest::default();
+        manifest
+            .artifacts
+            .insert("vk.bin".to_string(), hex::encode(hashed));
+        manifest.verify(dir.path()).unwrap();
+
+        // A stale manifest is reported, and does not change the checksum of the file.
+        manifest
+            .artifacts
+            .insert("vk.bin".to_string(), hex::encode([7u8; 32]));
+        std::fs::write(
+            dir.path().join(BUILD_MANIFEST_FILE),
+            serde_json::to_vec(&manifest).unwrap(),
+        )
+        .unwrap();
+        assert!(BuildManifest::read(dir.path())
+            .unwrap()
+            .verify(dir.path())
+            .is_err());
+        assert_eq!(artifact_checksum(dir.path(), "vk.bin"), hashed);
+
+        manifest
+            .artifacts
+            .insert("pk.dump".to_string(), hex::encode(hashed));
+        assert!(manifest.verify(dir.path()).is_err());
+    }
+}
@@ -1,25 +1,48 @@
 use std::{
+    fmt::{self, Debug, Formatter},
     fs::File,
     io::Write,
     path::{Path, PathBuf},
+    sync::{Arc, Mutex},
 };
 
-use crate::ffi::{build_plonk_bn254, prove_plonk_bn254, test_plonk_bn254, verify_plonk_bn254};
+use crate::ffi::{
+    build_plonk_bn254, test_plonk_bn254, verify_plonk_bn254, verify_plonk_bn254_batch,
+    PlonkBn254ProverSession, VerifyMode,
+};
+use crate::manifest::artifact_checksum;
 use crate::witness::GnarkWitness;
 
 use num_bigint::BigUint;
 use serde::{Deserialize, Serialize};
-use sha2::Digest;
-use sha2::Sha256;
 use sp1_core::SP1_CIRCUIT_VERSION;
 use sp1_recursion_compiler::{
-    constraints::Constraint,
+    constraints::{binary::encode_constraints, Constraint},
     ir::{Config, Witness},
 };
 
 /// A prover that can generate proofs with the PLONK protocol using bindings to Gnark.
-#[derive(Debug, Clone)]
-pub struct PlonkBn254Prover;
+///
+/// The circuit artifacts of the most recently used build directory are kept loaded, so repeated
+/// proofs against the same circuit only pay the key loading cost once.
+#[derive(Clone, Default)]
+pub struct PlonkBn254Prover {
+    session: Arc<Mutex<Option<(PathBuf, Arc<PlonkBn254ProverSession>)>>>,
+    verify_mode: VerifyMode,
+    on_verified: Option<VerificationCallback>,
+}
+
+/// Receives the result of a self-verification that ran in the background.
+pub type VerificationCallback = Arc<dyn Fn(Result<(), String>) + Send + Sync>;
+
+impl Debug for PlonkBn254Prover {
+    fn fmt(&self, f: &mut Formatter<'_>) -> fmt::Result {
+        f.debug_struct("PlonkBn254Prover")
+            .field("session", &self.session)
+            .field("verify_mode", &self.verify_mode)
+            .finish()
+    }
+}
 
 /// A zero-knowledge proof generated by the PLONK protocol with a Base64 encoded gnark PLONK proof.
 #[derive(Debug, Clone, Serialize, Deserialize, Default)]
@@ -33,22 +56,59 @@ pub struct PlonkBn254Proof {
 impl PlonkBn254Prover {
     /// Creates a new [PlonkBn254Prover].
     pub fn new() -> Self {
-        Self
+        Self::default()
+    }
+
+    /// Sets how gnark checks each proof against the verifying key before it is returned. Defaults
+    /// to [VerifyMode::Sync]. Callers that verify the proof downstream can turn this off, or use
+    /// [VerifyMode::Async] to take it off the critical path.
+    pub fn with_verify_mode(mut self, verify_mode: VerifyMode) -> Self {
+        self.verify_mode = verify_mode;
+        self
     }
 
+    /// Sets the callback that receives the result of each [VerifyMode::Async] verification. Without
+    /// one, verification failures are logged.
+    pub fn with_verification_callback(mut self, on_verified: VerificationCallback) -> Self {
+        self.on_verified = Some(on_verified);
+        self
+    }
+
+    /// Returns the prover session for the given build directory, loading its artifacts if they
+    /// are not already resident.
+    fn session(&self, build_dir: &Path) -> Arc<PlonkBn254ProverSession> {
+        let mut session = self.session.lock().unwrap();
+        match session.as_ref() {
+            Some((dir, s)) if dir == build_dir => s.clone(),
+            _ => {
+                let s = Arc::new(PlonkBn254ProverSession::open(build_dir.to_str().unwrap()));
+                *session = Some((build_dir.to_path_buf(), s.clone()));
+                s
+            }
+        }
+    }
+
+    /// Returns the sha256 hash of the verifier key, as recorded in the build manifest.
     pub fn get_vkey_hash(build_dir: &Path) -> [u8; 32] {
-        let vkey_path = build_dir.join("vk.bin");
-        let vk_bin_bytes = std::fs::read(vkey_path).unwrap();
-        Sha256::digest(vk_bin_bytes).into()
+        artifact_checksum(build_dir, "vk.bin")
     }
 
     /// Executes the prover in testing mode with a circuit definition and witness.
     pub fn test<C: Config>(constraints: Vec<Constraint>, witness: Witness<C>) {
+        // Write constraints as a binary constraint program.
+        Self::test_constraints(&encode_constraints(&constraints), witness);
+    }
+
+    /// Executes the prover in testing mode like [Self::test], but with the circuit definition
+    /// written as JSON constraints, which the Go side reads when no constraint program is present.
+    pub fn test_json<C: Config>(constraints: Vec<Constraint>, witness: Witness<C>) {
         let serialized = serde_json::to_string(&constraints).unwrap();
+        Self::test_constraints(serialized.as_bytes(), witness);
+    }
 
-        // Write constraints.
+    fn test_constraints<C: Config>(constraints: &[u8], witness: Witness<C>) {
         let mut constraints_file = tempfile::NamedTempFile::new().unwrap();
-        constraints_file.write_all(serialized.as_bytes()).unwrap();
+        constraints_file.write_all(constraints).unwrap();
 
         // Write witness.
         let mut witness_file = tempfile::NamedTempFile::new().unwrap();
@@ -71,6 +131,11 @@ impl PlonkBn254Prover {
         let mut file = File::create(constraints_path).unwrap();
         file.write_all(serialized.as_bytes()).unwrap();
 
+        // Write the binary constraint program, which Go prefers over the JSON constraints.
+        let constraints_bin_path = build_dir.join("constraints.bin");
+        let mut file = File::create(constraints_bin_path).unwrap();
+        file.write_all(&encode_constraints(&constraints)).unwrap();
+
         // Write witness.
         let witness_path = build_dir.join("witness.json");
         let gnark_witness = GnarkWitness::new(witness);
@@ -111,16 +176,24 @@ impl PlonkBn254Prover {
 
     /// Generates a PLONK proof given a witness.
     pub fn prove<C: Config>(&self, witness: Witness<C>, build_dir: PathBuf) -> PlonkBn254Proof {
-        // Write witness.
-        let mut witness_file = tempfile::NamedTempFile::new().unwrap();
-        let gnark_witness = GnarkWitness::new(witness);
-        let serialized = serde_json::to_string(&gnark_witness).unwrap();
-        witness_file.write_all(serialized.as_bytes()).unwrap();
-
-        let mut proof = prove_plonk_bn254(
-            build_dir.to_str().unwrap(),
-            witness_file.path().to_str().unwrap(),
-        );
+        let witness = GnarkWitness::encode_binary(witness);
+        let (mut proof, verification) = self
+            .session(&build_dir)
+            .prove_binary(&witness, self.verify_mode);
+        if let Some(verification) = verification {
+            let on_verified = self.on_verified.clone();
+            std::thread::spawn(move || {
+                let result = verification.wait();
+                match on_verified {
+                    Some(on_verified) => on_verified(result),
+                    None => {
+                        if let Err(err) = result {
+                            log::error!("plonk bn254 proof failed self-verification: {}", err);
+                        }
+                    }
+                }
+            });
+        }
         proof.plonk_vkey_hash = Self::get_vkey_hash(&build_dir);
         proof
     }
@@ -144,10 +217,47 @@ impl PlonkBn254Prover {
         )
         .expect("failed to verify proof")
     }
-}
 
-impl Default for PlonkBn254Prover {
-    fn default() -> Self {
-        Self::new()
+    /// Verifies PLONK proofs in parallel, each with its vkey hash and committed values digest,
+    /// returning the result of each proof in order.
+    pub fn verify_batch(
+        &self,
+        proofs: &[(&PlonkBn254Proof, &BigUint, &BigUint)],
+        build_dir: &Path,
+    ) -> Vec<Result<(), String>> {
+        let circuit_vkey_hash = Self::get_vkey_hash(build_dir);
+        let public_inputs = proofs
+            .iter()
+            .map(|(_, vkey_hash, committed_values_digest)| {
+                (vkey_hash.to_string(), committed_values_digest.to_string())
+            })
+            .collect::<Vec<_>>();
+        let requests = proofs
+            .iter()
+            .zip(public_inputs.iter())
+            .map(|((proof, _, _), (vkey_hash, committed_values_digest))| {
+                (
+                    proof.raw_proof.as_str(),
+                    vkey_hash.as_str(),
+                    committed_values_digest.as_str(),
+                )
+            })
+            .collect::<Vec<_>>();
+        let results = verify_plonk_bn254_batch(build_dir.to_str().unwrap(), &requests);
+
+        proofs
+            .iter()
+            .zip(results)
+            .map(|((proof, _, _), result)| {
+                if proof.plonk_vkey_hash != circuit_vkey_hash {
+                    return Err(
+                        "proof vkey hash does not match circuit vkey hash, it was generated with a \
+                         different circuit"
+                            .to_string(),
+                    );
+                }
+                result
+            })
+            .collect()
     }
 }
@@ -9,6 +9,9 @@ use serde::Serialize;
 use sp1_recursion_compiler::ir::Config;
 use sp1_recursion_compiler::ir::Witness;
 
+/// The number of bytes used to encode a BN254 scalar in the binary witness.
+const BN254_ELEMENT_SIZE: usize = 32;
+
 /// A witness that can be used to initialize values for witness generation inside Gnark.
 #[derive(Debug, Clone, Default, Serialize, Deserialize)]
 pub struct GnarkWitness {
@@ -54,6 +57,42 @@ impl GnarkWitness {
         }
     }
 
+    /// Encodes a given [Witness] into the compact little-endian layout decoded by
+    /// `DecodeBinaryWitness` on the Go side:
+    ///
+    /// `u32 num_vars | u32 num_felts | u32 num_exts | vars (32 bytes each) | felts (u32 each) |
+    /// exts (4 x u32 each) | vkey_hash (32 bytes) | commited_values_digest (32 bytes)`
+    pub fn encode_binary<C: Config>(mut witness: Witness<C>) -> Vec<u8> {
+        witness.vars.push(C::N::from_canonical_usize(999));
+        witness.felts.push(C::F::from_canonical_usize(999));
+        witness.exts.push(C::EF::from_canonical_usize(999));
+
+        let size = 12
+            + witness.vars.len() * BN254_ELEMENT_SIZE
+            + witness.felts.len() * 4
+            + witness.exts.len() * 16
+            + 2 * BN254_ELEMENT_SIZE;
+        let mut bytes = Vec::with_capacity(size);
+        bytes.extend_from_slice(&(witness.vars.len() as u32).to_le_bytes());
+        bytes.extend_from_slice(&(witness.felts.len() as u32).to_le_bytes());
+        bytes.extend_from_slice(&(witness.exts.len() as u32).to_le_bytes());
+        for var in witness.vars.iter() {
+            write_bn254(&mut bytes, var);
+        }
+        for felt in witness.felts.iter() {
+            write_felt(&mut bytes, felt);
+        }
+        for ext in witness.exts.iter() {
+            for felt in ext.as_base_slice() {
+                write_felt(&mut bytes, felt);
+            }
+        }
+        write_bn254(&mut bytes, &witness.vkey_hash);
+        write_bn254(&mut bytes, &witness.commited_values_digest);
+        debug_assert_eq!(bytes.len(), size);
+        bytes
+    }
+
     /// Saves the witness to a given path.
     pub fn save(&self, path: &str) {
         let serialized = serde_json::to_string(self).unwrap();
@@ -61,3 +100,59 @@ impl GnarkWitness {
         file.write_all(serialized.as_bytes()).unwrap();
     }
 }
+
+fn write_bn254<F: PrimeField>(bytes: &mut Vec<u8>, value: &F) {
+    let le = value.as_canonical_biguint().to_bytes_le();
+    assert!(le.len() <= BN254_ELEMENT_SIZE);
+    bytes.extend_from_slice(&le);
+    bytes.resize(bytes.len() + BN254_ELEMENT_SIZE - le.len(), 0);
+}
+
+fn write_felt<F: PrimeField>(bytes: &mut Vec<u8>, value: &F) {
+    let digits = value.as_canonical_biguint().to_u32_digits();
+    bytes.extend_from_slice(&digits.first().copied().unwrap_or(0).to_le_bytes());
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use p3_baby_bear::BabyBear;
+    use sp1_recursion_compiler::config::OuterConfig;
+
+    type N = <OuterConfig as Config>::N;
+    type EF = <OuterConfig as Config>::EF;
+
+    /// The witness of the fixtures that `go/sp1/witness_test.go` decodes.
+    fn fixture_witness() -> Witness<OuterConfig> {
+        Witness {
+            vars: vec![N::from_canonical_u64(1 << 40), N::neg_one()],
+            felts: vec![BabyBear::from_canonical_u32(7), BabyBear::neg_one()],
+            exts: vec![
+                EF::from_base_slice(&[1, 2, 3, 4].map(BabyBear::from_canonical_u32)),
+                EF::from_base_slice(&[
+                    BabyBear::neg_one(),
+                    BabyBear::zero(),
+                    BabyBear::from_canonical_u32(5),
+                    -BabyBear::two(),
+                ]),
+            ],
+            vkey_hash: N::from_canonical_u32(12345),
+            commited_values_digest: -N::two(),
+        }
+    }
+
+    #[test]
+    fn test_witness_fixtures() {
+        // If the layout changes, regenerate the fixtures and update `DecodeBinaryWitness`.
+        let binary = GnarkWitness::encode_binary(fixture_witness());
+        assert_eq!(
+            binary,
+            include_bytes!("../go/sp1/testdata/binary_witness.bin")
+        );
+
+        let json = serde_json::to_value(GnarkWitness::new(fixture_witness())).unwrap();
+        let fixture: serde_json::Value =
+            serde_json::from_str(include_str!("../go/sp1/testdata/json_witness.json")).unwrap();
+        assert_eq!(json, fixture);
+    }
+}